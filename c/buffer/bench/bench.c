@@ -0,0 +1,386 @@
+//==============================================================================
+//                                  bench.c
+//------------------------------------------------------------------------------
+// Brief
+//   Shared timing, CPU pinning and reporting helpers for the buffer
+//   benchmarks
+//
+// Contents
+//   - parseBenchOptions
+//   - benchNanoseconds
+//   - benchCycles
+//   - benchCyclesPerNanosecond
+//   - pinBenchThread
+//   - startBenchCounters
+//   - stopBenchCounters
+//   - addBenchCounters
+//   - beginBenchRow
+//   - addBenchText
+//   - addBenchNumber
+//   - endBenchRow
+//   - printBenchResult
+//   - printLatencyResult
+//   - addBenchField (private)
+//   - openBenchCounters (private)
+//   - compareSamples (private)
+//
+// Author
+//   Daniel Wilkinson-Thompson (daniel@wilkinson-thompson.com)
+//
+// Date
+//   2026-10-18
+//
+// Licence
+//   Copyright (c) 2026 Daniel Wilkinson-Thompson. All rights reserved.
+//------------------------------------------------------------------------------
+
+#ifndef BENCH_C
+#define BENCH_C
+
+//------------------------------------------------------------------------------
+// Headers
+//------------------------------------------------------------------------------
+#define _GNU_SOURCE
+#include "bench.h"
+#include <linux/perf_event.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+
+//------------------------------------------------------------------------------
+// Constants
+//------------------------------------------------------------------------------
+// Hardware counters, in the order they are reported
+#define BENCH_COUNTERS      6
+#define C_CYCLES            0
+#define C_INSTRUCTIONS      1
+#define C_BRANCH_MISSES     2
+#define C_L1D_MISSES        3
+#define C_LLC_MISSES        4
+#define C_DTLB_MISSES       5
+
+// Cache events are (cache | operation << 8 | result << 16)
+#define BENCH_CACHE_MISS(cache) \
+    ((cache) | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16))
+
+//------------------------------------------------------------------------------
+// Private variables
+//------------------------------------------------------------------------------
+// Output format, and the row being built
+static unsigned char benchJson = 0;
+static unsigned int benchFieldCount = 0;
+static const char *benchNames[BENCH_MAX_FIELDS];
+static char benchValues[BENCH_MAX_FIELDS][64];
+static unsigned char benchQuoted[BENCH_MAX_FIELDS];
+
+// Hardware counters: -1 for a counter that could not be opened, and the
+// values read at the end of the last case (negative if unavailable)
+static unsigned char benchCounting = 0;
+static unsigned char benchCountersOpen = 0;
+static int benchCounterFds[BENCH_COUNTERS];
+static double benchCounterValues[BENCH_COUNTERS];
+
+// Columns of the last CSV header printed
+static unsigned int benchHeaderCount = 0;
+static const char *benchHeader[BENCH_MAX_FIELDS];
+
+//------------------------------------------------------------------------------
+// Private function prototypes
+//------------------------------------------------------------------------------
+void addBenchField(const char *name, const char *value, unsigned char quoted);
+int compareSamples(const void *a, const void *b);
+void openBenchCounters(void);
+
+//------------------------------------------------------------------------------
+// Functions
+//------------------------------------------------------------------------------
+// Shared options
+int parseBenchOptions(int argc, char *argv[]) {
+    int in, out;
+
+    for (in = 1, out = 1; in < argc; in++) {
+        if ( !strcmp(argv[in], "--json") ) {
+            benchJson = 1;
+        }
+        else if ( !strcmp(argv[in], "--csv") ) {
+            benchJson = 0;
+        }
+        else if ( !strcmp(argv[in], "--counters") ) {
+            benchCounting = 1;
+        }
+        else {
+            argv[out++] = argv[in];
+        }
+    }
+    argv[out] = NULL;
+    return out;
+}
+
+// Monotonic clock in nanoseconds
+double benchNanoseconds(void) {
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return (double)t.tv_sec * 1e9 + (double)t.tv_nsec;
+}
+
+// Cycle counter
+unsigned long long benchCycles(void) {
+#if defined(__x86_64__) || defined(__i386__)
+    return __builtin_ia32_rdtsc();
+#else
+    return (unsigned long long)benchNanoseconds();
+#endif
+}
+
+// Cycle counter rate, measured over 20 ms on first use
+double benchCyclesPerNanosecond(void) {
+    static double rate = 0;
+    unsigned long long cycles;
+    double start;
+
+    if (rate == 0) {
+        start = benchNanoseconds();
+        cycles = benchCycles();
+        while (benchNanoseconds() - start < 20e6);
+        rate = (benchCycles() - cycles) / (benchNanoseconds() - start);
+    }
+    return rate;
+}
+
+// Pin to one CPU
+int pinBenchThread(int cpu) {
+    cpu_set_t set;
+
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    return pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+}
+
+// Open every counter for the calling thread and the threads it starts later
+// -Counts user space only, so it works with perf_event_paranoid up to 2
+void openBenchCounters(void) {
+    static const unsigned int types[BENCH_COUNTERS] = {
+        PERF_TYPE_HARDWARE, PERF_TYPE_HARDWARE, PERF_TYPE_HARDWARE,
+        PERF_TYPE_HW_CACHE, PERF_TYPE_HW_CACHE, PERF_TYPE_HW_CACHE
+    };
+    static const unsigned long long configs[BENCH_COUNTERS] = {
+        PERF_COUNT_HW_CPU_CYCLES, PERF_COUNT_HW_INSTRUCTIONS, PERF_COUNT_HW_BRANCH_MISSES,
+        BENCH_CACHE_MISS(PERF_COUNT_HW_CACHE_L1D), BENCH_CACHE_MISS(PERF_COUNT_HW_CACHE_LL),
+        BENCH_CACHE_MISS(PERF_COUNT_HW_CACHE_DTLB)
+    };
+    struct perf_event_attr attr;
+    unsigned int i, opened = 0;
+
+    for (i = 0; i < BENCH_COUNTERS; i++) {
+        memset(&attr, 0, sizeof(attr));
+        attr.size = sizeof(attr);
+        attr.type = types[i];
+        attr.config = configs[i];
+        attr.disabled = 1;
+        attr.inherit = 1;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+        benchCounterFds[i] = syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+        opened += (benchCounterFds[i] >= 0);
+    }
+    if (opened == 0) {
+        fprintf(stderr, "bench: no hardware counters available, check /proc/sys/kernel/perf_event_paranoid\n");
+    }
+    benchCountersOpen = 1;
+}
+
+// Reset and start counting
+void startBenchCounters(void) {
+    unsigned int i;
+
+    if ( !(benchCounting) ) {
+        return;
+    }
+    if ( !(benchCountersOpen) ) {
+        openBenchCounters();
+    }
+    for (i = 0; i < BENCH_COUNTERS; i++) {
+        if (benchCounterFds[i] >= 0) {
+            ioctl(benchCounterFds[i], PERF_EVENT_IOC_RESET, 0);
+            ioctl(benchCounterFds[i], PERF_EVENT_IOC_ENABLE, 0);
+        }
+    }
+}
+
+// Stop counting and read the values
+// -If the kernel had to multiplex counters, scale each one up to the whole
+//  time it was enabled
+void stopBenchCounters(void) {
+    unsigned long long values[3];
+    unsigned int i;
+
+    if ( !(benchCounting) ) {
+        return;
+    }
+    for (i = 0; i < BENCH_COUNTERS; i++) {
+        benchCounterValues[i] = -1;
+        if (benchCounterFds[i] < 0) {
+            continue;
+        }
+        ioctl(benchCounterFds[i], PERF_EVENT_IOC_DISABLE, 0);
+        if ( (read(benchCounterFds[i], values, sizeof(values)) == sizeof(values)) && (values[2] > 0) ) {
+            benchCounterValues[i] = (double)values[0] * values[1] / values[2];
+        }
+    }
+}
+
+// Per-element counters of the last case
+void addBenchCounters(unsigned long elements) {
+    static const char *names[BENCH_COUNTERS] = {
+        "cycles_per_element", "instructions_per_element", "branch_misses_per_element",
+        "l1d_misses_per_element", "llc_misses_per_element", "dtlb_misses_per_element"
+    };
+    unsigned int i;
+
+    if ( !(benchCounting) ) {
+        return;
+    }
+    for (i = 0; i < BENCH_COUNTERS; i++) {
+        if ( (benchCounterValues[i] < 0) || (elements == 0) ) {
+            addBenchField(names[i], benchJson ? "null" : "", 0);
+        }
+        else {
+            addBenchNumber(names[i], benchCounterValues[i] / elements);
+        }
+    }
+    if ( (benchCounterValues[C_CYCLES] > 0) && (benchCounterValues[C_INSTRUCTIONS] >= 0) ) {
+        addBenchNumber("ipc", benchCounterValues[C_INSTRUCTIONS] / benchCounterValues[C_CYCLES]);
+    }
+    else {
+        addBenchField("ipc", benchJson ? "null" : "", 0);
+    }
+}
+
+// Start a row
+void beginBenchRow(void) {
+    benchFieldCount = 0;
+}
+
+// Store one field of the row
+void addBenchField(const char *name, const char *value, unsigned char quoted) {
+    if (benchFieldCount < BENCH_MAX_FIELDS) {
+        benchNames[benchFieldCount] = name;
+        snprintf(benchValues[benchFieldCount], sizeof(benchValues[0]), "%s", value);
+        benchQuoted[benchFieldCount] = quoted;
+        benchFieldCount++;
+    }
+}
+
+// Text field
+void addBenchText(const char *name, const char *value) {
+    addBenchField(name, value, 1);
+}
+
+// Numeric field
+// -Whole numbers are printed without decimals
+// -NaN marks a missing value
+void addBenchNumber(const char *name, double value) {
+    char text[64];
+
+    if (value != value) {
+        addBenchField(name, benchJson ? "null" : "", 0);
+        return;
+    }
+    if ( (value == (double)(long long)value) && (value < 1e15) && (value > -1e15) ) {
+        snprintf(text, sizeof(text), "%.0f", value);
+    }
+    else {
+        snprintf(text, sizeof(text), "%.6g", value);
+    }
+    addBenchField(name, text, 0);
+}
+
+// Print the row
+void endBenchRow(void) {
+    unsigned int i;
+    unsigned char sameColumns;
+
+    if (benchJson) {
+        printf("{");
+        for (i = 0; i < benchFieldCount; i++) {
+            printf(benchQuoted[i] ? "%s\"%s\":\"%s\"" : "%s\"%s\":%s", i ? "," : "", benchNames[i], benchValues[i]);
+        }
+        printf("}\n");
+    }
+    else {
+        // Print a header whenever the columns differ from the last one
+        sameColumns = (benchHeaderCount == benchFieldCount);
+        for (i = 0; sameColumns && (i < benchFieldCount); i++) {
+            sameColumns = !strcmp(benchHeader[i], benchNames[i]);
+        }
+        if ( !sameColumns ) {
+            for (i = 0; i < benchFieldCount; i++) {
+                benchHeader[i] = benchNames[i];
+                printf("%s%s", i ? "," : "", benchNames[i]);
+            }
+            benchHeaderCount = benchFieldCount;
+            printf("\n");
+        }
+        for (i = 0; i < benchFieldCount; i++) {
+            printf("%s%s", i ? "," : "", benchValues[i]);
+        }
+        printf("\n");
+    }
+    fflush(stdout);
+}
+
+// Throughput row
+void printBenchResult(const char *benchmark, const char *variant, unsigned int parameter, unsigned long elements, double nanoseconds) {
+    beginBenchRow();
+    addBenchText("benchmark", benchmark);
+    addBenchText("variant", variant);
+    addBenchNumber("parameter", parameter);
+    addBenchNumber("elements", elements);
+    addBenchNumber("seconds", nanoseconds / 1e9);
+    addBenchNumber("elements_per_second", (double)(unsigned long long)(elements / (nanoseconds / 1e9)));
+    addBenchNumber("ns_per_element", nanoseconds / elements);
+    addBenchCounters(elements);
+    endBenchRow();
+}
+
+// Sort helper for latency samples
+int compareSamples(const void *a, const void *b) {
+    double x = *(const double*)a, y = *(const double*)b;
+    return (x > y) - (x < y);
+}
+
+// Latency row
+void printLatencyResult(const char *benchmark, const char *variant, unsigned int parameter, double *samples, unsigned long n) {
+    double sum = 0;
+    unsigned long i;
+
+    if (n == 0) {
+        return;
+    }
+    for (i = 0; i < n; i++) {
+        sum += samples[i];
+    }
+    qsort(samples, n, sizeof(double), compareSamples);
+
+    beginBenchRow();
+    addBenchText("benchmark", benchmark);
+    addBenchText("variant", variant);
+    addBenchNumber("parameter", parameter);
+    addBenchNumber("samples", n);
+    addBenchNumber("mean_ns", sum / n);
+    addBenchNumber("p50_ns", samples[n / 2]);
+    addBenchNumber("p99_ns", samples[(unsigned long)(n * 0.99)]);
+    addBenchNumber("p9999_ns", samples[(unsigned long)(n * 0.9999)]);
+    addBenchNumber("max_ns", samples[n - 1]);
+    addBenchCounters(n);
+    endBenchRow();
+}
+
+#endif
@@ -0,0 +1,129 @@
+//==============================================================================
+//                                  bench.h
+//------------------------------------------------------------------------------
+// Brief
+//   Shared timing, CPU pinning and reporting helpers for the buffer
+//   benchmarks
+//
+// Contents
+//   - parseBenchOptions
+//   - benchNanoseconds
+//   - benchCycles
+//   - benchCyclesPerNanosecond
+//   - pinBenchThread
+//   - startBenchCounters
+//   - stopBenchCounters
+//   - addBenchCounters
+//   - beginBenchRow
+//   - addBenchText
+//   - addBenchNumber
+//   - endBenchRow
+//   - printBenchResult
+//   - printLatencyResult
+//
+// Description
+//   Each benchmark program measures a set of cases and prints one row per
+//   case, either as CSV (with a header line whenever the columns change) or
+//   as one JSON object per line, e.g.:
+//      argc = parseBenchOptions(argc, argv);
+//      double start = benchNanoseconds();
+//      ...
+//      printBenchResult("mpsc", "mpscbuffer", 8, elements, benchNanoseconds() - start);
+//   Programs with their own columns build rows field by field:
+//      beginBenchRow();
+//      addBenchText("mode", "mpscbuffer");
+//      addBenchNumber("rtt_cycles", 212);
+//      endBenchRow();
+//   Options understood by every benchmark program
+//      --csv      print CSV (the default)
+//      --json     print JSON lines
+//      --counters collect hardware performance counters for each case
+//   Hardware counters
+//      With --counters, wrap each case in startBenchCounters() and
+//      stopBenchCounters(). Every result row then also gets cycles,
+//      instructions, branch misses, L1d, LLC and dTLB read misses per element,
+//      and instructions per cycle. Counters are opened with inherit set, so
+//      threads started after the first startBenchCounters() are counted once
+//      they have been joined. Counters the CPU or kernel refuses to provide
+//      are left empty (CSV) or null (JSON); check perf_event_paranoid if they
+//      are all missing
+//
+// Author
+//   Daniel Wilkinson-Thompson (daniel@wilkinson-thompson.com)
+//
+// Date
+//   2026-10-18
+//
+// Licence
+//   Copyright (c) 2026 Daniel Wilkinson-Thompson. All rights reserved.
+//------------------------------------------------------------------------------
+
+#ifndef BENCH_H
+#define BENCH_H
+
+//------------------------------------------------------------------------------
+// Constants
+//------------------------------------------------------------------------------
+// Most columns a single row can hold
+#define BENCH_MAX_FIELDS    32
+
+
+//------------------------------------------------------------------------------
+// Function prototypes
+//------------------------------------------------------------------------------
+
+// ------------------------- Parse the shared options -------------------------
+// -Removes the options listed above from argv and returns the new argc, so the
+//  program can parse whatever is left
+int parseBenchOptions(int argc, char *argv[]);
+
+// -------------------------- Read monotonic clock ----------------------------
+// -The return value is in nanoseconds from an arbitrary starting point
+double benchNanoseconds(void);
+
+// --------------------------- Read the cycle counter -------------------------
+// -Uses rdtsc on x86 and falls back to nanoseconds elsewhere
+// -Cheap enough to time single operations, but only comparable between CPUs
+//  with an invariant, synchronized TSC
+unsigned long long benchCycles(void);
+
+// ----------------------- Convert cycles to nanoseconds ----------------------
+// -Measured once against the monotonic clock on first use
+double benchCyclesPerNanosecond(void);
+
+// ---------------------- Pin calling thread to one CPU -----------------------
+// -A zero return implies success
+int pinBenchThread(int cpu);
+
+// ------------------------- Start counting a case ----------------------------
+// -Does nothing unless --counters was given
+void startBenchCounters(void);
+
+// -------------------------- Stop counting a case ----------------------------
+void stopBenchCounters(void);
+
+// ------------------- Add counters of the last case to a row -----------------
+// -Values are divided by elements, so they read as 'per element'
+// -Does nothing unless --counters was given
+void addBenchCounters(unsigned long elements);
+
+// ------------------------------ Build a result row --------------------------
+// -Fields are printed in the order they are added
+// -A NaN number is a missing value, printed empty (CSV) or null (JSON)
+void beginBenchRow(void);
+void addBenchText(const char *name, const char *value);
+void addBenchNumber(const char *name, double value);
+void endBenchRow(void);
+
+// ------------------------------ Print a result ------------------------------
+// -benchmark names the program, variant names the implementation measured and
+//  parameter is the value being swept (threads, element size, ...)
+// -Prints elements per second and nanoseconds per element
+void printBenchResult(const char *benchmark, const char *variant, unsigned int parameter, unsigned long elements, double nanoseconds);
+
+// -------------------------- Print a latency result --------------------------
+// -samples holds n per-operation times in nanoseconds and is sorted in place
+// -Prints the mean, median, 99th and 99.99th percentiles and the maximum
+void printLatencyResult(const char *benchmark, const char *variant, unsigned int parameter, double *samples, unsigned long n);
+
+#endif
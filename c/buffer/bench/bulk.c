@@ -0,0 +1,128 @@
+//==============================================================================
+//                                   bulk.c
+//------------------------------------------------------------------------------
+// Brief
+//   Compares creating and freeing many identical buffers one at a time with
+//   newBufferArray()/freeBufferArray()
+//
+// Description
+//   For 1,000 to 100,000 buffers of ints (16 each by default), times:
+//   -creating them all (newBuffer() in a loop, or one newBufferArray())
+//   -two sweeps pushing an element to every buffer in order, as a server does
+//    when a burst touches every connection. The first includes faulting in
+//    pages the allocator didn't touch yet; the second shows the locality of
+//    the headers and storage
+//   -freeing them all
+//   Build
+//      gcc -O2 -o bulk bulk.c bench.c ../buffer.c
+//   Run
+//      ./bulk [--csv|--json] [--counters] [elements per buffer]
+//
+// Author
+//   Daniel Wilkinson-Thompson (daniel@wilkinson-thompson.com)
+//
+// Date
+//   2026-10-18
+//
+// Licence
+//   Copyright (c) 2026 Daniel Wilkinson-Thompson. All rights reserved.
+//------------------------------------------------------------------------------
+
+//------------------------------------------------------------------------------
+// Headers
+//------------------------------------------------------------------------------
+#include "bench.h"
+#include "../buffer.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+//------------------------------------------------------------------------------
+// Functions
+//------------------------------------------------------------------------------
+// Print one row
+void printBulk(const char *variant, unsigned int count, double create, double sweep[2], double destroy) {
+    beginBenchRow();
+    addBenchText("benchmark", "bulk");
+    addBenchText("variant", variant);
+    addBenchNumber("buffers", count);
+    addBenchNumber("create_ns_per_buffer", create / count);
+    addBenchNumber("first_sweep_ns_per_buffer", sweep[0] / count);
+    addBenchNumber("sweep_ns_per_buffer", sweep[1] / count);
+    addBenchNumber("free_ns_per_buffer", destroy / count);
+    addBenchCounters(count);
+    endBenchRow();
+}
+
+int main(int argc, char *argv[]) {
+    static const unsigned int counts[] = {1000, 10000, 100000};
+    unsigned int c, i, n, pass, errors = 0;
+    double create, sweep[2], destroy;
+    buffer_t **handles, *bs;
+    int value = 1;
+
+    argc = parseBenchOptions(argc, argv);
+    n = (argc > 1) ? strtoul(argv[1], NULL, 0) : 16;
+
+    for (c = 0; c < sizeof(counts) / sizeof(counts[0]); c++) {
+
+        // One at a time
+        handles = malloc(counts[c] * sizeof(buffer_t*));
+        if ( !(handles) ) {
+            fprintf(stderr, "bulk: out of memory\n");
+            return 1;
+        }
+        startBenchCounters();
+        create = benchNanoseconds();
+        for (i = 0; i < counts[c]; i++) {
+            handles[i] = newBuffer(n, sizeof(int), B_FIFO & B_DROP);
+            if ( !(handles[i]) ) {
+                fprintf(stderr, "bulk: out of memory\n");
+                return 1;
+            }
+        }
+        create = benchNanoseconds() - create;
+        for (pass = 0; pass < 2; pass++) {
+            sweep[pass] = benchNanoseconds();
+            for (i = 0; i < counts[c]; i++) {
+                errors += pushToBuffer(handles[i], &value, 1);
+            }
+            sweep[pass] = benchNanoseconds() - sweep[pass];
+        }
+        destroy = benchNanoseconds();
+        for (i = 0; i < counts[c]; i++) {
+            freeBuffer(handles[i]);
+        }
+        destroy = benchNanoseconds() - destroy;
+        stopBenchCounters();
+        free(handles);
+        printBulk("newBuffer", counts[c], create, sweep, destroy);
+
+        // All at once
+        startBenchCounters();
+        create = benchNanoseconds();
+        bs = newBufferArray(counts[c], n, sizeof(int), B_FIFO & B_DROP);
+        if ( !(bs) ) {
+            fprintf(stderr, "bulk: out of memory\n");
+            return 1;
+        }
+        create = benchNanoseconds() - create;
+        for (pass = 0; pass < 2; pass++) {
+            sweep[pass] = benchNanoseconds();
+            for (i = 0; i < counts[c]; i++) {
+                errors += pushToBuffer(&bs[i], &value, 1);
+            }
+            sweep[pass] = benchNanoseconds() - sweep[pass];
+        }
+        destroy = benchNanoseconds();
+        freeBufferArray(bs);
+        destroy = benchNanoseconds() - destroy;
+        stopBenchCounters();
+        printBulk("newBufferArray", counts[c], create, sweep, destroy);
+    }
+
+    if (errors) {
+        fprintf(stderr, "bulk: %u pushes failed\n", errors);
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,232 @@
+//==============================================================================
+//                                  chunk.c
+//------------------------------------------------------------------------------
+// Brief
+//   Compares an unbounded chunk buffer with a buffer_t that doubles its
+//   storage when full, through a backlog spike
+//
+// Description
+//   A queue of 8-byte sequence numbers runs in three phases:
+//   -steady: one push and one pop at a time, with a standing backlog of
+//    base elements
+//   -outage: nothing is popped while spike times the base backlog is pushed
+//   -recovery: the backlog is popped down to base, then steady again
+//   The doubling buffer is a buffer_t replaced by one twice the size, with
+//   everything copied across, whenever a push finds it full: the usual way
+//   to grow a ring. The chunk buffer links on chunks instead, and after the
+//   recovery trims its pool down to 4 spare chunks.
+//   Every pop is checked against the sequence, and every operation timed
+//   with the cycle counter, so the row shows the worst single push or pop,
+//   and how many took over 100us, as well as the average. On a busy machine
+//   the worst can be a preemption rather than the queue. Memory is the
+//   storage held at the peak and at the end.
+//   Build
+//      gcc -O2 -o chunk chunk.c bench.c ../buffer.c ../chunkbuffer.c
+//   Run
+//      ./chunk [--csv|--json] [--counters] [base] [spike] [chunk]
+//
+// Author
+//   Daniel Wilkinson-Thompson (daniel@wilkinson-thompson.com)
+//
+// Date
+//   2026-10-18
+//
+// Licence
+//   Copyright (c) 2026 Daniel Wilkinson-Thompson. All rights reserved.
+//------------------------------------------------------------------------------
+
+//------------------------------------------------------------------------------
+// Headers
+//------------------------------------------------------------------------------
+#include "bench.h"
+#include "../buffer.h"
+#include "../chunkbuffer.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+//------------------------------------------------------------------------------
+// Constants
+//------------------------------------------------------------------------------
+#define STEADY_OPERATIONS   1000000UL
+#define SLOW_NANOSECONDS    100000
+
+//------------------------------------------------------------------------------
+// Type definitions
+//------------------------------------------------------------------------------
+// Either queue, with what a run has seen
+typedef struct {
+    buffer_t *b;
+    chunkpool_t *pool;
+    chunkbuffer_t *q;
+    unsigned long pushed;
+    unsigned long popped;
+    unsigned long wrong;
+    unsigned long long worst;
+    unsigned long long slow;
+    unsigned long slowOperations;
+    unsigned long peakBytes;
+} queue_t;
+
+//------------------------------------------------------------------------------
+// Functions
+//------------------------------------------------------------------------------
+// Storage the queue holds now
+unsigned long queueBytes(queue_t *q) {
+    if (q->q) {
+        return q->pool->chunks * (sizeof(bufferchunk_t) + (q->pool->elements + 1UL) * sizeof(unsigned long));
+    }
+    return (unsigned long)q->b->depth * sizeof(unsigned long);
+}
+
+// Replace the doubling buffer with one twice its size, copying its elements
+void growBuffer(queue_t *q) {
+    buffersegment_t s[2];
+    buffer_t *bigger;
+
+    bigger = newBuffer(2 * (q->b->depth - 1), sizeof(unsigned long), B_FIFO & B_DROP);
+    if ( !(bigger) ) {
+        fprintf(stderr, "chunk: out of memory\n");
+        exit(1);
+    }
+    peekBuffer(q->b, s);
+    pushToBuffer(bigger, s[0].data, s[0].count);
+    pushToBuffer(bigger, s[1].data, s[1].count);
+    freeBuffer(q->b);
+    q->b = bigger;
+}
+
+// Push the next number, timing it
+void pushOne(queue_t *q) {
+    unsigned long long start = benchCycles(), took;
+    unsigned long n = q->pushed;
+
+    if (q->q) {
+        pushToChunkBuffer(q->q, &n, 1);
+    }
+    else if (pushToBuffer(q->b, &n, 1)) {
+        growBuffer(q);
+        pushToBuffer(q->b, &n, 1);
+    }
+    took = benchCycles() - start;
+    q->worst = (took > q->worst) ? took : q->worst;
+    q->slowOperations += (took > q->slow);
+    q->pushed++;
+}
+
+// Pop a number, timing it and checking it is the next in sequence
+void popOne(queue_t *q) {
+    unsigned long long start = benchCycles(), took;
+    unsigned long n = ~0UL;
+
+    if (q->q) {
+        popFromChunkBuffer(q->q, &n, 1);
+    }
+    else {
+        popFromBuffer(q->b, &n, 1);
+    }
+    took = benchCycles() - start;
+    q->worst = (took > q->worst) ? took : q->worst;
+    q->slowOperations += (took > q->slow);
+    q->wrong += (n != q->popped);
+    q->popped++;
+}
+
+// Push and pop steadily
+void runSteady(queue_t *q) {
+    unsigned long i;
+
+    for (i = 0; i < STEADY_OPERATIONS; i++) {
+        pushOne(q);
+        popOne(q);
+    }
+}
+
+// Run every phase on one queue
+void runPhases(queue_t *q, unsigned long base, unsigned long spike, double *ns) {
+    unsigned long i;
+
+    for (i = 0; i < base; i++) {
+        pushOne(q);
+    }
+    q->worst = 0;
+    q->slowOperations = 0;
+    q->slow = SLOW_NANOSECONDS * benchCyclesPerNanosecond();
+
+    *ns = benchNanoseconds();
+    runSteady(q);
+    for (i = 0; i < base * spike; i++) {
+        pushOne(q);
+    }
+    q->peakBytes = queueBytes(q);
+    while (q->pushed - q->popped > base) {
+        popOne(q);
+    }
+    if (q->q) {
+        trimChunkPool(q->pool, 4);
+    }
+    runSteady(q);
+    *ns = benchNanoseconds() - *ns;
+}
+
+int main(int argc, char *argv[]) {
+    static const char *variants[] = {"doubling buffer_t", "chunkbuffer"};
+    unsigned long base, spike, chunk, operations;
+    unsigned int v, errors = 0;
+    queue_t q;
+    double ns;
+
+    argc = parseBenchOptions(argc, argv);
+    base = (argc > 1) ? strtoul(argv[1], NULL, 0) : 1000;
+    spike = (argc > 2) ? strtoul(argv[2], NULL, 0) : 1000;
+    chunk = (argc > 3) ? strtoul(argv[3], NULL, 0) : 4096;
+
+    for (v = 0; v < 2; v++) {
+        memset(&q, 0, sizeof(q));
+        if (v) {
+            q.pool = newChunkPool(chunk, sizeof(unsigned long));
+            q.q = q.pool ? newChunkBuffer(q.pool) : NULL;
+        }
+        else {
+            q.b = newBuffer(base + 1, sizeof(unsigned long), B_FIFO & B_DROP);
+        }
+        if ( !(q.b || q.q) ) {
+            fprintf(stderr, "chunk: out of memory\n");
+            return 1;
+        }
+
+        startBenchCounters();
+        runPhases(&q, base, spike, &ns);
+        stopBenchCounters();
+        operations = q.pushed + q.popped - base;
+        errors += (q.wrong != 0);
+
+        beginBenchRow();
+        addBenchText("benchmark", "chunk");
+        addBenchText("variant", variants[v]);
+        addBenchNumber("base", base);
+        addBenchNumber("spike", spike);
+        addBenchNumber("ns_per_operation", ns / operations);
+        addBenchNumber("worst_operation_us", q.worst / benchCyclesPerNanosecond() / 1e3);
+        addBenchNumber("operations_over_100us", q.slowOperations);
+        addBenchNumber("peak_mb", q.peakBytes / 1048576.0);
+        addBenchNumber("final_mb", queueBytes(&q) / 1048576.0);
+        addBenchText("order_kept", q.wrong ? "no" : "yes");
+        addBenchCounters(operations);
+        endBenchRow();
+
+        if (v) {
+            freeChunkBuffer(q.q);
+            freeChunkPool(q.pool);
+        }
+        else {
+            freeBuffer(q.b);
+        }
+    }
+
+    if (errors) {
+        fprintf(stderr, "chunk: %u variants popped out of order\n", errors);
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,245 @@
+//==============================================================================
+//                                 declare.c
+//------------------------------------------------------------------------------
+// Brief
+//   Compares pushes and pops on buffers from newBuffer(), from BUFFER_DECLARE
+//   with the generic functions, and from BUFFER_DECLARE with the inlined
+//   BUFFER_PUSH and BUFFER_POP
+//
+// Description
+//   For 4- and 16-byte elements and each behaviour (B_FIFO/B_STACK with
+//   B_DROP/B_OVERWRITE), on a buffer of 64 elements:
+//   -Differential test: a pseudo-random mix of single-element and short (2 to
+//    8 element) pushes and pops, which overfills and empties the buffer now
+//    and then, runs with BUFFER_PUSH/BUFFER_POP and with pushToBuffer()/
+//    popFromBuffer(). Every return value and popped byte must match
+//   -Speed: the same pushes and pops, one element each, repeated with every
+//    variant, which must also agree. The time is per operation
+//   The 'matches' column covers both.
+//   Build
+//      gcc -O2 -o declare declare.c bench.c ../buffer.c
+//   Run
+//      ./declare [--csv|--json] [--counters] [operations] [repetitions]
+//
+// Author
+//   Daniel Wilkinson-Thompson (daniel@wilkinson-thompson.com)
+//
+// Date
+//   2026-10-18
+//
+// Licence
+//   Copyright (c) 2026 Daniel Wilkinson-Thompson. All rights reserved.
+//------------------------------------------------------------------------------
+
+//------------------------------------------------------------------------------
+// Headers
+//------------------------------------------------------------------------------
+#include "bench.h"
+#include "../buffer.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+//------------------------------------------------------------------------------
+// Constants
+//------------------------------------------------------------------------------
+#define CAPACITY            64
+#define MOST                8
+
+//------------------------------------------------------------------------------
+// Type definitions
+//------------------------------------------------------------------------------
+// One pseudo-random operation: push (1) or pop (0) of length elements
+typedef struct {
+    unsigned char push;
+    unsigned char length;
+} operation_t;
+
+// What a run returned and popped
+typedef struct {
+    unsigned long failed;
+    unsigned long checksum;
+} result_t;
+
+//------------------------------------------------------------------------------
+// Functions
+//------------------------------------------------------------------------------
+// Fold popped bytes into a checksum
+void checkPopped(result_t *r, const unsigned char *out, unsigned int bytes) {
+    unsigned int i;
+
+    for (i = 0; i < bytes; i++) {
+        r->checksum = r->checksum * 31 + out[i];
+    }
+}
+
+// Run every operation on a buffer with the generic functions
+void runGeneric(buffer_t *b, const operation_t *ops, unsigned long n, unsigned int width, result_t *r) {
+    unsigned char in[MOST * 16], out[MOST * 16];
+    unsigned int left;
+    unsigned long i;
+
+    for (i = 0; i < n; i++) {
+        if (ops[i].push) {
+            memset(in, (unsigned char)i, ops[i].length * width);
+            r->failed += pushToBuffer(b, in, ops[i].length);
+        }
+        else {
+            left = popFromBuffer(b, out, ops[i].length);
+            r->failed += left;
+            checkPopped(r, out, (ops[i].length - left) * width);
+        }
+    }
+}
+
+// Run every operation on a declared buffer with BUFFER_PUSH and BUFFER_POP
+// -One function per element width, since the width is part of the declaration
+#define RUN_DECLARED(width) \
+void runDeclared##width(unsigned char config, const operation_t *ops, unsigned long n, result_t *r) { \
+    BUFFER_DECLARE_LOCAL(declared, CAPACITY, width, config); \
+    unsigned char in[MOST * width], out[MOST * width]; \
+    unsigned int left; \
+    unsigned long i; \
+    \
+    for (i = 0; i < n; i++) { \
+        if (ops[i].push) { \
+            memset(in, (unsigned char)i, ops[i].length * width); \
+            r->failed += BUFFER_PUSH(declared, in, ops[i].length); \
+        } \
+        else { \
+            left = BUFFER_POP(declared, out, ops[i].length); \
+            r->failed += left; \
+            checkPopped(r, out, (ops[i].length - left) * width); \
+        } \
+    } \
+}
+
+// Time single-element pushes and pops, in the order given, with each variant
+// -The element count is the literal 1, as it usually is in code that uses
+//  declared buffers
+#define TIME_LOOP(pushCall, popCall) \
+    for (rep = 0; rep < repetitions; rep++) { \
+        for (i = 0; i < n; i++) { \
+            if (push[i]) { \
+                in[0] = (unsigned char)i; \
+                *failed += pushCall; \
+            } \
+            else { \
+                *failed += popCall; \
+                *sum += out[0]; \
+            } \
+        } \
+    }
+
+#define TIME_DECLARED(width) \
+double timeDeclared##width(unsigned char config, unsigned int variant, const unsigned char *push, unsigned long n, \
+                           unsigned long repetitions, unsigned long *failed, unsigned long *sum) { \
+    BUFFER_DECLARE_LOCAL(declared, CAPACITY, width, config); \
+    unsigned char in[width] = {0}, out[width] = {0}; \
+    unsigned long i, rep; \
+    buffer_t *b; \
+    double ns; \
+    \
+    b = variant ? declared : newBuffer(CAPACITY, width, config); \
+    if ( !(b) ) { \
+        fprintf(stderr, "declare: out of memory\n"); \
+        exit(1); \
+    } \
+    ns = benchNanoseconds(); \
+    if (variant == 2) { \
+        TIME_LOOP(BUFFER_PUSH(declared, in, 1), BUFFER_POP(declared, out, 1)) \
+    } \
+    else { \
+        TIME_LOOP(pushToBuffer(b, in, 1), popFromBuffer(b, out, 1)) \
+    } \
+    ns = benchNanoseconds() - ns; \
+    if (variant == 0) { \
+        freeBuffer(b); \
+    } \
+    return ns; \
+}
+
+RUN_DECLARED(4)
+RUN_DECLARED(16)
+TIME_DECLARED(4)
+TIME_DECLARED(16)
+
+int main(int argc, char *argv[]) {
+    static const unsigned char configs[] = {B_FIFO & B_DROP, B_FIFO & B_OVERWRITE,
+                                            B_STACK & B_DROP, B_STACK & B_OVERWRITE};
+    static const char *configNames[] = {"fifo-drop", "fifo-overwrite", "stack-drop", "stack-overwrite"};
+    static const char *variants[] = {"newBuffer", "BUFFER_DECLARE", "BUFFER_PUSH/POP"};
+    static const unsigned int widths[] = {4, 16};
+    unsigned long n, repetitions, i, seed = 1, failed[3], sum[3];
+    unsigned int c, w, v, errors = 0;
+    unsigned char *push, matches;
+    result_t expected, r;
+    operation_t *ops;
+    buffer_t *b;
+    double ns;
+
+    argc = parseBenchOptions(argc, argv);
+    n = (argc > 1) ? strtoul(argv[1], NULL, 0) : 100000;
+    repetitions = (argc > 2) ? strtoul(argv[2], NULL, 0) : 100;
+
+    // Half single-element operations, half short runs; pushes a little more
+    // likely than pops, so the buffer fills as well as empties
+    ops = malloc(n * sizeof(operation_t));
+    push = malloc(n);
+    if ( !(ops) || !(push) ) {
+        fprintf(stderr, "declare: out of memory\n");
+        return 1;
+    }
+    for (i = 0; i < n; i++) {
+        seed = seed * 6364136223846793005UL + 1442695040888963407UL;
+        ops[i].push = ((seed >> 33) % 100) < 52;
+        ops[i].length = ((seed >> 40) & 1) ? 1 : 2 + (seed >> 41) % (MOST - 1);
+        push[i] = ops[i].push;
+    }
+
+    for (w = 0; w < 2; w++) {
+        for (c = 0; c < 4; c++) {
+
+            // Same results as the generic functions, for any lengths
+            expected = (result_t){0, 0};
+            r = (result_t){0, 0};
+            b = newBuffer(CAPACITY, widths[w], configs[c]);
+            if ( !(b) ) {
+                fprintf(stderr, "declare: out of memory\n");
+                return 1;
+            }
+            runGeneric(b, ops, n, widths[w], &expected);
+            freeBuffer(b);
+            (w ? runDeclared16 : runDeclared4)(configs[c], ops, n, &r);
+            matches = (r.failed == expected.failed) && (r.checksum == expected.checksum);
+
+            // Single-element speed
+            for (v = 0; v < 3; v++) {
+                failed[v] = 0;
+                sum[v] = 0;
+                startBenchCounters();
+                ns = (w ? timeDeclared16 : timeDeclared4)(configs[c], v, push, n, repetitions, &failed[v], &sum[v]);
+                stopBenchCounters();
+                matches &= (failed[v] == failed[0]) && (sum[v] == sum[0]);
+
+                beginBenchRow();
+                addBenchText("benchmark", "declare");
+                addBenchText("config", configNames[c]);
+                addBenchNumber("width", widths[w]);
+                addBenchText("variant", variants[v]);
+                addBenchNumber("ns_per_operation", ns / (n * repetitions));
+                addBenchText("matches", matches ? "yes" : "no");
+                addBenchCounters(n * repetitions);
+                endBenchRow();
+            }
+            errors += !(matches);
+        }
+    }
+    free(push);
+    free(ops);
+
+    if (errors) {
+        fprintf(stderr, "declare: %u cases differed from newBuffer()\n", errors);
+        return 1;
+    }
+    return 0;
+}
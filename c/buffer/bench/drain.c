@@ -0,0 +1,136 @@
+//==============================================================================
+//                                  drain.c
+//------------------------------------------------------------------------------
+// Brief
+//   Measures how fast a cold buffer of large elements drains, to show the
+//   effect of the prefetching in popFromBuffer()
+//
+// Description
+//   For element sizes of 64 to 255 bytes and pops of 1 to 256 elements at a
+//   time, a FIFO and a stack buffer of the given size are filled, the caches
+//   are flushed by writing a block of memory twice the size of the ring, and
+//   the buffer is then drained and timed. The prefetch distance is fixed when
+//   buffer.c is compiled, so build the program once per distance and compare:
+//   Build
+//      gcc -O2 -DB_PREFETCH_DISTANCE=0 -o drain-0 drain.c bench.c ../buffer.c
+//      gcc -O2 -DB_PREFETCH_DISTANCE=1024 -o drain-1024 drain.c bench.c ../buffer.c
+//   Run
+//      ./drain-0 [--csv|--json] [--counters] [ring megabytes]
+//
+// Author
+//   Daniel Wilkinson-Thompson (daniel@wilkinson-thompson.com)
+//
+// Date
+//   2026-10-18
+//
+// Licence
+//   Copyright (c) 2026 Daniel Wilkinson-Thompson. All rights reserved.
+//------------------------------------------------------------------------------
+
+//------------------------------------------------------------------------------
+// Headers
+//------------------------------------------------------------------------------
+#include "bench.h"
+#include "../buffer.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+//------------------------------------------------------------------------------
+// Functions
+//------------------------------------------------------------------------------
+// Fill b, flush the caches, then time popping everything l elements at a time
+// -The return value is nanoseconds, or a negative value if an element came out
+//  wrong
+double drainCold(buffer_t *b, unsigned int l, unsigned char *flush, unsigned long flushBytes, unsigned char *out) {
+    unsigned char element[255];
+    unsigned long i, pushed = 0, popped = 0, n;
+    double elapsed;
+    unsigned int failed;
+
+    // Start halfway round the ring, so drains cross the wrap
+    n = b->depth - 1;
+    memset(element, 0, sizeof(element));
+    for (i = 0; i < n / 2; i++) {
+        pushToBuffer(b, element, 1);
+    }
+    while ( !popFromBuffer(b, out, 1) );
+    for (i = 0; i < n; i++) {
+        memset(element, (unsigned char)i, b->width);
+        pushed += !pushToBuffer(b, element, 1);
+    }
+
+    // Twice through memory the size of two rings evicts the ring
+    memset(flush, 1, flushBytes);
+    memset(flush, 2, flushBytes);
+
+    startBenchCounters();
+    elapsed = benchNanoseconds();
+    do {
+        failed = popFromBuffer(b, out, l);
+        popped += l - failed;
+    } while (failed == 0);
+    elapsed = benchNanoseconds() - elapsed;
+    stopBenchCounters();
+
+    // Last batch: FIFO holds the newest elements, stack the oldest
+    i = b->behavior.bits.stack ? 0 : n - 1;
+    return ( (popped == pushed) && (out[(popped - 1) % l * b->width] == (unsigned char)i) ) ? elapsed : -1;
+}
+
+int main(int argc, char *argv[]) {
+    static const unsigned char widths[] = {64, 128, 192, 255};
+    static const unsigned int batches[] = {1, 16, 256};
+    static const unsigned char configs[] = {B_FIFO & B_DROP, B_STACK & B_DROP};
+    static const char *names[] = {"fifo", "stack"};
+    unsigned long ringBytes, n;
+    unsigned int w, l, c, errors = 0;
+    unsigned char *flush, *out;
+    buffer_t *b;
+    double elapsed;
+
+    argc = parseBenchOptions(argc, argv);
+    ringBytes = ((argc > 1) ? strtoul(argv[1], NULL, 0) : 32) << 20;
+
+    flush = malloc(2 * ringBytes);
+    out = malloc(256 * 255);
+    if ( !(flush) || !(out) ) {
+        fprintf(stderr, "drain: out of memory\n");
+        return 1;
+    }
+
+    for (c = 0; c < sizeof(configs); c++) {
+        for (w = 0; w < sizeof(widths); w++) {
+            for (l = 0; l < sizeof(batches) / sizeof(batches[0]); l++) {
+                n = ringBytes / widths[w];
+                b = newBuffer(n, widths[w], configs[c]);
+                if ( !(b) ) {
+                    fprintf(stderr, "drain: out of memory\n");
+                    return 1;
+                }
+                elapsed = drainCold(b, batches[l], flush, 2 * ringBytes, out);
+                errors += (elapsed < 0);
+                freeBuffer(b);
+
+                beginBenchRow();
+                addBenchText("benchmark", "drain");
+                addBenchText("variant", names[c]);
+                addBenchNumber("prefetch_distance", B_PREFETCH_DISTANCE);
+                addBenchNumber("width", widths[w]);
+                addBenchNumber("batch", batches[l]);
+                addBenchNumber("ns_per_element", elapsed / n);
+                addBenchNumber("gb_per_second", (double)n * widths[w] / elapsed);
+                addBenchCounters(n);
+                endBenchRow();
+            }
+        }
+    }
+
+    free(flush);
+    free(out);
+    if (errors) {
+        fprintf(stderr, "drain: %u cases popped the wrong elements\n", errors);
+        return 1;
+    }
+    return 0;
+}
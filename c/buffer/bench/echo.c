@@ -0,0 +1,447 @@
+//==============================================================================
+//                                   echo.c
+//------------------------------------------------------------------------------
+// Brief
+//   Loopback epoll echo and proxy server whose per-connection receive and
+//   send buffers are buffer_t rings, run as an end-to-end benchmark
+//
+// Description
+//   The server is one thread running an epoll loop over non-blocking
+//   sockets. Each socket's receive ring is filled by readToBuffer(), one
+//   readv() straight into the ring's free space, and each socket's send ring
+//   is flushed by writeFromBuffer(), one writev() straight from its contents,
+//   so bytes go socket -> ring -> socket without being copied in user space:
+//   -echo: a connection's receive ring is also its send ring, so whatever
+//    arrives is written back
+//   -proxy: each client connection is paired with a connection to the echo
+//    listener. What the client sends is written upstream from the client's
+//    receive ring, and the echo comes back through the upstream socket's
+//    receive ring
+//   A socket is only polled for reading while its receive ring has room, and
+//   for writing while its send ring has data, so a slow reader holds back its
+//   writer instead of growing memory. All rings come from a single
+//   newBufferArray() call.
+//   The client runs in the main thread with its own epoll loop. Each
+//   connection sends a message, waits for all of it to come back (checking
+//   every byte), records the round trip and sends the next. For every mode,
+//   number of connections and message size, throughput and round-trip
+//   percentiles are reported.
+//   Build
+//      gcc -O2 -pthread -o echo echo.c bench.c ../buffer.c ../bufferio.c
+//   Run
+//      ./echo [--csv|--json] [--counters] [seconds per case] [ring bytes]
+//
+// Author
+//   Daniel Wilkinson-Thompson (daniel@wilkinson-thompson.com)
+//
+// Date
+//   2026-10-18
+//
+// Licence
+//   Copyright (c) 2026 Daniel Wilkinson-Thompson. All rights reserved.
+//------------------------------------------------------------------------------
+
+//------------------------------------------------------------------------------
+// Headers
+//------------------------------------------------------------------------------
+#define _GNU_SOURCE
+#include "bench.h"
+#include "../buffer.h"
+#include "../bufferio.h"
+#include <arpa/inet.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <math.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <pthread.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+//------------------------------------------------------------------------------
+// Constants
+//------------------------------------------------------------------------------
+#define MAX_CONNECTIONS     256
+#define MAX_ENDPOINTS       (4 * MAX_CONNECTIONS)
+#define MAX_EVENTS          256
+#define MAX_MESSAGE         65536
+#define MAX_SAMPLES         (1 << 20)
+
+//------------------------------------------------------------------------------
+// Type definitions
+//------------------------------------------------------------------------------
+// One server socket
+// -rx is filled from fd, tx is flushed to fd. An echo endpoint has rx == tx;
+//  the two endpoints of a proxied connection are each other's peer and each
+//  one's tx is the other's rx
+// -listener is 0 for connections, else the mode of the listening socket
+typedef struct ENDPOINT {
+    int fd;
+    buffer_t *rx;
+    buffer_t *tx;
+    struct ENDPOINT *peer;
+    unsigned int events;
+    unsigned char listener;
+} endpoint_t;
+
+// One client connection
+typedef struct {
+    int fd;
+    unsigned long sent;
+    unsigned long received;
+    unsigned long long start;
+} client_t;
+
+//------------------------------------------------------------------------------
+// Private variables
+//------------------------------------------------------------------------------
+static endpoint_t endpoints[MAX_ENDPOINTS + 2];
+static endpoint_t *freeEndpoints[MAX_ENDPOINTS];
+static unsigned int freeCount;
+static int serverPoll;
+static volatile int stopping;
+
+//------------------------------------------------------------------------------
+// Functions
+//------------------------------------------------------------------------------
+// Print a system call failure and give up
+void failEcho(const char *what) {
+    fprintf(stderr, "echo: %s: %s\n", what, strerror(errno));
+    exit(1);
+}
+
+// The endpoint that sends what e receives: e itself, or its proxy peer
+endpoint_t* sinkOf(endpoint_t *e) {
+    return e->peer ? e->peer : e;
+}
+
+// Poll for reading while rx has room, for writing while tx has data
+void watchEndpoint(endpoint_t *e) {
+    buffersegment_t s[2];
+    unsigned int events;
+
+    events = (reserveInBuffer(e->rx, s) ? EPOLLIN : 0) | (isBufferEmpty(e->tx) ? 0 : EPOLLOUT);
+    if (events != e->events) {
+        struct epoll_event ev = { .events = events, .data.ptr = e };
+        epoll_ctl(serverPoll, EPOLL_CTL_MOD, e->fd, &ev);
+        e->events = events;
+    }
+}
+
+// Register a connected socket; returns NULL if no endpoint is free
+endpoint_t* openEndpoint(int fd, buffer_t *tx) {
+    struct epoll_event ev;
+    endpoint_t *e;
+    int one = 1;
+
+    if (freeCount == 0) {
+        close(fd);
+        return NULL;
+    }
+    e = freeEndpoints[--freeCount];
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    e->fd = fd;
+    e->tx = tx ? tx : e->rx;
+    e->peer = NULL;
+    e->events = EPOLLIN;
+    ev.events = EPOLLIN;
+    ev.data.ptr = e;
+    epoll_ctl(serverPoll, EPOLL_CTL_ADD, fd, &ev);
+    return e;
+}
+
+// Close an endpoint and its peer, emptying their rings
+void closeEndpoint(endpoint_t *e) {
+    endpoint_t *peer = e->peer;
+    buffersegment_t s[2];
+
+    close(e->fd);
+    discardFromBuffer(e->rx, peekBuffer(e->rx, s));
+    e->fd = -1;
+    e->peer = NULL;
+    freeEndpoints[freeCount++] = e;
+    if (peer) {
+        peer->peer = NULL;
+        closeEndpoint(peer);
+    }
+}
+
+// Open a listening socket on an ephemeral loopback port
+int listenEcho(unsigned short *port) {
+    struct sockaddr_in address;
+    socklen_t length = sizeof(address);
+    int fd;
+
+    memset(&address, 0, sizeof(address));
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    fd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK, 0);
+    if ( (fd < 0) || bind(fd, (struct sockaddr*)&address, sizeof(address)) || listen(fd, 4096) ||
+         getsockname(fd, (struct sockaddr*)&address, &length) ) {
+        failEcho("listen");
+    }
+    *port = ntohs(address.sin_port);
+    return fd;
+}
+
+// Connect to a loopback port; the socket is non-blocking once connected
+int connectEcho(unsigned short port) {
+    struct sockaddr_in address;
+    int fd, one = 1;
+
+    memset(&address, 0, sizeof(address));
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    address.sin_port = htons(port);
+    fd = socket(AF_INET, SOCK_STREAM, 0);
+    if ( (fd < 0) || connect(fd, (struct sockaddr*)&address, sizeof(address)) ) {
+        failEcho("connect");
+    }
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    fcntl(fd, F_SETFL, O_NONBLOCK);
+    return fd;
+}
+
+// Accept every pending connection on a listener
+void acceptEndpoints(endpoint_t *listener, unsigned short echoPort) {
+    endpoint_t *client, *upstream;
+    int fd;
+
+    while ( (fd = accept4(listener->fd, NULL, NULL, SOCK_NONBLOCK)) >= 0 ) {
+        client = openEndpoint(fd, NULL);
+        if ( !(client) || (listener->listener == 1) ) {
+            continue;
+        }
+
+        // Proxy: pair the client with a new connection to the echo listener,
+        // each sending what the other receives
+        upstream = openEndpoint(connectEcho(echoPort), client->rx);
+        if ( !(upstream) ) {
+            closeEndpoint(client);
+            continue;
+        }
+        client->tx = upstream->rx;
+        client->peer = upstream;
+        upstream->peer = client;
+    }
+}
+
+// Server thread: one epoll loop over every listener and connection
+void* runServer(void *arg) {
+    struct epoll_event events[MAX_EVENTS];
+    unsigned short echoPort = *(unsigned short*)arg;
+    endpoint_t *e;
+    int i, n;
+    long got;
+
+    while ( !(stopping) ) {
+        n = epoll_wait(serverPoll, events, MAX_EVENTS, 100);
+        for (i = 0; i < n; i++) {
+            e = events[i].data.ptr;
+            if (e->fd < 0) {
+                continue;
+            }
+            if (e->listener) {
+                acceptEndpoints(e, echoPort);
+                continue;
+            }
+
+            // Read what has arrived and pass it straight on
+            if (events[i].events & (EPOLLIN | EPOLLHUP | EPOLLERR)) {
+                got = readToBuffer(e->rx, e->fd);
+                if ( (got == 0) || ((got < 0) && (errno != EAGAIN) && (errno != ENOBUFS)) ||
+                     ((writeFromBuffer(sinkOf(e)->tx, sinkOf(e)->fd) < 0) && (errno != EAGAIN)) ) {
+                    closeEndpoint(e);
+                    continue;
+                }
+            }
+            if ( (events[i].events & EPOLLOUT) && (writeFromBuffer(e->tx, e->fd) < 0) && (errno != EAGAIN) ) {
+                closeEndpoint(e);
+                continue;
+            }
+            watchEndpoint(e);
+            if (e->peer) {
+                watchEndpoint(e->peer);
+            }
+        }
+    }
+    return NULL;
+}
+
+// qsort() order for round-trip times
+int compareRoundTrips(const void *a, const void *b) {
+    double x = *(const double*)a, y = *(const double*)b;
+    return (x > y) - (x < y);
+}
+
+// Send as much of the current message as the socket takes
+void sendMessage(client_t *c, const unsigned char *message, unsigned int size) {
+    long n;
+
+    while (c->sent < size) {
+        n = write(c->fd, message + c->sent, size - c->sent);
+        if (n <= 0) {
+            return;
+        }
+        c->sent += n;
+    }
+}
+
+// Run one case from the client side; returns the number of corrupted echoes
+unsigned long runClients(unsigned short port, unsigned int connections, unsigned int size, double seconds,
+                         double *samples, unsigned long *count, double *elapsed) {
+    static unsigned char message[MAX_CONNECTIONS][MAX_MESSAGE], in[MAX_MESSAGE];
+    static client_t clients[MAX_CONNECTIONS];
+    struct epoll_event events[MAX_EVENTS], ev;
+    unsigned long errors = 0;
+    unsigned int i, j;
+    double cyclesPerNanosecond = benchCyclesPerNanosecond(), start, end;
+    int poll, n, k;
+    long got;
+    client_t *c;
+
+    poll = epoll_create1(0);
+    if (poll < 0) {
+        failEcho("epoll_create1");
+    }
+
+    // Every connection's message is different, so crossed streams show up
+    for (i = 0; i < connections; i++) {
+        for (j = 0; j < size; j++) {
+            message[i][j] = i * 31 + j * 7 + (j >> 8);
+        }
+        clients[i].fd = connectEcho(port);
+        clients[i].sent = 0;
+        clients[i].received = 0;
+        ev.events = EPOLLIN;
+        ev.data.ptr = &clients[i];
+        epoll_ctl(poll, EPOLL_CTL_ADD, clients[i].fd, &ev);
+    }
+
+    *count = 0;
+    start = benchNanoseconds();
+    end = start + seconds * 1e9;
+    for (i = 0; i < connections; i++) {
+        clients[i].start = benchCycles();
+        sendMessage(&clients[i], message[i], size);
+    }
+    while (benchNanoseconds() < end) {
+        n = epoll_wait(poll, events, MAX_EVENTS, 100);
+        for (k = 0; k < n; k++) {
+            c = events[k].data.ptr;
+            i = c - clients;
+            while ( (got = read(c->fd, in, sizeof(in))) > 0 ) {
+                errors += (c->received + got > size) || memcmp(in, message[i] + c->received, got);
+                c->received += got;
+            }
+            sendMessage(c, message[i], size);
+
+            // Whole message back: record it and send the next
+            if (c->received >= size) {
+                if (*count < MAX_SAMPLES) {
+                    samples[*count] = (benchCycles() - c->start) / cyclesPerNanosecond;
+                }
+                (*count)++;
+                c->sent = 0;
+                c->received = 0;
+                c->start = benchCycles();
+                sendMessage(c, message[i], size);
+            }
+        }
+    }
+    *elapsed = benchNanoseconds() - start;
+
+    for (i = 0; i < connections; i++) {
+        close(clients[i].fd);
+    }
+    close(poll);
+    return errors;
+}
+
+int main(int argc, char *argv[]) {
+    static const unsigned int connectionCounts[] = {1, 16, 256};
+    static const unsigned int sizes[] = {64, 4096, 65536};
+    static const char *modes[] = {"echo", "proxy"};
+    struct epoll_event ev;
+    unsigned short ports[2];
+    unsigned long i, count, kept, errors = 0;
+    unsigned int ring, m, c, s;
+    double seconds, elapsed, *samples;
+    buffer_t *rings;
+    pthread_t server;
+
+    argc = parseBenchOptions(argc, argv);
+    seconds = (argc > 1) ? strtod(argv[1], NULL) : 1;
+    ring = (argc > 2) ? strtoul(argv[2], NULL, 0) : 65536;
+    signal(SIGPIPE, SIG_IGN);
+
+    // Every endpoint's receive ring, in one block
+    rings = newBufferArray(MAX_ENDPOINTS, ring, 1, B_FIFO & B_DROP);
+    samples = malloc(MAX_SAMPLES * sizeof(double));
+    if ( !(rings) || !(samples) ) {
+        fprintf(stderr, "echo: out of memory\n");
+        return 1;
+    }
+    for (i = 0; i < MAX_ENDPOINTS; i++) {
+        endpoints[i].fd = -1;
+        endpoints[i].rx = &rings[i];
+        freeEndpoints[freeCount++] = &endpoints[MAX_ENDPOINTS - 1 - i];
+    }
+
+    // Echo and proxy listeners
+    serverPoll = epoll_create1(0);
+    if (serverPoll < 0) {
+        failEcho("epoll_create1");
+    }
+    for (m = 0; m < 2; m++) {
+        endpoints[MAX_ENDPOINTS + m].fd = listenEcho(&ports[m]);
+        endpoints[MAX_ENDPOINTS + m].listener = m + 1;
+        ev.events = EPOLLIN;
+        ev.data.ptr = &endpoints[MAX_ENDPOINTS + m];
+        epoll_ctl(serverPoll, EPOLL_CTL_ADD, endpoints[MAX_ENDPOINTS + m].fd, &ev);
+    }
+    if ( pthread_create(&server, NULL, runServer, &ports[0]) ) {
+        failEcho("pthread_create");
+    }
+
+    for (m = 0; m < 2; m++) {
+        for (c = 0; c < sizeof(connectionCounts) / sizeof(connectionCounts[0]); c++) {
+            for (s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++) {
+                startBenchCounters();
+                errors += runClients(ports[m], connectionCounts[c], sizes[s], seconds, samples, &count, &elapsed);
+                stopBenchCounters();
+
+                kept = (count < MAX_SAMPLES) ? count : MAX_SAMPLES;
+                qsort(samples, kept, sizeof(double), compareRoundTrips);
+                beginBenchRow();
+                addBenchText("benchmark", "echo");
+                addBenchText("variant", modes[m]);
+                addBenchNumber("connections", connectionCounts[c]);
+                addBenchNumber("message_bytes", sizes[s]);
+                addBenchNumber("ring_bytes", ring);
+                addBenchNumber("messages_per_second", count / elapsed * 1e9);
+                addBenchNumber("mb_per_second", (double)count * sizes[s] / elapsed * 1e3);
+                addBenchNumber("rtt_p50_ns", kept ? samples[kept / 2] : NAN);
+                addBenchNumber("rtt_p99_ns", kept ? samples[kept * 99 / 100] : NAN);
+                addBenchNumber("rtt_max_ns", kept ? samples[kept - 1] : NAN);
+                addBenchCounters(count);
+                endBenchRow();
+            }
+        }
+    }
+
+    stopping = 1;
+    pthread_join(server, NULL);
+    freeBufferArray(rings);
+    free(samples);
+    if (errors) {
+        fprintf(stderr, "echo: %lu echoes came back wrong\n", errors);
+        return 1;
+    }
+    return 0;
+}
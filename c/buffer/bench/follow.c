@@ -0,0 +1,346 @@
+//==============================================================================
+//                                  follow.c
+//------------------------------------------------------------------------------
+// Brief
+//   Compares following many log files with a follower (inotify and preadv()
+//   into each file's buffer) against checking every file each time round
+//   (fstat() and read() into an array, then pushToBuffer())
+//
+// Description
+//   A set of files is appended to a few at a time, as a busy host's logs are:
+//   each round writes one 32-byte record to each of a handful of randomly
+//   chosen files, then the follower catches up and every buffer that got
+//   bytes is popped and checked. Every so often one file is rotated by
+//   renaming it and creating a new one, and another is truncated in place,
+//   so both are followed as well. Every record of every file must arrive
+//   exactly once and in order.
+//   The checking loop is how a polling tail -F works: it looks at every file
+//   each round, whether it grew or not, so its cost grows with the number of
+//   files rather than with the number that changed.
+//   Build
+//      gcc -O2 -o follow follow.c bench.c ../buffer.c ../bufferio.c ../bufferfollow.c
+//   Run
+//      ./follow [--csv|--json] [--counters] [files] [rounds] [directory]
+//   The directory (default follow.d in the current directory) is created,
+//   and removed with its files afterwards
+//
+// Author
+//   Daniel Wilkinson-Thompson (daniel@wilkinson-thompson.com)
+//
+// Date
+//   2026-10-18
+//
+// Licence
+//   Copyright (c) 2026 Daniel Wilkinson-Thompson. All rights reserved.
+//------------------------------------------------------------------------------
+
+//------------------------------------------------------------------------------
+// Headers
+//------------------------------------------------------------------------------
+#include "bench.h"
+#include "../buffer.h"
+#include "../bufferfollow.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/resource.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+//------------------------------------------------------------------------------
+// Constants
+//------------------------------------------------------------------------------
+#define RECORD_BYTES        32
+#define RING_BYTES          4096
+#define WRITES_PER_ROUND    4
+#define ROTATE_EVERY        256
+#define MAX_FILES           16384
+
+//------------------------------------------------------------------------------
+// Type definitions
+//------------------------------------------------------------------------------
+// One log file as its writer and its reader see it
+// -For the checking loop, fd, offset, inode and device are its own state
+typedef struct {
+    char path[256];
+    int out;
+    unsigned long written;
+    unsigned long read;
+    unsigned long wrong;
+    int fd;
+    unsigned long long offset;
+    unsigned long long inode;
+    unsigned long long device;
+} log_t;
+
+//------------------------------------------------------------------------------
+// Variables
+//------------------------------------------------------------------------------
+log_t logs[MAX_FILES];
+unsigned int fileCount;
+
+//------------------------------------------------------------------------------
+// Functions
+//------------------------------------------------------------------------------
+// Append the next record to a log
+void writeRecord(log_t *l) {
+    char record[RECORD_BYTES + 1];
+
+    snprintf(record, sizeof(record), "%010u %019lu\n", (unsigned int)(l - logs), l->written);
+    if (write(l->out, record, RECORD_BYTES) != RECORD_BYTES) {
+        fprintf(stderr, "follow: can't write %s: %s\n", l->path, strerror(errno));
+        exit(1);
+    }
+    l->written++;
+}
+
+// Pop and check every whole record in a log's buffer
+void popRecords(log_t *l, buffer_t *b) {
+    char record[RECORD_BYTES], expected[RECORD_BYTES + 1];
+    buffersegment_t s[2];
+
+    while (peekBuffer(b, s) >= RECORD_BYTES) {
+        popFromBuffer(b, record, RECORD_BYTES);
+        snprintf(expected, sizeof(expected), "%010u %019lu\n", (unsigned int)(l - logs), l->read);
+        l->wrong += (memcmp(record, expected, RECORD_BYTES) != 0);
+        l->read++;
+    }
+}
+
+// Rotate a log by renaming it and creating a new one
+void rotateLog(log_t *l) {
+    char old[sizeof(l->path) + 4];
+
+    snprintf(old, sizeof(old), "%s.1", l->path);
+    close(l->out);
+    rename(l->path, old);
+    l->out = open(l->path, O_WRONLY | O_CREAT | O_APPEND, 0600);
+}
+
+// Open a log for the checking loop, if one is there
+void openCheckedLog(log_t *l) {
+    struct stat st;
+
+    l->fd = open(l->path, O_RDONLY);
+    l->offset = 0;
+    if ( (l->fd >= 0) && !(fstat(l->fd, &st)) ) {
+        l->inode = st.st_ino;
+        l->device = st.st_dev;
+    }
+}
+
+// Check every log once, reading what is new into its buffer, and pop them
+void checkLogs(buffer_t *rings) {
+    static char data[RING_BYTES];
+    struct stat st;
+    unsigned int i;
+    buffer_t *b;
+    long n;
+    log_t *l;
+
+    for (i = 0; i < fileCount; i++) {
+        l = &(logs[i]);
+        b = &(rings[i]);
+        if ( !(fstat(l->fd, &st)) && ((unsigned long long)st.st_size < l->offset) ) {
+            l->offset = 0;
+            lseek(l->fd, 0, SEEK_SET);
+        }
+        if ((unsigned long long)st.st_size > l->offset) {
+            n = read(l->fd, data, RING_BYTES - 1 - RECORD_BYTES);
+            if (n > 0) {
+                pushToBuffer(b, data, n);
+                l->offset += n;
+            }
+        }
+        else if ( !(stat(l->path, &st)) && ((st.st_ino != l->inode) || (st.st_dev != l->device)) ) {
+            close(l->fd);
+            openCheckedLog(l);
+        }
+        popRecords(l, b);
+    }
+}
+
+// Catch the follower up and pop every buffer that got bytes
+unsigned int followLogs(follower_t *f, followedfile_t **ready) {
+    unsigned int i, n;
+
+    n = pollFollower(f, 0, ready, fileCount);
+    for (i = 0; i < n; i++) {
+        popRecords(ready[i]->context, ready[i]->b);
+    }
+    return n;
+}
+
+// Run one way of following the logs
+// -The return value is the number of logs with missing, extra or wrong
+//  records
+unsigned int runFollow(unsigned char follow, unsigned long rounds, const char *directory, double *ns) {
+    followedfile_t **files = NULL, **ready = NULL;
+    follower_t *f = NULL;
+    unsigned long r, seed = 12345, rotations = 0;
+    unsigned int i, j, wrong = 0;
+    buffer_t *rings;
+    log_t *l;
+
+    rings = newBufferArray(fileCount, RING_BYTES, 1, B_FIFO & B_DROP);
+    if (follow) {
+        f = newFollower();
+        files = malloc(fileCount * sizeof(followedfile_t*));
+        ready = malloc(fileCount * sizeof(followedfile_t*));
+    }
+    if ( !(rings) || (follow && !(f && files && ready)) ) {
+        fprintf(stderr, "follow: out of memory\n");
+        exit(1);
+    }
+    for (i = 0; i < fileCount; i++) {
+        l = &(logs[i]);
+        snprintf(l->path, sizeof(l->path), "%s/%u.log", directory, i);
+        l->out = open(l->path, O_WRONLY | O_CREAT | O_TRUNC | O_APPEND, 0600);
+        if (l->out < 0) {
+            fprintf(stderr, "follow: can't create %s: %s\n", l->path, strerror(errno));
+            exit(1);
+        }
+        l->written = 0;
+        l->read = 0;
+        l->wrong = 0;
+        if (follow) {
+            files[i] = followFile(f, l->path, &(rings[i]), 0);
+            if ( !(files[i]) ) {
+                fprintf(stderr, "follow: can't follow %s: %s\n", l->path, strerror(errno));
+                exit(1);
+            }
+            files[i]->context = l;
+        }
+        else {
+            openCheckedLog(l);
+        }
+    }
+
+    *ns = benchNanoseconds();
+    for (r = 1; r <= rounds; r++) {
+        for (j = 0; j < WRITES_PER_ROUND; j++) {
+            seed = seed * 6364136223846793005UL + 1442695040888963407UL;
+            writeRecord(&(logs[(seed >> 33) % fileCount]));
+        }
+
+        // Rotate one log; truncate another once it has been read up to date,
+        // as copytruncate would after copying it
+        if (r % ROTATE_EVERY == 0) {
+            rotateLog(&(logs[rotations++ % fileCount]));
+            l = &(logs[(rotations * 7919) % fileCount]);
+            while ( (l->read < l->written) && (follow ? (followLogs(f, ready) > 0) : 1) ) {
+                if ( !(follow) ) {
+                    checkLogs(rings);
+                }
+            }
+            ftruncate(l->out, 0);
+        }
+
+        if (follow) {
+            followLogs(f, ready);
+        }
+        else {
+            checkLogs(rings);
+        }
+    }
+
+    // Drain what is left
+    for (i = 0; i < 4; i++) {
+        if (follow) {
+            while (followLogs(f, ready));
+        }
+        else {
+            checkLogs(rings);
+        }
+    }
+    *ns = benchNanoseconds() - *ns;
+
+    for (i = 0; i < fileCount; i++) {
+        l = &(logs[i]);
+        wrong += ( (l->read != l->written) || l->wrong );
+        if (follow) {
+            unfollowFile(f, files[i]);
+        }
+        else {
+            close(l->fd);
+        }
+        close(l->out);
+    }
+    if (follow) {
+        freeFollower(f);
+        free(files);
+        free(ready);
+    }
+    freeBufferArray(rings);
+    return wrong;
+}
+
+// Remove the logs and the directory
+void removeLogs(const char *directory) {
+    char old[sizeof(logs[0].path) + 4];
+    unsigned int i;
+
+    for (i = 0; i < fileCount; i++) {
+        snprintf(old, sizeof(old), "%s.1", logs[i].path);
+        unlink(logs[i].path);
+        unlink(old);
+    }
+    rmdir(directory);
+}
+
+int main(int argc, char *argv[]) {
+    static const char *variants[] = {"fstat+read+pushToBuffer", "inotify+preadToBuffer"};
+    unsigned long rounds, records;
+    unsigned int v, wrong, errors = 0;
+    const char *directory;
+    struct rlimit files;
+    double ns;
+
+    argc = parseBenchOptions(argc, argv);
+    fileCount = (argc > 1) ? strtoul(argv[1], NULL, 0) : 1000;
+    rounds = (argc > 2) ? strtoul(argv[2], NULL, 0) : 20000;
+    directory = (argc > 3) ? argv[3] : "follow.d";
+    if ( (fileCount == 0) || (fileCount > MAX_FILES) ) {
+        fprintf(stderr, "follow: files must be 1 to %u\n", MAX_FILES);
+        return 1;
+    }
+
+    // Two descriptors per log, one to write and one to read
+    getrlimit(RLIMIT_NOFILE, &files);
+    files.rlim_cur = files.rlim_max;
+    setrlimit(RLIMIT_NOFILE, &files);
+    if ( mkdir(directory, 0700) && (errno != EEXIST) ) {
+        fprintf(stderr, "follow: can't create %s: %s\n", directory, strerror(errno));
+        return 1;
+    }
+
+    for (v = 0; v < 2; v++) {
+        startBenchCounters();
+        wrong = runFollow(v, rounds, directory, &ns);
+        stopBenchCounters();
+        removeLogs(directory);
+        mkdir(directory, 0700);
+        errors += (wrong != 0);
+
+        records = rounds * WRITES_PER_ROUND;
+        beginBenchRow();
+        addBenchText("benchmark", "follow");
+        addBenchText("variant", variants[v]);
+        addBenchNumber("files", fileCount);
+        addBenchNumber("records", records);
+        addBenchNumber("ns_per_record", ns / records);
+        addBenchNumber("ns_per_round", ns / rounds);
+        addBenchText("records_match", wrong ? "no" : "yes");
+        addBenchCounters(records);
+        endBenchRow();
+    }
+    rmdir(directory);
+
+    if (errors) {
+        fprintf(stderr, "follow: %u variants lost or mangled records\n", errors);
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,138 @@
+//==============================================================================
+//                                footprint.c
+//------------------------------------------------------------------------------
+// Brief
+//   Reports the memory used per stored element by buffer_t at various
+//   capacities and element sizes
+//
+// Description
+//   For each capacity and element size, prints bufferMemoryUsage() for a
+//   buffer from newBuffer() ('heap') and for the same buffer declared with
+//   BUFFER_DECLARE ('declared'), the payload it can hold, and the overhead per
+//   element on top of the payload. Where the elements fit in a tinybuffer_t,
+//   it is reported too ('tiny'), as embedded in an array or struct.
+//   With glibc, the heap figure is checked by allocating many buffers and
+//   reading the allocator's own count of bytes in use (mallinfo2), printed as
+//   measured_bytes. Freed blocks the allocator caches per thread still count as
+//   in use, so reusing them makes measured_bytes read a fraction of a byte low.
+//   If it differs by a byte or more, the B_MALLOC_* constants in buffer.h
+//   don't match the allocator.
+//   Build
+//      gcc -O2 -o footprint footprint.c bench.c ../buffer.c ../tinybuffer.c
+//   Run
+//      ./footprint [--csv|--json] [buffers measured per case]
+//
+// Author
+//   Daniel Wilkinson-Thompson (daniel@wilkinson-thompson.com)
+//
+// Date
+//   2026-10-18
+//
+// Licence
+//   Copyright (c) 2026 Daniel Wilkinson-Thompson. All rights reserved.
+//------------------------------------------------------------------------------
+
+//------------------------------------------------------------------------------
+// Headers
+//------------------------------------------------------------------------------
+#include "bench.h"
+#include "../buffer.h"
+#include "../tinybuffer.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#if defined(__GLIBC__) && ((__GLIBC__ > 2) || (__GLIBC_MINOR__ >= 33))
+#include <malloc.h>
+#define MEASURE_HEAP
+#endif
+
+//------------------------------------------------------------------------------
+// Functions
+//------------------------------------------------------------------------------
+// Average bytes the allocator hands out per buffer, or a negative value if
+// the allocator can't say
+double measureHeapBuffer(unsigned int n, unsigned char width, unsigned int count) {
+#ifdef MEASURE_HEAP
+    buffer_t **buffers;
+    size_t before;
+    unsigned int i;
+    double bytes;
+
+    buffers = malloc(count * sizeof(buffer_t*));
+    if ( !(buffers) ) {
+        fprintf(stderr, "footprint: out of memory\n");
+        exit(1);
+    }
+    before = mallinfo2().uordblks + mallinfo2().hblkhd;
+    for (i = 0; i < count; i++) {
+        buffers[i] = newBuffer(n, width, B_FIFO & B_DROP);
+        if ( !(buffers[i]) ) {
+            fprintf(stderr, "footprint: out of memory\n");
+            exit(1);
+        }
+    }
+    bytes = (double)(mallinfo2().uordblks + mallinfo2().hblkhd - before) / count;
+    for (i = 0; i < count; i++) {
+        freeBuffer(buffers[i]);
+    }
+    free(buffers);
+    return bytes;
+#else
+    return -1;
+#endif
+}
+
+// Print one row
+void printFootprint(const char *variant, unsigned int n, unsigned char width, unsigned long bytes, double measured) {
+    unsigned long payload = (unsigned long)n * width;
+
+    beginBenchRow();
+    addBenchText("benchmark", "footprint");
+    addBenchText("variant", variant);
+    addBenchNumber("elements", n);
+    addBenchNumber("width", width);
+    addBenchNumber("payload_bytes", payload);
+    addBenchNumber("bytes", bytes);
+    addBenchNumber("bytes_per_element", (double)bytes / n);
+    addBenchNumber("overhead_per_element", (double)(bytes - payload) / n);
+    addBenchNumber("measured_bytes", (measured >= 0) ? measured : NAN);
+    endBenchRow();
+}
+
+int main(int argc, char *argv[]) {
+    static const unsigned int capacities[] = {1, 2, 4, 8, 16, 32, 64, 256, 1024, 4096};
+    static const unsigned char widths[] = {1, 2, 4, 8, 16, 64};
+    unsigned int count, c, w, mismatches = 0;
+    buffer_t *b, declared;
+    double measured;
+
+    argc = parseBenchOptions(argc, argv);
+    count = (argc > 1) ? strtoul(argv[1], NULL, 0) : 1024;
+
+    for (w = 0; w < sizeof(widths); w++) {
+        for (c = 0; c < sizeof(capacities) / sizeof(capacities[0]); c++) {
+            b = newBuffer(capacities[c], widths[w], B_FIFO & B_DROP);
+            if ( !(b) ) {
+                fprintf(stderr, "footprint: out of memory\n");
+                return 1;
+            }
+            measured = measureHeapBuffer(capacities[c], widths[w], count);
+            mismatches += (measured >= 0) && (fabs(measured - bufferMemoryUsage(b)) >= 1);
+            printFootprint("heap", capacities[c], widths[w], bufferMemoryUsage(b), measured);
+            freeBuffer(b);
+
+            // Same header BUFFER_DECLARE would produce, without the storage
+            declared = (buffer_t){ .depth = capacities[c] + 1, .width = widths[w], .behavior = { .byte = (B_FIFO & B_DROP) & 0xFE } };
+            printFootprint("declared", capacities[c], widths[w], bufferMemoryUsage(&declared), -1);
+
+            if (capacities[c] <= TINY_BUFFER_CAPACITY(widths[w])) {
+                printFootprint("tiny", capacities[c], widths[w], sizeof(tinybuffer_t), -1);
+            }
+        }
+    }
+
+    if (mismatches) {
+        fprintf(stderr, "footprint: %u cases where the allocator disagrees with bufferMemoryUsage()\n", mismatches);
+    }
+    return 0;
+}
@@ -0,0 +1,410 @@
+//==============================================================================
+//                                 framing.c
+//------------------------------------------------------------------------------
+// Brief
+//   Compares decoding framed byte streams one popped byte at a time with
+//   decodeFrame(), and encoding through a temporary array with
+//   encodeFrame(), and checks that all of them agree
+//
+// Description
+//   For each format (2-byte big-endian length, COBS, SLIP and '\n'-delimited
+//   lines), a stream of random frames with 1 to 255 payload bytes, rich in
+//   the bytes each format has to stuff or escape, is encoded up front. The
+//   stream is then fed into a 64 KiB buffer of bytes in TCP-segment-sized
+//   chunks, and after each chunk every whole frame is taken out:
+//   -bytewise: popFromBuffer() one byte at a time into a state machine, which
+//    collects each frame in an array, as receive loops usually do
+//   -decodeFrame: frames found and decoded in place with bufferframing.c
+//   Each variant hashes every payload; the run fails if either hash differs
+//   from the hash of the frames that were encoded.
+//   The same payloads are then encoded into a 64 KiB buffer, which is
+//   flushed (compared with the stream and discarded) whenever the next frame
+//   doesn't fit:
+//   -array+push: encoded into a temporary array, then pushToBuffer()
+//   -encodeFrame: encoded straight into the buffer's free space
+//   The run fails unless both produce the stream byte for byte.
+//   Build
+//      gcc -O2 -o framing framing.c bench.c ../buffer.c ../bufferframing.c
+//   Run
+//      ./framing [--csv|--json] [--counters] [frames] [chunk bytes]
+//
+// Author
+//   Daniel Wilkinson-Thompson (daniel@wilkinson-thompson.com)
+//
+// Date
+//   2026-10-18
+//
+// Licence
+//   Copyright (c) 2026 Daniel Wilkinson-Thompson. All rights reserved.
+//------------------------------------------------------------------------------
+
+//------------------------------------------------------------------------------
+// Headers
+//------------------------------------------------------------------------------
+#include "bench.h"
+#include "../buffer.h"
+#include "../bufferframing.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+//------------------------------------------------------------------------------
+// Constants
+//------------------------------------------------------------------------------
+#define FRAMING_RING        65536
+#define FRAMING_MAX_PAYLOAD 255
+#define FRAMING_MAX_WIRE    (2 * FRAMING_MAX_PAYLOAD + 2)
+
+//------------------------------------------------------------------------------
+// Type definitions
+//------------------------------------------------------------------------------
+// Byte-at-a-time decoder state
+typedef struct {
+    unsigned char frame[FRAMING_MAX_WIRE];
+    unsigned int n;
+    unsigned int need;
+    unsigned char state;
+} bytewise_t;
+
+//------------------------------------------------------------------------------
+// Private variables
+//------------------------------------------------------------------------------
+static unsigned long long seed = 0x9E3779B97F4A7C15ULL;
+
+//------------------------------------------------------------------------------
+// Functions
+//------------------------------------------------------------------------------
+// xorshift64* random numbers
+unsigned long long randomNumber(void) {
+    seed ^= seed >> 12;
+    seed ^= seed << 25;
+    seed ^= seed >> 27;
+    return seed * 0x2545F4914F6CDD1DULL;
+}
+
+// FNV-1a over a payload and its length
+unsigned long long hashFrame(unsigned long long hash, const unsigned char *data, unsigned int length) {
+    unsigned int i;
+
+    hash = (hash ^ length) * 0x100000001B3ULL;
+    for (i = 0; i < length; i++) {
+        hash = (hash ^ data[i]) * 0x100000001B3ULL;
+    }
+    return hash;
+}
+
+// Encode one frame onto the end of the stream; returns its size on the wire
+unsigned int encodeTestFrame(unsigned char format, const unsigned char *payload, unsigned int length, unsigned char *out) {
+    unsigned int i, o = 0, code = 0;
+
+    if (format == B_FRAME_LENGTH_BE) {
+        out[o++] = length >> 8;
+        out[o++] = length;
+        memcpy(out + o, payload, length);
+        return o + length;
+    }
+    if (format == B_FRAME_COBS) {
+        o = 1;
+        for (i = 0; i < length; i++) {
+            if (payload[i] == 0) {
+                out[code] = o - code;
+                code = o++;
+                continue;
+            }
+            out[o++] = payload[i];
+            if (o - code == 0xFF) {
+                out[code] = 0xFF;
+                code = o++;
+            }
+        }
+        out[code] = o - code;
+        out[o++] = 0;
+        return o;
+    }
+    if (format == B_FRAME_SLIP) {
+        for (i = 0; i < length; i++) {
+            if (payload[i] == B_SLIP_END) {
+                out[o++] = B_SLIP_ESC;
+                out[o++] = B_SLIP_ESC_END;
+            }
+            else if (payload[i] == B_SLIP_ESC) {
+                out[o++] = B_SLIP_ESC;
+                out[o++] = B_SLIP_ESC_ESC;
+            }
+            else {
+                out[o++] = payload[i];
+            }
+        }
+        out[o++] = B_SLIP_END;
+        return o;
+    }
+    memcpy(out, payload, length);
+    out[length] = '\n';
+    return length + 1;
+}
+
+// Build the stream; returns its length and sets the hash of its payloads
+// -Payload i is kept at payloads + i * FRAMING_MAX_PAYLOAD
+unsigned long buildStream(unsigned char format, unsigned long frames, unsigned char *stream, unsigned char *payloads,
+                          unsigned int *lengths, unsigned long long *hash) {
+    static const unsigned char special[] = {0x00, B_SLIP_END, B_SLIP_ESC, '\n'};
+    unsigned char *payload;
+    unsigned long bytes = 0, frame;
+    unsigned int length, i;
+
+    seed = 0x9E3779B97F4A7C15ULL;
+    *hash = 0xCBF29CE484222325ULL;
+    for (frame = 0; frame < frames; frame++) {
+        length = 1 + randomNumber() % FRAMING_MAX_PAYLOAD;
+        payload = payloads + frame * FRAMING_MAX_PAYLOAD;
+        lengths[frame] = length;
+        for (i = 0; i < length; i++) {
+            payload[i] = (randomNumber() % 8 == 0) ? special[randomNumber() % sizeof(special)] : randomNumber();
+            if ( (format == B_FRAME_DELIMITED) && (payload[i] == '\n') ) {
+                payload[i] = ' ';
+            }
+        }
+        *hash = hashFrame(*hash, payload, length);
+        bytes += encodeTestFrame(format, payload, length, stream + bytes);
+    }
+    return bytes;
+}
+
+// Feed one byte to the byte-at-a-time decoder; returns 1 when a frame is done
+unsigned char feedBytewise(unsigned char format, bytewise_t *s, unsigned char c) {
+    unsigned int in, out, code;
+
+    if (format == B_FRAME_LENGTH_BE) {
+        if (s->state < 2) {
+            s->need = (s->need << 8) | c;
+            s->state++;
+            return (s->state == 2) && (s->need == 0);
+        }
+        s->frame[s->n++] = c;
+        return s->n == s->need;
+    }
+    if (format == B_FRAME_SLIP) {
+        if (s->state) {
+            s->frame[s->n++] = (c == B_SLIP_ESC_END) ? B_SLIP_END : B_SLIP_ESC;
+            s->state = 0;
+            return 0;
+        }
+        if (c == B_SLIP_ESC) {
+            s->state = 1;
+            return 0;
+        }
+        if (c != B_SLIP_END) {
+            s->frame[s->n++] = c;
+            return 0;
+        }
+        return s->n > 0;
+    }
+    if (format == B_FRAME_COBS) {
+        if (c != 0) {
+            s->frame[s->n++] = c;
+            return 0;
+        }
+        for (in = 0, out = 0; in < s->n; ) {
+            code = s->frame[in++];
+            memmove(s->frame + out, s->frame + in, code - 1);
+            in += code - 1;
+            out += code - 1;
+            if ( (code < 0xFF) && (in < s->n) ) {
+                s->frame[out++] = 0;
+            }
+        }
+        s->n = out;
+        return 1;
+    }
+    if (c == '\n') {
+        return 1;
+    }
+    s->frame[s->n++] = c;
+    return 0;
+}
+
+// Feed the stream through a buffer and hash every frame taken out
+// -The return value is the number of frames
+unsigned long runFraming(unsigned char format, unsigned char bytewise, const unsigned char *stream, unsigned long bytes,
+                         unsigned int chunk, unsigned long long *hash) {
+    static unsigned char scratch[FRAMING_MAX_WIRE];
+    framedecoder_t decoder;
+    bytewise_t state;
+    buffersegment_t s[2];
+    frame_t frame;
+    buffer_t *b;
+    unsigned long fed = 0, frames = 0;
+    unsigned int room, used, l;
+    unsigned char c;
+
+    b = newBuffer(FRAMING_RING, 1, B_FIFO & B_DROP);
+    if ( !(b) ) {
+        fprintf(stderr, "framing: out of memory\n");
+        exit(1);
+    }
+    initFrameDecoder(&decoder, format, (format == B_FRAME_DELIMITED) ? '\n' : 2, FRAMING_MAX_WIRE);
+    memset(&state, 0, sizeof(state));
+    *hash = 0xCBF29CE484222325ULL;
+
+    while (fed < bytes) {
+        used = peekBuffer(b, s);
+        room = FRAMING_RING - used;
+        l = (bytes - fed < chunk) ? bytes - fed : chunk;
+        if (l > room) {
+            l = room;
+        }
+        pushToBuffer(b, (void*)(stream + fed), l);
+        fed += l;
+
+        if (bytewise) {
+            while ( !(popFromBuffer(b, &c, 1)) ) {
+                if ( feedBytewise(format, &state, c) ) {
+                    *hash = hashFrame(*hash, state.frame, state.n);
+                    frames++;
+                    state.n = 0;
+                    state.need = 0;
+                    state.state = 0;
+                }
+            }
+        }
+        else {
+            while (decodeFrame(&decoder, b, scratch, &frame) != B_FRAME_INCOMPLETE) {
+                if (frame.status == B_FRAME_READY) {
+                    *hash = hashFrame(*hash, frame.data, frame.length);
+                    frames++;
+                }
+                consumeFrame(b, &frame);
+            }
+        }
+    }
+    freeBuffer(b);
+    return frames;
+}
+
+// Compare everything in b with the stream from offset on, then discard it
+// -The return value is 1 if they differ
+unsigned char flushEncoded(buffer_t *b, const unsigned char *stream, unsigned long bytes, unsigned long *offset) {
+    buffersegment_t s[2];
+    unsigned char wrong = 0;
+    unsigned int i;
+
+    peekBuffer(b, s);
+    for (i = 0; i < 2; i++) {
+        wrong |= (*offset + s[i].count > bytes) || memcmp(s[i].data, stream + *offset, s[i].count);
+        *offset += s[i].count;
+    }
+    discardFromBuffer(b, s[0].count + s[1].count);
+    return wrong;
+}
+
+// Encode every payload into a buffer, flushing it whenever the next frame
+// doesn't fit; returns 1 if the bytes written differ from the stream
+unsigned char runEncoding(unsigned char format, unsigned char direct, const unsigned char *payloads, const unsigned int *lengths,
+                          unsigned long frames, const unsigned char *stream, unsigned long bytes) {
+    unsigned char encoded[FRAMING_MAX_WIRE], option, wrong = 0;
+    const unsigned char *payload;
+    buffersegment_t s[2];
+    unsigned long frame, offset = 0;
+    unsigned int length;
+    buffer_t *b;
+
+    b = newBuffer(FRAMING_RING, 1, B_FIFO & B_DROP);
+    if ( !(b) ) {
+        fprintf(stderr, "framing: out of memory\n");
+        exit(1);
+    }
+    option = (format == B_FRAME_DELIMITED) ? '\n' : 2;
+
+    for (frame = 0; frame < frames; frame++) {
+        payload = payloads + frame * FRAMING_MAX_PAYLOAD;
+        if (direct) {
+            while (encodeFrame(b, format, option, payload, lengths[frame]) == 1) {
+                wrong |= flushEncoded(b, stream, bytes, &offset);
+            }
+        }
+        else {
+            length = encodeTestFrame(format, payload, lengths[frame], encoded);
+            if (FRAMING_RING - peekBuffer(b, s) < length) {
+                wrong |= flushEncoded(b, stream, bytes, &offset);
+            }
+            pushToBuffer(b, encoded, length);
+        }
+    }
+    wrong |= flushEncoded(b, stream, bytes, &offset);
+    freeBuffer(b);
+    return wrong || (offset != bytes);
+}
+
+// Print one row
+void printFraming(const char *direction, const char *variant, const char *format, double chunk, unsigned long frames,
+                  unsigned long bytes, double elapsed, unsigned char match) {
+    beginBenchRow();
+    addBenchText("benchmark", "framing");
+    addBenchText("direction", direction);
+    addBenchText("variant", variant);
+    addBenchText("format", format);
+    addBenchNumber("chunk", chunk);
+    addBenchNumber("frames", frames);
+    addBenchNumber("ns_per_frame", elapsed / frames);
+    addBenchNumber("mb_per_second", bytes / elapsed * 1e3);
+    addBenchText("frames_match", match ? "yes" : "no");
+    addBenchCounters(frames);
+    endBenchRow();
+}
+
+int main(int argc, char *argv[]) {
+    static const unsigned char formats[] = {B_FRAME_LENGTH_BE, B_FRAME_COBS, B_FRAME_SLIP, B_FRAME_DELIMITED};
+    static const char *formatNames[] = {"length_be16", "cobs", "slip", "lines"};
+    static const char *decoders[] = {"bytewise", "decodeFrame"};
+    static const char *encoders[] = {"array+push", "encodeFrame"};
+    unsigned long frames, bytes, found;
+    unsigned long long expected, hash;
+    unsigned int chunk, f, v, *lengths, errors = 0;
+    unsigned char *stream, *payloads, wrong;
+    double elapsed;
+
+    argc = parseBenchOptions(argc, argv);
+    frames = (argc > 1) ? strtoul(argv[1], NULL, 0) : 200000;
+    chunk = (argc > 2) ? strtoul(argv[2], NULL, 0) : 1460;
+
+    stream = malloc(frames * FRAMING_MAX_WIRE);
+    payloads = malloc(frames * FRAMING_MAX_PAYLOAD);
+    lengths = malloc(frames * sizeof(unsigned int));
+    if ( !(stream) || !(payloads) || !(lengths) || (chunk == 0) ) {
+        fprintf(stderr, "framing: out of memory\n");
+        return 1;
+    }
+
+    for (f = 0; f < sizeof(formats); f++) {
+        bytes = buildStream(formats[f], frames, stream, payloads, lengths, &expected);
+        for (v = 0; v < 2; v++) {
+            startBenchCounters();
+            elapsed = benchNanoseconds();
+            found = runFraming(formats[f], v == 0, stream, bytes, chunk, &hash);
+            elapsed = benchNanoseconds() - elapsed;
+            stopBenchCounters();
+            wrong = (found != frames) || (hash != expected);
+            errors += wrong;
+            printFraming("decode", decoders[v], formatNames[f], chunk, frames, bytes, elapsed, !(wrong));
+        }
+        for (v = 0; v < 2; v++) {
+            startBenchCounters();
+            elapsed = benchNanoseconds();
+            wrong = runEncoding(formats[f], v == 1, payloads, lengths, frames, stream, bytes);
+            elapsed = benchNanoseconds() - elapsed;
+            stopBenchCounters();
+            errors += wrong;
+            printFraming("encode", encoders[v], formatNames[f], NAN, frames, bytes, elapsed, !(wrong));
+        }
+    }
+
+    free(stream);
+    free(payloads);
+    free(lengths);
+    if (errors) {
+        fprintf(stderr, "framing: %u cases got the wrong frames\n", errors);
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,187 @@
+//==============================================================================
+//                                   mpsc.c
+//------------------------------------------------------------------------------
+// Brief
+//   Benchmarks mpscbuffer_t against a mutex-wrapped buffer_t with 2-64
+//   producer threads and one consumer thread
+//
+// Description
+//   Every producer pushes its share of the elements one at a time, retrying
+//   when the buffer is full, while the consumer pops in batches until every
+//   element has arrived. Each element carries its producer and a per-producer
+//   count, and the consumer checks that each producer's elements arrive in
+//   order.
+//   Build
+//      gcc -O2 -pthread -o mpsc mpsc.c bench.c ../buffer.c ../mpscbuffer.c
+//   Run
+//      ./mpsc [--csv|--json] [--counters] [elements per case] [buffer depth]
+//
+// Author
+//   Daniel Wilkinson-Thompson (daniel@wilkinson-thompson.com)
+//
+// Date
+//   2026-10-18
+//
+// Licence
+//   Copyright (c) 2026 Daniel Wilkinson-Thompson. All rights reserved.
+//------------------------------------------------------------------------------
+
+//------------------------------------------------------------------------------
+// Headers
+//------------------------------------------------------------------------------
+#include "bench.h"
+#include "../buffer.h"
+#include "../mpscbuffer.h"
+#include <pthread.h>
+#include <sched.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+//------------------------------------------------------------------------------
+// Constants
+//------------------------------------------------------------------------------
+#define MAX_PRODUCERS   64
+#define POP_BATCH       256
+
+//------------------------------------------------------------------------------
+// Type definitions
+//------------------------------------------------------------------------------
+typedef struct {
+    buffer_t *locked;
+    mpscbuffer_t *mpsc;
+    pthread_mutex_t mutex;
+    unsigned long perProducer;
+    unsigned int producers;
+    unsigned int errors;
+} mpscBench_t;
+
+typedef struct {
+    mpscBench_t *bench;
+    unsigned long id;
+} producer_t;
+
+//------------------------------------------------------------------------------
+// Functions
+//------------------------------------------------------------------------------
+// Producer pushing to the mutex-wrapped buffer
+void* lockedProducer(void *arg) {
+    producer_t *p = arg;
+    unsigned long count, element;
+    unsigned int failed;
+
+    for (count = 0; count < p->bench->perProducer; count++) {
+        element = (p->id << 48) | count;
+        do {
+            pthread_mutex_lock(&(p->bench->mutex));
+            failed = pushToBuffer(p->bench->locked, &element, 1);
+            pthread_mutex_unlock(&(p->bench->mutex));
+            if (failed) {
+                sched_yield();
+            }
+        } while (failed);
+    }
+    return NULL;
+}
+
+// Producer pushing to the MPSC buffer
+void* mpscProducer(void *arg) {
+    producer_t *p = arg;
+    unsigned long count, element;
+
+    for (count = 0; count < p->bench->perProducer; count++) {
+        element = (p->id << 48) | count;
+        while (pushToMpscBuffer(p->bench->mpsc, &element, 1)) {
+            sched_yield();
+        }
+    }
+    return NULL;
+}
+
+// Check that each producer's elements arrive in order
+void checkElements(mpscBench_t *m, unsigned long *next, unsigned long *elements, unsigned int n) {
+    unsigned int i;
+    for (i = 0; i < n; i++) {
+        unsigned long id = elements[i] >> 48;
+        if ( (id >= m->producers) || ((elements[i] & 0xFFFFFFFFFFFFUL) != next[id]++) ) {
+            m->errors++;
+        }
+    }
+}
+
+// Run one case and return the elapsed time in nanoseconds
+double runCase(mpscBench_t *m, unsigned char useMpsc) {
+    pthread_t threads[MAX_PRODUCERS];
+    producer_t producers[MAX_PRODUCERS];
+    unsigned long elements[POP_BATCH], next[MAX_PRODUCERS] = {0};
+    unsigned long received = 0, total = m->perProducer * m->producers;
+    unsigned int i, n;
+    double start;
+
+    startBenchCounters();
+    start = benchNanoseconds();
+    for (i = 0; i < m->producers; i++) {
+        producers[i].bench = m;
+        producers[i].id = i;
+        pthread_create(&threads[i], NULL, useMpsc ? mpscProducer : lockedProducer, &producers[i]);
+    }
+
+    // Consume on this thread
+    while (received < total) {
+        if (useMpsc) {
+            n = POP_BATCH - popFromMpscBuffer(m->mpsc, &elements[0], POP_BATCH);
+        }
+        else {
+            pthread_mutex_lock(&(m->mutex));
+            n = POP_BATCH - popFromBuffer(m->locked, &elements[0], POP_BATCH);
+            pthread_mutex_unlock(&(m->mutex));
+        }
+        if (n == 0) {
+            sched_yield();
+            continue;
+        }
+        checkElements(m, &next[0], &elements[0], n);
+        received += n;
+    }
+
+    for (i = 0; i < m->producers; i++) {
+        pthread_join(threads[i], NULL);
+    }
+    start = benchNanoseconds() - start;
+    stopBenchCounters();
+    return start;
+}
+
+int main(int argc, char *argv[]) {
+    mpscBench_t m;
+    unsigned long elements;
+    unsigned int depth, producers;
+
+    argc = parseBenchOptions(argc, argv);
+    elements = (argc > 1) ? strtoul(argv[1], NULL, 0) : 1UL << 22;
+    depth = (argc > 2) ? strtoul(argv[2], NULL, 0) : 4096;
+
+    m.locked = newBuffer(depth, sizeof(unsigned long), B_FIFO & B_DROP);
+    m.mpsc = newMpscBuffer(depth, sizeof(unsigned long));
+    if ( !(m.locked) || !(m.mpsc) ) {
+        fprintf(stderr, "mpsc: out of memory\n");
+        return 1;
+    }
+    pthread_mutex_init(&(m.mutex), NULL);
+    m.errors = 0;
+
+    for (producers = 2; producers <= MAX_PRODUCERS; producers *= 2) {
+        m.producers = producers;
+        m.perProducer = elements / producers;
+        printBenchResult("mpsc", "mutex+pushToBuffer", producers, m.perProducer * producers, runCase(&m, 0));
+        printBenchResult("mpsc", "mpscbuffer", producers, m.perProducer * producers, runCase(&m, 1));
+    }
+
+    pthread_mutex_destroy(&(m.mutex));
+    freeBuffer(m.locked);
+    freeMpscBuffer(m.mpsc);
+    if (m.errors) {
+        fprintf(stderr, "mpsc: %u elements arrived out of order\n", m.errors);
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,395 @@
+//==============================================================================
+//                                 pingpong.c
+//------------------------------------------------------------------------------
+// Brief
+//   Measures the cost of handing elements between two pinned CPUs through
+//   each buffer type: round-trip latency and one-way throughput
+//
+// Description
+//   For every CPU pair and every buffer type:
+//   -Round trip: the first CPU pushes an element into one buffer, the second
+//    pops it and pushes it back through another, and the first times the
+//    whole trip with the cycle counter
+//   -One way: the first CPU pushes elements as fast as it can and the second
+//    pops them in batches, timing the whole run
+//   Both start with untimed warmup iterations so caches, TLBs and branch
+//   predictors are settled. Each pair is labelled from the sysfs topology as
+//   same-cpu, smt-sibling, same-socket or cross-socket, so the --json or CSV
+//   output can be pivoted straight into a heatmap.
+//   buffer_t is not thread-safe, so it is measured behind a mutex.
+//   With --counters, hardware counters cover the one-way run (both threads,
+//   warmup included) and are reported per element.
+//   Build
+//      gcc -O2 -pthread -o pingpong pingpong.c bench.c ../buffer.c ../mpscbuffer.c ../waitfreebuffer.c ../signalbuffer.c ../stackbuffer.c
+//   Run
+//      ./pingpong [--csv|--json] [--counters] [-n round trips] [-w warmup] [-t elements]
+//                 [-d depth] [producer:consumer ...]
+//   With no CPU pairs, every pair of CPUs this process may run on is measured
+//
+// Author
+//   Daniel Wilkinson-Thompson (daniel@wilkinson-thompson.com)
+//
+// Date
+//   2026-10-18
+//
+// Licence
+//   Copyright (c) 2026 Daniel Wilkinson-Thompson. All rights reserved.
+//------------------------------------------------------------------------------
+
+//------------------------------------------------------------------------------
+// Headers
+//------------------------------------------------------------------------------
+#define _GNU_SOURCE
+#include "bench.h"
+#include "../buffer.h"
+#include "../mpscbuffer.h"
+#include "../signalbuffer.h"
+#include "../stackbuffer.h"
+#include "../waitfreebuffer.h"
+#include <pthread.h>
+#include <sched.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+//------------------------------------------------------------------------------
+// Constants
+//------------------------------------------------------------------------------
+#define MAX_PAIRS       4096
+#define POP_BATCH       64
+#define STOP            0xFFFFFFFFFFFFFFFFULL
+
+//------------------------------------------------------------------------------
+// Type definitions
+//------------------------------------------------------------------------------
+// One buffer type, seen through the push/pop conventions of buffer.h
+typedef struct {
+    const char *name;
+    void* (*create)(unsigned int depth);
+    void (*destroy)(void *b);
+    unsigned int (*push)(void *b, const void *d, unsigned int l);
+    unsigned int (*pop)(void *b, void *d, unsigned int l);
+} handoff_t;
+
+typedef struct {
+    buffer_t *b;
+    pthread_mutex_t mutex;
+} lockedBuffer_t;
+
+typedef struct {
+    const handoff_t *h;
+    void *ping;
+    void *pong;
+    unsigned long long elements;
+    int cpu;
+    volatile int ready;
+} pingpong_t;
+
+//------------------------------------------------------------------------------
+// Functions
+//------------------------------------------------------------------------------
+// buffer_t behind a mutex
+void* createLocked(unsigned int depth) {
+    lockedBuffer_t *l = malloc(sizeof(lockedBuffer_t));
+    l->b = newBuffer(depth, sizeof(unsigned long long), B_FIFO & B_DROP);
+    pthread_mutex_init(&(l->mutex), NULL);
+    return l;
+}
+void destroyLocked(void *b) {
+    lockedBuffer_t *l = b;
+    pthread_mutex_destroy(&(l->mutex));
+    freeBuffer(l->b);
+    free(l);
+}
+unsigned int pushLocked(void *b, const void *d, unsigned int n) {
+    lockedBuffer_t *l = b;
+    unsigned int failed;
+    pthread_mutex_lock(&(l->mutex));
+    failed = pushToBuffer(l->b, (void*)d, n);
+    pthread_mutex_unlock(&(l->mutex));
+    return failed;
+}
+unsigned int popLocked(void *b, void *d, unsigned int n) {
+    lockedBuffer_t *l = b;
+    unsigned int failed;
+    pthread_mutex_lock(&(l->mutex));
+    failed = popFromBuffer(l->b, d, n);
+    pthread_mutex_unlock(&(l->mutex));
+    return failed;
+}
+
+// mpscbuffer_t
+void* createMpsc(unsigned int depth) {
+    return newMpscBuffer(depth, sizeof(unsigned long long));
+}
+void destroyMpsc(void *b) {
+    freeMpscBuffer(b);
+}
+unsigned int pushMpsc(void *b, const void *d, unsigned int n) {
+    return pushToMpscBuffer(b, d, n);
+}
+unsigned int popMpsc(void *b, void *d, unsigned int n) {
+    return popFromMpscBuffer(b, d, n);
+}
+
+// waitfreebuffer_t with a single producer lane
+void* createWaitFree(unsigned int depth) {
+    return newWaitFreeBuffer(1, depth, sizeof(unsigned long long), B_DROP);
+}
+void destroyWaitFree(void *b) {
+    freeWaitFreeBuffer(b);
+}
+unsigned int pushWaitFree(void *b, const void *d, unsigned int n) {
+    return pushToWaitFreeBuffer(b, 0, d, n);
+}
+unsigned int popWaitFree(void *b, void *d, unsigned int n) {
+    return popFromWaitFreeBuffer(b, d, n);
+}
+
+// signalbuffer_t, one record per push
+void* createSignal(unsigned int depth) {
+    return newSignalBuffer(depth, sizeof(unsigned long long));
+}
+void destroySignal(void *b) {
+    freeSignalBuffer(b);
+}
+unsigned int pushSignal(void *b, const void *d, unsigned int n) {
+    return pushToSignalBuffer(b, d, n);
+}
+unsigned int popSignal(void *b, void *d, unsigned int n) {
+    return n - drainSignalBuffer(b, d, n);
+}
+
+// stackbuffer_t
+void* createStack(unsigned int depth) {
+    return newStackBuffer(depth, sizeof(unsigned long long), 1);
+}
+void destroyStack(void *b) {
+    freeStackBuffer(b);
+}
+unsigned int pushStack(void *b, const void *d, unsigned int n) {
+    return pushToStackBuffer(b, d, n);
+}
+unsigned int popStack(void *b, void *d, unsigned int n) {
+    return popFromStackBuffer(b, d, n);
+}
+
+static const handoff_t handoffs[] = {
+    {"mutex+buffer",   createLocked,   destroyLocked,   pushLocked,   popLocked},
+    {"mpscbuffer",     createMpsc,     destroyMpsc,     pushMpsc,     popMpsc},
+    {"waitfreebuffer", createWaitFree, destroyWaitFree, pushWaitFree, popWaitFree},
+    {"signalbuffer",   createSignal,   destroySignal,   pushSignal,   popSignal},
+    {"stackbuffer",    createStack,    destroyStack,    pushStack,    popStack},
+};
+
+// Spin politely, and give the CPU away now and then in case the other side
+// of the handoff is waiting for it
+void spinWait(unsigned int *spins) {
+    if ( (++(*spins) & 1023) == 0 ) {
+        sched_yield();
+    }
+#if defined(__x86_64__) || defined(__i386__)
+    else {
+        __builtin_ia32_pause();
+    }
+#endif
+}
+
+// Read one topology number of a CPU from sysfs, or -1
+int readTopology(int cpu, const char *name) {
+    char path[128];
+    FILE *f;
+    int value = -1;
+
+    snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%d/topology/%s", cpu, name);
+    if ( (f = fopen(path, "r")) ) {
+        if (fscanf(f, "%d", &value) != 1) {
+            value = -1;
+        }
+        fclose(f);
+    }
+    return value;
+}
+
+// Describe how two CPUs are related
+const char* cpuRelation(int a, int b) {
+    if (a == b) {
+        return "same-cpu";
+    }
+    if (readTopology(a, "physical_package_id") != readTopology(b, "physical_package_id")) {
+        return "cross-socket";
+    }
+    if (readTopology(a, "core_id") == readTopology(b, "core_id")) {
+        return "smt-sibling";
+    }
+    return "same-socket";
+}
+
+// Second CPU of a round trip: bounce every element back until STOP
+void* responder(void *arg) {
+    pingpong_t *p = arg;
+    unsigned long long value;
+    unsigned int spins = 0;
+
+    pinBenchThread(p->cpu);
+    p->ready = 1;
+    do {
+        while ( p->h->pop(p->ping, &value, 1) ) {
+            spinWait(&spins);
+        }
+        while ( p->h->push(p->pong, &value, 1) ) {
+            spinWait(&spins);
+        }
+    } while (value != STOP);
+    return NULL;
+}
+
+// First CPU of a one-way run: push every element as fast as possible
+void* sender(void *arg) {
+    pingpong_t *p = arg;
+    unsigned long long value;
+    unsigned int spins = 0;
+
+    pinBenchThread(p->cpu);
+    p->ready = 1;
+    for (value = 0; value < p->elements; value++) {
+        while ( p->h->push(p->ping, &value, 1) ) {
+            spinWait(&spins);
+        }
+    }
+    return NULL;
+}
+
+// Sort helper for cycle samples
+int compareCycles(const void *a, const void *b) {
+    unsigned long long x = *(const unsigned long long*)a, y = *(const unsigned long long*)b;
+    return (x > y) - (x < y);
+}
+
+int main(int argc, char *argv[]) {
+    unsigned long iterations = 100000, warmup = 10000, elements = 1UL << 22;
+    unsigned int depth = 1024, pairCount = 0, spins, i, received;
+    int pairs[MAX_PAIRS][2], option, a, b;
+    unsigned long long *samples, value, batch[POP_BATCH], start;
+    cpu_set_t allowed;
+    pingpong_t p;
+    pthread_t thread;
+    double oneWay;
+
+    argc = parseBenchOptions(argc, argv);
+    while ( (option = getopt(argc, argv, "n:w:t:d:")) != -1 ) {
+        switch (option) {
+            case 'n': iterations = strtoul(optarg, NULL, 0); break;
+            case 'w': warmup = strtoul(optarg, NULL, 0); break;
+            case 't': elements = strtoul(optarg, NULL, 0); break;
+            case 'd': depth = strtoul(optarg, NULL, 0); break;
+            default:
+                fprintf(stderr, "usage: %s [--csv|--json] [-n round trips] [-w warmup] [-t elements] [-d depth] [producer:consumer ...]\n", argv[0]);
+                return 1;
+        }
+    }
+
+    // CPU pairs from the command line, or every allowed pair
+    for (; (optind < argc) && (pairCount < MAX_PAIRS); optind++) {
+        if (sscanf(argv[optind], "%d:%d", &a, &b) == 2) {
+            pairs[pairCount][0] = a;
+            pairs[pairCount][1] = b;
+            pairCount++;
+        }
+    }
+    if (pairCount == 0) {
+        sched_getaffinity(0, sizeof(allowed), &allowed);
+        for (a = 0; a < CPU_SETSIZE; a++) {
+            for (b = a + 1; (b < CPU_SETSIZE) && CPU_ISSET(a, &allowed) && (pairCount < MAX_PAIRS); b++) {
+                if (CPU_ISSET(b, &allowed)) {
+                    pairs[pairCount][0] = a;
+                    pairs[pairCount][1] = b;
+                    pairCount++;
+                }
+            }
+        }
+        if (pairCount == 0) {
+            pairs[0][0] = pairs[0][1] = sched_getcpu();
+            pairCount = 1;
+        }
+    }
+
+    samples = malloc(iterations * sizeof(unsigned long long));
+    if ( !(samples) || (iterations == 0) ) {
+        fprintf(stderr, "pingpong: out of memory\n");
+        return 1;
+    }
+
+    for (i = 0; i < pairCount; i++) {
+        for (p.h = &handoffs[0]; p.h < &handoffs[sizeof(handoffs) / sizeof(handoffs[0])]; p.h++) {
+
+            // Round trips, timed on the first CPU
+            p.ping = p.h->create(depth);
+            p.pong = p.h->create(depth);
+            p.cpu = pairs[i][1];
+            p.ready = 0;
+            pinBenchThread(pairs[i][0]);
+            pthread_create(&thread, NULL, responder, &p);
+            while ( !(p.ready) ) {
+                sched_yield();
+            }
+            spins = 0;
+            for (value = 0; value < warmup + iterations; value++) {
+                start = benchCycles();
+                p.h->push(p.ping, &value, 1);
+                while ( p.h->pop(p.pong, batch, 1) ) {
+                    spinWait(&spins);
+                }
+                if (value >= warmup) {
+                    samples[value - warmup] = benchCycles() - start;
+                }
+            }
+            value = STOP;
+            p.h->push(p.ping, &value, 1);
+            pthread_join(thread, NULL);
+            p.h->pop(p.pong, batch, 1);
+            qsort(samples, iterations, sizeof(unsigned long long), compareCycles);
+
+            // One way, timed on the second CPU once the warmup has arrived
+            p.elements = warmup + elements;
+            p.cpu = pairs[i][0];
+            p.ready = 0;
+            pinBenchThread(pairs[i][1]);
+            startBenchCounters();
+            pthread_create(&thread, NULL, sender, &p);
+            oneWay = 0;
+            for (value = 0, spins = 0; value < p.elements; value += received) {
+                received = POP_BATCH - p.h->pop(p.ping, batch, POP_BATCH);
+                if (received == 0) {
+                    spinWait(&spins);
+                }
+                if ( (oneWay == 0) && (value + received >= warmup) ) {
+                    oneWay = benchNanoseconds();
+                }
+            }
+            oneWay = benchNanoseconds() - oneWay;
+            pthread_join(thread, NULL);
+            stopBenchCounters();
+            p.h->destroy(p.ping);
+            p.h->destroy(p.pong);
+
+            beginBenchRow();
+            addBenchText("benchmark", "pingpong");
+            addBenchText("variant", p.h->name);
+            addBenchNumber("producer_cpu", pairs[i][0]);
+            addBenchNumber("consumer_cpu", pairs[i][1]);
+            addBenchText("relation", cpuRelation(pairs[i][0], pairs[i][1]));
+            addBenchNumber("rtt_min_cycles", samples[0]);
+            addBenchNumber("rtt_p50_cycles", samples[iterations / 2]);
+            addBenchNumber("rtt_p99_cycles", samples[(unsigned long)(iterations * 0.99)]);
+            addBenchNumber("rtt_p50_ns", samples[iterations / 2] / benchCyclesPerNanosecond());
+            addBenchNumber("one_way_elements_per_second", (double)(unsigned long long)(elements / (oneWay / 1e9)));
+            addBenchNumber("one_way_ns_per_element", oneWay / elements);
+            addBenchCounters(p.elements);
+            endBenchRow();
+        }
+    }
+
+    free(samples);
+    return 0;
+}
@@ -0,0 +1,210 @@
+//==============================================================================
+//                                   pool.c
+//------------------------------------------------------------------------------
+// Brief
+//   Compares resident memory after heavy create/free churn for buffers from
+//   newBuffer() and from a compacted bufferpool_t
+//
+// Description
+//   Each round tops the live set up to the given number of buffers, each with
+//   a random capacity and element size, writes a few elements into it, then
+//   frees a random nine in ten. After the last round the resident set size
+//   (from /proc/self/statm) is compared with the bytes the live buffers
+//   actually store. For the pool it is measured again after
+//   compactBufferPool(). Every surviving buffer is then drained and its
+//   contents checked, so a compaction that loses or corrupts data fails the
+//   run.
+//   Build
+//      gcc -O2 -o pool pool.c bench.c ../buffer.c ../bufferpool.c
+//   Run
+//      ./pool [--csv|--json] [--counters] [buffers] [rounds]
+//
+// Author
+//   Daniel Wilkinson-Thompson (daniel@wilkinson-thompson.com)
+//
+// Date
+//   2026-10-18
+//
+// Licence
+//   Copyright (c) 2026 Daniel Wilkinson-Thompson. All rights reserved.
+//------------------------------------------------------------------------------
+
+//------------------------------------------------------------------------------
+// Headers
+//------------------------------------------------------------------------------
+#include "bench.h"
+#include "../buffer.h"
+#include "../bufferpool.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+//------------------------------------------------------------------------------
+// Private variables
+//------------------------------------------------------------------------------
+static unsigned long long seed = 0x9E3779B97F4A7C15ULL;
+
+//------------------------------------------------------------------------------
+// Functions
+//------------------------------------------------------------------------------
+// xorshift64* random numbers, so both variants see the same sizes
+unsigned long long randomNumber(void) {
+    seed ^= seed >> 12;
+    seed ^= seed << 25;
+    seed ^= seed >> 27;
+    return seed * 0x2545F4914F6CDD1DULL;
+}
+
+// Resident set size in bytes
+double residentBytes(void) {
+    unsigned long size = 0, resident = 0;
+    FILE *f;
+
+    f = fopen("/proc/self/statm", "r");
+    if ( !(f) ) {
+        return 0;
+    }
+    if (fscanf(f, "%lu %lu", &size, &resident) != 2) {
+        resident = 0;
+    }
+    fclose(f);
+    return (double)resident * sysconf(_SC_PAGESIZE);
+}
+
+// New buffer of random shape from either allocator, with a few elements in it
+// -Element i of buffer slot holds (slot + i) in every byte
+buffer_t* newChurnBuffer(bufferpool_t *pool, unsigned long slot) {
+    static const unsigned char widths[] = {1, 2, 4, 8, 16};
+    unsigned char element[16];
+    unsigned int n, i, j;
+    buffer_t *b;
+
+    n = 4 + randomNumber() % 1021;
+    j = randomNumber() % sizeof(widths);
+    b = pool ? newPooledBuffer(pool, n, widths[j], B_FIFO & B_DROP) : newBuffer(n, widths[j], B_FIFO & B_DROP);
+    if ( !(b) ) {
+        fprintf(stderr, "pool: out of memory\n");
+        exit(1);
+    }
+    for (i = 0; i < 4; i++) {
+        for (j = 0; j < b->width; j++) {
+            element[j] = slot + i;
+        }
+        pushToBuffer(b, element, 1);
+    }
+    return b;
+}
+
+// Drain a buffer and check its contents; returns 1 if they are wrong
+unsigned char checkChurnBuffer(buffer_t *b, unsigned long slot) {
+    unsigned char element[16];
+    unsigned int i, j, wrong = 0;
+
+    for (i = 0; i < 4; i++) {
+        if ( popFromBuffer(b, element, 1) ) {
+            return 1;
+        }
+        for (j = 0; j < b->width; j++) {
+            wrong |= (element[j] != (unsigned char)(slot + i));
+        }
+    }
+    return wrong || !isBufferEmpty(b);
+}
+
+// Print one row
+void printChurn(const char *variant, unsigned long buffers, double live, double rss, double nanoseconds, unsigned long operations) {
+    beginBenchRow();
+    addBenchText("benchmark", "pool");
+    addBenchText("variant", variant);
+    addBenchNumber("buffers", buffers);
+    addBenchNumber("live_bytes", live);
+    addBenchNumber("rss_bytes", rss);
+    addBenchNumber("rss_over_live", rss / live);
+    addBenchNumber("ns_per_new_free", nanoseconds / operations);
+    addBenchCounters(operations);
+    endBenchRow();
+}
+
+// Run the churn with one allocator; returns the number of corrupted buffers
+unsigned long runChurn(unsigned char pooled, unsigned long buffers, unsigned int rounds) {
+    bufferpool_t *pool = NULL;
+    buffer_t **live;
+    unsigned long i, operations = 0, errors = 0;
+    unsigned int round;
+    double baseline, storage = 0, start, elapsed, compaction;
+
+    seed = 0x9E3779B97F4A7C15ULL;
+    live = calloc(buffers, sizeof(buffer_t*));
+    if (pooled) {
+        pool = newBufferPool();
+    }
+    if ( !(live) || (pooled && !(pool)) ) {
+        fprintf(stderr, "pool: out of memory\n");
+        exit(1);
+    }
+    baseline = residentBytes();
+
+    startBenchCounters();
+    start = benchNanoseconds();
+    for (round = 0; round < rounds; round++) {
+        for (i = 0; i < buffers; i++) {
+            if ( !(live[i]) ) {
+                live[i] = newChurnBuffer(pool, i);
+                operations++;
+            }
+        }
+        for (i = 0; i < buffers; i++) {
+            if ( (randomNumber() % 10) != 0 ) {
+                pooled ? freePooledBuffer(pool, live[i]) : freeBuffer(live[i]);
+                live[i] = NULL;
+            }
+        }
+    }
+    elapsed = benchNanoseconds() - start;
+    stopBenchCounters();
+
+    for (i = 0; i < buffers; i++) {
+        if (live[i]) {
+            storage += (double)live[i]->depth * live[i]->width;
+        }
+    }
+    printChurn(pooled ? "bufferpool" : "newBuffer", buffers, storage, residentBytes() - baseline, elapsed, operations);
+
+    if (pooled) {
+        compaction = benchNanoseconds();
+        compactBufferPool(pool);
+        compaction = benchNanoseconds() - compaction;
+        printChurn("bufferpool+compact", buffers, storage, residentBytes() - baseline, elapsed + compaction, operations);
+    }
+
+    for (i = 0; i < buffers; i++) {
+        if (live[i]) {
+            errors += checkChurnBuffer(live[i], i);
+            pooled ? freePooledBuffer(pool, live[i]) : freeBuffer(live[i]);
+        }
+    }
+    if (pooled) {
+        freeBufferPool(pool);
+    }
+    free(live);
+    return errors;
+}
+
+int main(int argc, char *argv[]) {
+    unsigned long buffers, errors;
+    unsigned int rounds;
+
+    argc = parseBenchOptions(argc, argv);
+    buffers = (argc > 1) ? strtoul(argv[1], NULL, 0) : 100000;
+    rounds = (argc > 2) ? strtoul(argv[2], NULL, 0) : 8;
+
+    // Pool first, so the heap holes newBuffer() leaves behind don't flatter it
+    errors = runChurn(1, buffers, rounds);
+    errors += runChurn(0, buffers, rounds);
+
+    if (errors) {
+        fprintf(stderr, "pool: %lu buffers corrupted\n", errors);
+        return 1;
+    }
+    return 0;
+}
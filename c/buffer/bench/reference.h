@@ -0,0 +1,65 @@
+//==============================================================================
+//                                reference.h
+//------------------------------------------------------------------------------
+// Brief
+//   Frozen copy of the original byte-at-a-time buffer implementation, used as
+//   the reference for differential testing and speedup measurements
+//
+// Contents
+//   - newReferenceBuffer
+//   - freeReferenceBuffer
+//   - isReferenceBufferEmpty
+//   - isReferenceBufferFull
+//   - popFromReferenceBuffer
+//   - pushToReferenceBuffer
+//
+// Description
+//   Takes the same configuration constants (B_FIFO, B_DROP, ...) as buffer.h
+//   and behaves exactly like the 2012 version of newBuffer(), pushToBuffer()
+//   and friends.
+//
+// Author
+//   Daniel Wilkinson-Thompson (daniel@wilkinson-thompson.com)
+//
+// Date
+//   2012-08-10
+//
+// Licence
+//   Copyright (c) 2012 Daniel Wilkinson-Thompson. All rights reserved.
+//------------------------------------------------------------------------------
+
+#ifndef REFERENCE_H
+#define REFERENCE_H
+
+//------------------------------------------------------------------------------
+// Type definitions
+//------------------------------------------------------------------------------
+// -The original buffer_t layout, with absolute head and tail pointers
+typedef struct B_REFERENCE_BUFFER {
+    void *data;
+    void *head;
+    void *tail;
+    unsigned int depth;
+    unsigned char width;
+    union B_REFERENCE_BEHAVIOR {
+        unsigned char byte;
+        struct B_REFERENCE_BITS {
+            unsigned unused:6;
+            unsigned overwrite:1;
+            unsigned stack:1;
+        } bits;
+    } behavior;
+} referencebuffer_t;
+
+
+//------------------------------------------------------------------------------
+// Function prototypes
+//------------------------------------------------------------------------------
+referencebuffer_t* newReferenceBuffer(unsigned int numberOfElements, unsigned char elementSizeInBytes, unsigned char config);
+void freeReferenceBuffer(referencebuffer_t *b);
+unsigned char isReferenceBufferEmpty(referencebuffer_t *b);
+unsigned char isReferenceBufferFull(referencebuffer_t *b);
+unsigned int popFromReferenceBuffer(referencebuffer_t *b, void *d, unsigned int l);
+unsigned int pushToReferenceBuffer(referencebuffer_t *b, void *d, unsigned int l);
+
+#endif
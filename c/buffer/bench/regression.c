@@ -0,0 +1,359 @@
+//==============================================================================
+//                                regression.c
+//------------------------------------------------------------------------------
+// Brief
+//   Performance regression gate: checks buffer.c against the original
+//   byte-at-a-time implementation for identical results and a minimum speedup,
+//   and tinybuffer.c against it for identical results
+//
+// Description
+//   For every behaviour (B_FIFO/B_STACK with B_DROP/B_OVERWRITE):
+//   -Differential test, for every element width from 1 to 255 and depths 1,
+//    2, 5, 64 and 257: the same randomized sequence of pushes and pops, with
+//    lengths from 1 element to twice the depth, runs against buffer.c and
+//    reference.c. Every return value, every popped byte and isBufferEmpty()/
+//    isBufferFull() after every operation must match
+//   -Speedup, for widths 1, 2, 3, 4, 8, 16, 32, 64, 128 and 255 only: a
+//    sequence is replayed repeatedly on both implementations at the benchmark
+//    depth and the fastest time per operation compared. The case fails if
+//    reference time divided by buffer.c time is below the threshold (1.0 by
+//    default, i.e. no slower than the original)
+//   -Tiny buffers: the differential test also runs tinybuffer.c against
+//    reference.c, for every width from 1 to B_TINY_STORAGE and every capacity
+//    that fits in a tinybuffer_t
+//   A row is printed for each timed width; widths that are only checked and
+//   the tiny buffers report to stderr if they differ. The program exits with
+//   status 1 if any case fails, so it can gate a build.
+//   Build
+//      gcc -O2 -o regression regression.c reference.c bench.c ../buffer.c ../tinybuffer.c
+//   Run
+//      ./regression [--csv|--json] [--counters] [-s minimum speedup]
+//                   [-n operations] [-c checked operations] [-r repetitions]
+//                   [-d depth] [-S seed]
+//   -n sets the length of the timed sequence, and -c the length of each
+//   differential sequence
+//
+// Author
+//   Daniel Wilkinson-Thompson (daniel@wilkinson-thompson.com)
+//
+// Date
+//   2026-10-18
+//
+// Licence
+//   Copyright (c) 2026 Daniel Wilkinson-Thompson. All rights reserved.
+//------------------------------------------------------------------------------
+
+//------------------------------------------------------------------------------
+// Headers
+//------------------------------------------------------------------------------
+#include "bench.h"
+#include "reference.h"
+#include "../buffer.h"
+#include "../tinybuffer.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+//------------------------------------------------------------------------------
+// Type definitions
+//------------------------------------------------------------------------------
+typedef struct {
+    unsigned char push;
+    unsigned int length;
+    unsigned int offset;
+} operation_t;
+
+//------------------------------------------------------------------------------
+// Private variables
+//------------------------------------------------------------------------------
+static unsigned long long seed = 0x9E3779B97F4A7C15ULL;
+
+//------------------------------------------------------------------------------
+// Functions
+//------------------------------------------------------------------------------
+// xorshift64* random numbers, so runs are repeatable for a given seed
+unsigned long long randomNumber(void) {
+    seed ^= seed >> 12;
+    seed ^= seed << 25;
+    seed ^= seed >> 27;
+    return seed * 0x2545F4914F6CDD1DULL;
+}
+
+// Random sequence of operations for a buffer of the given depth
+// -Mostly short pushes and pops, with the occasional one longer than the
+//  whole buffer so that full, empty and overwrite paths are all exercised
+void randomOperations(operation_t *ops, unsigned int n, unsigned int depth) {
+    unsigned int i;
+
+    for (i = 0; i < n; i++) {
+        ops[i].push = randomNumber() & 1;
+        if ( (randomNumber() % 16) == 0 ) {
+            ops[i].length = 1 + randomNumber() % (2 * depth);
+        }
+        else {
+            ops[i].length = 1 + randomNumber() % 8;
+        }
+        ops[i].offset = randomNumber() % (2 * depth);
+    }
+}
+
+// Run the operations on both implementations
+// -The return value is the index of the first operation whose results
+//  differ, or n if none do
+unsigned int compareOperations(operation_t *ops, unsigned int n, unsigned int depth, unsigned char width, unsigned char config, unsigned char *input) {
+    referencebuffer_t *r;
+    buffer_t *b;
+    unsigned char *outR, *outB;
+    unsigned int i, failedR, failedB;
+
+    r = newReferenceBuffer(depth, width, config);
+    b = newBuffer(depth, width, config);
+    outR = malloc(2 * depth * width);
+    outB = malloc(2 * depth * width);
+    if ( !(r) || !(b) || !(outR) || !(outB) ) {
+        fprintf(stderr, "regression: out of memory\n");
+        exit(1);
+    }
+
+    for (i = 0; i < n; i++) {
+        if (ops[i].push) {
+            failedR = pushToReferenceBuffer(r, input + ops[i].offset * width, ops[i].length);
+            failedB = pushToBuffer(b, input + ops[i].offset * width, ops[i].length);
+        }
+        else {
+            failedR = popFromReferenceBuffer(r, outR, ops[i].length);
+            failedB = popFromBuffer(b, outB, ops[i].length);
+            if ( (failedR == failedB) && memcmp(outR, outB, (ops[i].length - failedR) * width) ) {
+                break;
+            }
+        }
+        if ( (failedR != failedB) ||
+             (isReferenceBufferEmpty(r) != isBufferEmpty(b)) ||
+             (isReferenceBufferFull(r) != isBufferFull(b)) ) {
+            break;
+        }
+    }
+
+    freeReferenceBuffer(r);
+    freeBuffer(b);
+    free(outR);
+    free(outB);
+    return i;
+}
+
+// Run the operations on a tiny buffer and the reference
+// -The return value is the index of the first operation whose results
+//  differ, or n if none do, or 0 if the tiny buffer could not be set up
+unsigned int compareTinyOperations(operation_t *ops, unsigned int n, unsigned int depth, unsigned char width, unsigned char config, unsigned char *input) {
+    referencebuffer_t *r;
+    tinybuffer_t t;
+    unsigned char *outR, *outT;
+    unsigned int i, failedR, failedT;
+
+    if ( initTinyBuffer(&t, depth, width, config) ) {
+        return 0;
+    }
+    r = newReferenceBuffer(depth, width, config);
+    outR = malloc(2 * depth * width);
+    outT = malloc(2 * depth * width);
+    if ( !(r) || !(outR) || !(outT) ) {
+        fprintf(stderr, "regression: out of memory\n");
+        exit(1);
+    }
+
+    for (i = 0; i < n; i++) {
+        if (ops[i].push) {
+            failedR = pushToReferenceBuffer(r, input + ops[i].offset * width, ops[i].length);
+            failedT = pushToTinyBuffer(&t, input + ops[i].offset * width, ops[i].length);
+        }
+        else {
+            failedR = popFromReferenceBuffer(r, outR, ops[i].length);
+            failedT = popFromTinyBuffer(&t, outT, ops[i].length);
+            if ( (failedR == failedT) && memcmp(outR, outT, (ops[i].length - failedR) * width) ) {
+                break;
+            }
+        }
+        if ( (failedR != failedT) ||
+             (isReferenceBufferEmpty(r) != isTinyBufferEmpty(&t)) ||
+             (isReferenceBufferFull(r) != isTinyBufferFull(&t)) ) {
+            break;
+        }
+    }
+
+    freeReferenceBuffer(r);
+    free(outR);
+    free(outT);
+    return i;
+}
+
+// Time the operations on one implementation
+// -The return value is nanoseconds per operation for the fastest repetition,
+//  which is far less noisy than the mean when the machine is busy
+double timeOperations(operation_t *ops, unsigned int n, unsigned int repetitions, unsigned int depth, unsigned char width, unsigned char config, unsigned char *input, unsigned char reference) {
+    referencebuffer_t *r = NULL;
+    buffer_t *b = NULL;
+    unsigned char *output;
+    unsigned int i, repetition;
+    double start, fastest = -1;
+
+    output = malloc(2 * depth * width);
+    if (reference) {
+        r = newReferenceBuffer(depth, width, config);
+    }
+    else {
+        b = newBuffer(depth, width, config);
+    }
+    if ( !(output) || (!(r) && !(b)) ) {
+        fprintf(stderr, "regression: out of memory\n");
+        exit(1);
+    }
+
+    for (repetition = 0; repetition < repetitions; repetition++) {
+        start = benchNanoseconds();
+        for (i = 0; i < n; i++) {
+            if (reference) {
+                if (ops[i].push) {
+                    pushToReferenceBuffer(r, input + ops[i].offset * width, ops[i].length);
+                }
+                else {
+                    popFromReferenceBuffer(r, output, ops[i].length);
+                }
+            }
+            else {
+                if (ops[i].push) {
+                    pushToBuffer(b, input + ops[i].offset * width, ops[i].length);
+                }
+                else {
+                    popFromBuffer(b, output, ops[i].length);
+                }
+            }
+        }
+        start = benchNanoseconds() - start;
+        if ( (fastest < 0) || (start < fastest) ) {
+            fastest = start;
+        }
+    }
+
+    if (reference) {
+        freeReferenceBuffer(r);
+    }
+    else {
+        freeBuffer(b);
+    }
+    free(output);
+    return fastest / n;
+}
+
+int main(int argc, char *argv[]) {
+    static const unsigned char timedWidths[] = {1, 2, 3, 4, 8, 16, 32, 64, 128, 255};
+    static const unsigned int depths[] = {1, 2, 5, 64, 257};
+    static const unsigned char configs[] = {B_FIFO & B_DROP, B_FIFO & B_OVERWRITE, B_STACK & B_DROP, B_STACK & B_OVERWRITE};
+    static const char *names[] = {"fifo-drop", "fifo-overwrite", "stack-drop", "stack-overwrite"};
+    unsigned int operations = 20000, checks = 4000, repetitions = 20, depth = 256, failures = 0;
+    unsigned int width, w, c, d, i, n, mismatch;
+    double threshold = 1.0, reference, current;
+    unsigned char *input, timed;
+    operation_t *ops;
+    int option;
+
+    argc = parseBenchOptions(argc, argv);
+    while ( (option = getopt(argc, argv, "s:n:c:r:d:S:")) != -1 ) {
+        switch (option) {
+            case 's': threshold = strtod(optarg, NULL); break;
+            case 'n': operations = strtoul(optarg, NULL, 0); break;
+            case 'c': checks = strtoul(optarg, NULL, 0); break;
+            case 'r': repetitions = strtoul(optarg, NULL, 0); break;
+            case 'd': depth = strtoul(optarg, NULL, 0); break;
+            case 'S': seed = strtoull(optarg, NULL, 0) | 1; break;
+            default:
+                fprintf(stderr, "usage: %s [--csv|--json] [--counters] [-s minimum speedup] [-n operations] [-c checked operations] [-r repetitions] [-d depth] [-S seed]\n", argv[0]);
+                return 1;
+        }
+    }
+
+    // Operations read their input from anywhere in a block of random bytes
+    // big enough for the longest push at the largest depth and width
+    d = (depth > depths[4]) ? depth : depths[4];
+    n = (operations > checks) ? operations : checks;
+    input = malloc(4 * d * 255);
+    ops = malloc(n * sizeof(operation_t));
+    if ( !(input) || !(ops) ) {
+        fprintf(stderr, "regression: out of memory\n");
+        return 1;
+    }
+    for (i = 0; i < 4 * d * 255; i++) {
+        input[i] = randomNumber();
+    }
+
+    for (width = 1; width <= 255; width++) {
+        timed = 0;
+        for (w = 0; w < sizeof(timedWidths); w++) {
+            timed |= (timedWidths[w] == width);
+        }
+        for (c = 0; c < sizeof(configs); c++) {
+
+            // Differential test at every depth
+            mismatch = 0;
+            for (d = 0; d < sizeof(depths) / sizeof(depths[0]); d++) {
+                randomOperations(ops, checks, depths[d]);
+                i = compareOperations(ops, checks, depths[d], width, configs[c], input);
+                if (i < checks) {
+                    fprintf(stderr, "regression: %s width %u depth %u differs from reference at operation %u (%s %u)\n",
+                            names[c], width, depths[d], i, ops[i].push ? "push" : "pop", ops[i].length);
+                    mismatch = 1;
+                }
+            }
+            if ( !(timed) ) {
+                failures += mismatch;
+                continue;
+            }
+
+            // Speedup at the benchmark depth
+            randomOperations(ops, operations, depth);
+            reference = timeOperations(ops, operations, repetitions, depth, width, configs[c], input, 1);
+            startBenchCounters();
+            current = timeOperations(ops, operations, repetitions, depth, width, configs[c], input, 0);
+            stopBenchCounters();
+
+            beginBenchRow();
+            addBenchText("benchmark", "regression");
+            addBenchText("variant", names[c]);
+            addBenchNumber("width", width);
+            addBenchNumber("depth", depth);
+            addBenchNumber("reference_ns_per_op", reference);
+            addBenchNumber("current_ns_per_op", current);
+            addBenchNumber("speedup", reference / current);
+            addBenchText("identical", mismatch ? "no" : "yes");
+            addBenchText("result", (mismatch || (reference / current < threshold)) ? "FAIL" : "pass");
+            addBenchCounters((unsigned long)operations * repetitions);
+            endBenchRow();
+            failures += (mismatch || (reference / current < threshold));
+        }
+    }
+
+    // Tiny buffers: differential test at every width and capacity that fits
+    for (width = 1; width <= B_TINY_STORAGE; width++) {
+        for (c = 0; c < sizeof(configs); c++) {
+            mismatch = 0;
+            for (d = 1; d <= TINY_BUFFER_CAPACITY(width); d++) {
+                randomOperations(ops, checks, d);
+                i = compareTinyOperations(ops, checks, d, width, configs[c], input);
+                if (i < checks) {
+                    fprintf(stderr, "regression: tiny %s width %u depth %u differs from reference at operation %u (%s %u)\n",
+                            names[c], width, d, i, ops[i].push ? "push" : "pop", ops[i].length);
+                    mismatch = 1;
+                }
+            }
+            failures += mismatch;
+        }
+    }
+
+    free(input);
+    free(ops);
+    if (failures) {
+        fprintf(stderr, "regression: %u cases failed (minimum speedup %.2f)\n", failures, threshold);
+        return 1;
+    }
+    return 0;
+}
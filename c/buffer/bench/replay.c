@@ -0,0 +1,233 @@
+//==============================================================================
+//                                  replay.c
+//------------------------------------------------------------------------------
+// Brief
+//   Compares replaying unacknowledged elements from a replay buffer against
+//   keeping a copy of them beside a buffer_t
+//
+// Description
+//   A producer pushes 8-byte sequence numbers and a consumer delivers them
+//   downstream in batches of 64. Downstream acknowledges every 16 batches,
+//   and now and then fails, losing what it took since its last
+//   acknowledgement, which must then be delivered again:
+//   -buffer_t + copy: popFromBuffer() gets a batch, which is also pushed to a
+//    second buffer_t of unacknowledged elements. An acknowledgement empties
+//    that, and a failure delivers it again before going on
+//   -replaybuffer: popFromReplayBuffer() gets a batch, an acknowledgement is
+//    commitReplayBuffer() and a failure seekReplayBuffer() back to the commit
+//   Downstream checks that what it keeps is every number exactly once and in
+//   order.
+//   Build
+//      gcc -O2 -o replay replay.c bench.c ../buffer.c ../replaybuffer.c
+//   Run
+//      ./replay [--csv|--json] [--counters] [elements] [failure_one_in]
+//
+// Author
+//   Daniel Wilkinson-Thompson (daniel@wilkinson-thompson.com)
+//
+// Date
+//   2026-10-18
+//
+// Licence
+//   Copyright (c) 2026 Daniel Wilkinson-Thompson. All rights reserved.
+//------------------------------------------------------------------------------
+
+//------------------------------------------------------------------------------
+// Headers
+//------------------------------------------------------------------------------
+#include "bench.h"
+#include "../buffer.h"
+#include "../replaybuffer.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+//------------------------------------------------------------------------------
+// Constants
+//------------------------------------------------------------------------------
+#define BATCH               64
+#define BATCHES_PER_ACK     16
+#define DEPTH               (4 * BATCH * BATCHES_PER_ACK)
+
+//------------------------------------------------------------------------------
+// Type definitions
+//------------------------------------------------------------------------------
+// Downstream: what it has kept, and what it was sent in all
+typedef struct {
+    unsigned long expected;
+    unsigned long acknowledged;
+    unsigned long batches;
+    unsigned long delivered;
+    unsigned long failures;
+    unsigned long wrong;
+    unsigned long failOneIn;
+    unsigned long seed;
+} downstream_t;
+
+//------------------------------------------------------------------------------
+// Functions
+//------------------------------------------------------------------------------
+// Deliver a batch
+// -The return value is 1 if downstream failed and lost everything since its
+//  last acknowledgement, 2 if it acknowledged everything so far, otherwise 0
+unsigned char deliver(downstream_t *s, unsigned long *batch, unsigned int n) {
+    unsigned int i;
+
+    s->delivered += n;
+    s->seed = s->seed * 6364136223846793005UL + 1442695040888963407UL;
+    if ((s->seed >> 33) % s->failOneIn == 0) {
+        s->expected = s->acknowledged;
+        s->batches = 0;
+        s->failures++;
+        return 1;
+    }
+    for (i = 0; i < n; i++) {
+        s->wrong += (batch[i] != s->expected++);
+    }
+    if (++(s->batches) == BATCHES_PER_ACK) {
+        s->acknowledged = s->expected;
+        s->batches = 0;
+        return 2;
+    }
+    return 0;
+}
+
+// Run with a buffer_t and a second one holding unacknowledged copies
+void runCopy(unsigned long elements, downstream_t *s) {
+    unsigned long batch[BATCH], pushed = 0, i;
+    buffer_t *b, *unacknowledged;
+    buffersegment_t seg[2];
+    unsigned int n, j, k, m, sent;
+    unsigned char result;
+
+    b = newBuffer(DEPTH, sizeof(unsigned long), B_FIFO & B_DROP);
+    unacknowledged = newBuffer(BATCH * BATCHES_PER_ACK, sizeof(unsigned long), B_FIFO & B_DROP);
+    if ( !(b) || !(unacknowledged) ) {
+        fprintf(stderr, "replay: out of memory\n");
+        exit(1);
+    }
+    while (s->acknowledged < elements) {
+        for (i = 0; (i < BATCH) && (pushed < elements); i++, pushed++) {
+            if (pushToBuffer(b, &pushed, 1)) {
+                break;
+            }
+        }
+        n = BATCH - popFromBuffer(b, batch, BATCH);
+        if (n == 0) {
+            break;
+        }
+        pushToBuffer(unacknowledged, batch, n);
+        result = deliver(s, batch, n);
+        if (result == 2) {
+            discardFromBuffer(unacknowledged, BATCH * BATCHES_PER_ACK);
+        }
+
+        // Deliver the copies again, until downstream gets through them. The
+        // copies wrap round, so downstream may see the batches split
+        // differently and acknowledge part way through
+        while (result == 1) {
+            peekBuffer(unacknowledged, seg);
+            sent = 0;
+            result = 0;
+            for (j = 0; (j < 2) && (result != 1); j++) {
+                for (k = 0; (k < seg[j].count) && (result != 1); k += m) {
+                    m = (seg[j].count - k < BATCH) ? seg[j].count - k : BATCH;
+                    result = deliver(s, (unsigned long*)seg[j].data + k, m);
+                    sent += m;
+                    if (result == 2) {
+                        discardFromBuffer(unacknowledged, sent);
+                        sent = 0;
+                    }
+                }
+            }
+        }
+        // The last, short run of batches is acknowledged when it ends
+        if ( (pushed == elements) && isBufferEmpty(b) ) {
+            s->acknowledged = s->expected;
+        }
+    }
+    freeBuffer(unacknowledged);
+    freeBuffer(b);
+}
+
+// Run with a replay buffer
+void runReplay(unsigned long elements, downstream_t *s) {
+    unsigned long batch[BATCH], pushed = 0, i;
+    unsigned long long first;
+    replaybuffer_t *b;
+    unsigned int n;
+    unsigned char result;
+
+    b = newReplayBuffer(DEPTH, sizeof(unsigned long));
+    if ( !(b) ) {
+        fprintf(stderr, "replay: out of memory\n");
+        exit(1);
+    }
+    while (s->acknowledged < elements) {
+        for (i = 0; (i < BATCH) && (pushed < elements); i++, pushed++) {
+            if (pushToReplayBuffer(b, &pushed, 1)) {
+                break;
+            }
+        }
+        n = BATCH - popFromReplayBuffer(b, batch, BATCH, &first);
+        if (n == 0) {
+            break;
+        }
+        result = deliver(s, batch, n);
+        if (result == 1) {
+            seekReplayBuffer(b, b->committed);
+        }
+        else if (result == 2) {
+            commitReplayBuffer(b, first + n);
+        }
+        if ( (pushed == elements) && isReplayBufferEmpty(b) ) {
+            s->acknowledged = s->expected;
+        }
+    }
+    freeReplayBuffer(b);
+}
+
+int main(int argc, char *argv[]) {
+    static const char *variants[] = {"buffer_t + copy", "replaybuffer"};
+    unsigned long elements, failOneIn;
+    unsigned int v, errors = 0;
+    unsigned char wrong;
+    downstream_t s;
+    double ns;
+
+    argc = parseBenchOptions(argc, argv);
+    elements = (argc > 1) ? strtoul(argv[1], NULL, 0) : 20000000;
+    failOneIn = (argc > 2) ? strtoul(argv[2], NULL, 0) : 1000;
+
+    for (v = 0; v < 2; v++) {
+        s = (downstream_t){ .failOneIn = failOneIn ? failOneIn : 1, .seed = 1 };
+        startBenchCounters();
+        ns = benchNanoseconds();
+        if (v) {
+            runReplay(elements, &s);
+        }
+        else {
+            runCopy(elements, &s);
+        }
+        ns = benchNanoseconds() - ns;
+        stopBenchCounters();
+        wrong = (s.wrong != 0) || (s.expected != elements);
+        errors += wrong;
+
+        beginBenchRow();
+        addBenchText("benchmark", "replay");
+        addBenchText("variant", variants[v]);
+        addBenchNumber("elements", elements);
+        addBenchNumber("failures", s.failures);
+        addBenchNumber("delivered_per_element", (double)s.delivered / elements);
+        addBenchNumber("ns_per_element", ns / elements);
+        addBenchText("order_kept", wrong ? "no" : "yes");
+        addBenchCounters(elements);
+        endBenchRow();
+    }
+
+    if (errors) {
+        fprintf(stderr, "replay: %u variants lost, repeated or reordered elements\n", errors);
+        return 1;
+    }
+    return 0;
+}
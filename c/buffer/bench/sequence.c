@@ -0,0 +1,241 @@
+//==============================================================================
+//                                 sequence.c
+//------------------------------------------------------------------------------
+// Brief
+//   Checks that consumers can count lost elements from sequence numbers, and
+//   measures what popSequencedFromBuffer() costs over popFromBuffer()
+//
+// Description
+//   A producer pushes its running count in bursts of 1 to 256 elements into a
+//   FIFO buffer of 1024, and a consumer that keeps up with only about two
+//   thirds of them pops batches of 64:
+//   -popFromBuffer: the consumer checks that what it gets keeps its order
+//   -popSequencedFromBuffer: the consumer adds up the jumps between batches
+//    as lost, and checks each element against its sequence number
+//   Either way the jumps must add up to exactly what was pushed and never
+//   popped: overwritten with B_OVERWRITE, refused with B_DROP. With
+//   B_OVERWRITE every element must be its own sequence number; with B_DROP,
+//   which numbers elements kept behind a second run of refusals low (see
+//   buffer.h), no number may be above the element's own.
+//   Before that, short scripts of pushes and pops on a buffer of 4 check the
+//   numbers of elements queued ahead of a refusal, behind it, and after a
+//   second one that comes while the first is still queued, with
+//   pushToBuffer() and popSequencedFromBuffer(), and with BUFFER_PUSH and
+//   BUFFER_POP.
+//   Build
+//      gcc -O2 -o sequence sequence.c bench.c ../buffer.c
+//   Run
+//      ./sequence [--csv|--json] [--counters] [elements]
+//
+// Author
+//   Daniel Wilkinson-Thompson (daniel@wilkinson-thompson.com)
+//
+// Date
+//   2026-10-18
+//
+// Licence
+//   Copyright (c) 2026 Daniel Wilkinson-Thompson. All rights reserved.
+//------------------------------------------------------------------------------
+
+//------------------------------------------------------------------------------
+// Headers
+//------------------------------------------------------------------------------
+#include "bench.h"
+#include "../buffer.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+//------------------------------------------------------------------------------
+// Constants
+//------------------------------------------------------------------------------
+#define DEPTH               1024
+#define BATCH               64
+#define BURST               256
+#define SCRIPT_DEPTH        4
+
+//------------------------------------------------------------------------------
+// Type definitions
+//------------------------------------------------------------------------------
+// What a run has seen
+typedef struct {
+    unsigned long pushed;
+    unsigned long refused;
+    unsigned long popped;
+    unsigned long lost;
+    unsigned long wrong;
+} run_t;
+
+//------------------------------------------------------------------------------
+// Functions
+//------------------------------------------------------------------------------
+// Run a script on a B_DROP FIFO buffer of SCRIPT_DEPTH elements: a positive
+// step pushes that many elements, a negative one pops that many, one at a
+// time, until a pop fails
+// -Each element holds its sequence number. Every element popped must come
+//  with that number, and with BUFFER_POP, bufferSequence() before the pop
+//  must give it
+// -The return value is the number of elements popped with the wrong number
+unsigned int runScript(const int *steps, unsigned int n, unsigned char declared) {
+    BUFFER_DECLARE_LOCAL(q, SCRIPT_DEPTH, sizeof(unsigned long), B_FIFO & B_DROP);
+    unsigned long in[SCRIPT_DEPTH * 4], out, next = 0;
+    unsigned long long first;
+    unsigned int i, j, wrong = 0;
+    int k;
+
+    for (i = 0; i < n; i++) {
+        for (k = 0; k < steps[i]; k++) {
+            in[k] = next++;
+        }
+        if (steps[i] > 0) {
+            if (declared) {
+                BUFFER_PUSH(q, in, steps[i]);
+            }
+            else {
+                pushToBuffer(q, in, steps[i]);
+            }
+        }
+        for (k = 0; k < -steps[i]; k++) {
+            if (declared) {
+                first = bufferSequence(q);
+                j = BUFFER_POP(q, &out, 1);
+            }
+            else {
+                j = popSequencedFromBuffer(q, &out, 1, &first);
+            }
+            if (j) {
+                break;
+            }
+            wrong += (out != first);
+        }
+    }
+    return wrong;
+}
+
+// Push and pop elements, with or without sequence numbers
+// -Each element holds the count of elements pushed before it, accepted or
+//  not, which is its sequence number
+void runSequence(unsigned char config, unsigned char sequenced, unsigned long elements, run_t *r) {
+    unsigned long burst[BURST], batch[BATCH], seed = 1, expected = 0, previous = 0;
+    unsigned char overwrite = ( (config & (unsigned char)~B_DROP) != 0 );
+    unsigned long long first;
+    unsigned int i, j, n, length;
+    buffer_t *b;
+
+    b = newBuffer(DEPTH, sizeof(unsigned long), config);
+    if ( !(b) ) {
+        fprintf(stderr, "sequence: out of memory\n");
+        exit(1);
+    }
+    while (r->pushed < elements) {
+        seed = seed * 6364136223846793005UL + 1442695040888963407UL;
+        length = 1 + (seed >> 33) % BURST;
+        for (i = 0; i < length; i++) {
+            burst[i] = r->pushed + i;
+        }
+        r->refused += pushToBuffer(b, burst, length);
+        r->pushed += length;
+
+        // Two batches of 64 for every three of the average burst of 128.5
+        for (i = 0; i < 2 * length / 3; i += BATCH) {
+            if (sequenced) {
+                n = BATCH - popSequencedFromBuffer(b, batch, BATCH, &first);
+                if (n) {
+                    r->lost += first - expected;
+                    expected = first + n;
+                }
+                for (j = 0; j < n; j++) {
+                    r->wrong += overwrite ? (batch[j] != first + j) : (batch[j] < first + j);
+                }
+            }
+            else {
+                n = BATCH - popFromBuffer(b, batch, BATCH);
+                for (j = 0; j < n; j++) {
+                    r->wrong += (batch[j] < previous);
+                    previous = batch[j];
+                }
+            }
+            r->popped += n;
+        }
+    }
+
+    // Pop whatever is left
+    while ( (n = BATCH - popSequencedFromBuffer(b, batch, BATCH, &first)) ) {
+        if (sequenced) {
+            r->lost += first - expected;
+            expected = first + n;
+        }
+        r->popped += n;
+    }
+
+    // Elements refused after the last one popped show up only in the number
+    // the next push would get
+    if (sequenced) {
+        r->lost += bufferSequence(b) - expected;
+    }
+    freeBuffer(b);
+}
+
+int main(int argc, char *argv[]) {
+    // Two queued when 8 more come, of which 3 fit: the first queued is popped
+    // before and the second after, and then the rest
+    static const int refusedBehind[] = {2, -1, 8, -1, -3, 1, -1};
+    // Full, one refused, one popped, one kept behind the refusal and one more
+    // refused, which comes after it once the first refusal is popped past.
+    // Then everything popped, one pushed and popped, and a last burst
+    static const int refusedTwice[] = {4, 1, -1, 1, 1, -3, -1, 1, -1, 7, -9};
+    static const char *configs[] = {"B_OVERWRITE", "B_DROP"};
+    static const char *variants[] = {"popFromBuffer", "popSequencedFromBuffer"};
+    unsigned long elements, missing;
+    unsigned int c, v, errors = 0;
+    unsigned char wrong;
+    run_t r;
+    double ns;
+
+    argc = parseBenchOptions(argc, argv);
+    elements = (argc > 1) ? strtoul(argv[1], NULL, 0) : 50000000;
+
+    for (v = 0; v < 2; v++) {
+        if ( runScript(refusedBehind, sizeof(refusedBehind) / sizeof(refusedBehind[0]), v) ||
+             runScript(refusedTwice, sizeof(refusedTwice) / sizeof(refusedTwice[0]), v) ) {
+            fprintf(stderr, "sequence: an element queued next to a refusal was misnumbered with %s\n",
+                    v ? "BUFFER_PUSH/BUFFER_POP" : "pushToBuffer()");
+            errors++;
+        }
+    }
+
+    for (c = 0; c < 2; c++) {
+        for (v = 0; v < 2; v++) {
+            r = (run_t){0};
+            startBenchCounters();
+            ns = benchNanoseconds();
+            runSequence(c ? (B_FIFO & B_DROP) : (B_FIFO & B_OVERWRITE), v, elements, &r);
+            ns = benchNanoseconds() - ns;
+            stopBenchCounters();
+
+            // Elements pushed but never popped: overwritten, or refused
+            missing = r.pushed - r.popped;
+            wrong = (r.wrong != 0) || (v && (r.lost != missing));
+            errors += wrong;
+
+            beginBenchRow();
+            addBenchText("benchmark", "sequence");
+            addBenchText("config", configs[c]);
+            addBenchText("variant", variants[v]);
+            addBenchNumber("pushed", r.pushed);
+            addBenchNumber("popped", r.popped);
+            addBenchNumber("never_popped", missing);
+            addBenchNumber("refused_at_push", r.refused);
+            addBenchNumber("lost_by_sequence", r.lost);
+            addBenchNumber("ns_per_pushed_element", ns / r.pushed);
+            addBenchText("loss_exact", wrong ? "no" : "yes");
+            addBenchCounters(r.pushed);
+            endBenchRow();
+        }
+    }
+
+    if (errors) {
+        fprintf(stderr, "sequence: %u runs miscounted lost elements\n", errors);
+        return 1;
+    }
+    return 0;
+}
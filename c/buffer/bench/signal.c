@@ -0,0 +1,198 @@
+//==============================================================================
+//                                  signal.c
+//------------------------------------------------------------------------------
+// Brief
+//   Checks that pushes to a signal buffer from a signal handler that
+//   interrupts another push leave every record whole and in order
+//
+// Description
+//   The main thread pushes records to a signal buffer as fast as it can and
+//   drains it now and then, while an interval timer raises SIGALRM every few
+//   microseconds and the handler pushes a record of its own. A flag set
+//   around the main thread's pushToSignalBuffer() call counts the signals
+//   that arrived part way through one.
+//   Each record holds a header element (the pusher, the record's number and
+//   its length), then elements derived from the number, and is 1 to 16
+//   elements long. Every popped record must be whole, and each pusher's
+//   records must come out in the order it pushed them, none missing except
+//   those whose push reported failure: the consumer takes records in the
+//   order they claimed space, so a record that interrupted another comes
+//   out after it, even though it was committed first.
+//   Build
+//      gcc -O2 -o signal signal.c bench.c ../signalbuffer.c
+//   Run
+//      ./signal [--csv|--json] [--counters] [seconds] [interval_us]
+//
+// Author
+//   Daniel Wilkinson-Thompson (daniel@wilkinson-thompson.com)
+//
+// Date
+//   2026-10-18
+//
+// Licence
+//   Copyright (c) 2026 Daniel Wilkinson-Thompson. All rights reserved.
+//------------------------------------------------------------------------------
+
+//------------------------------------------------------------------------------
+// Headers
+//------------------------------------------------------------------------------
+#include "bench.h"
+#include "../signalbuffer.h"
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/time.h>
+
+//------------------------------------------------------------------------------
+// Constants
+//------------------------------------------------------------------------------
+#define DEPTH               4096
+#define LONGEST             16
+#define PUSHERS             2
+
+//------------------------------------------------------------------------------
+// Global variables
+//------------------------------------------------------------------------------
+// Shared with the handler
+signalbuffer_t *records;
+volatile sig_atomic_t inPush;
+volatile unsigned long interrupted;
+volatile unsigned long pushed[PUSHERS];
+volatile unsigned long failed[PUSHERS];
+
+//------------------------------------------------------------------------------
+// Functions
+//------------------------------------------------------------------------------
+// Fill a record: header, then elements derived from its number
+unsigned int makeRecord(unsigned long *r, unsigned long pusher, unsigned long number) {
+    unsigned int length = 1 + (number * 7 + pusher) % LONGEST, i;
+
+    r[0] = (pusher << 56) | ((unsigned long)length << 48) | number;
+    for (i = 1; i < length; i++) {
+        r[i] = number * 2654435761UL + i;
+    }
+    return length;
+}
+
+// Push one record from the pusher given
+void pushRecord(unsigned long pusher) {
+    unsigned long r[LONGEST];
+    unsigned int length;
+
+    length = makeRecord(r, pusher, pushed[pusher] + failed[pusher]);
+    inPush = (pusher == 0);
+    length = pushToSignalBuffer(records, r, length);
+    inPush = 0;
+    if (length) {
+        failed[pusher]++;
+    }
+    else {
+        pushed[pusher]++;
+    }
+}
+
+// Timer handler: push a record, interrupting whatever the main thread does
+void onAlarm(int signal) {
+    (void)signal;
+    interrupted += inPush;
+    pushRecord(1);
+}
+
+// Pop every committed record, checking each one
+// -next[pusher] is the number of the next record expected from it; numbers
+//  whose push failed are skipped over by the caller's failure count
+void drainRecords(unsigned long *next, unsigned long *popped, unsigned long *broken, unsigned long *skipped) {
+    unsigned long r[LONGEST], expected[LONGEST], pusher, number;
+    unsigned int n, length, i;
+
+    while ( (n = popRecordFromSignalBuffer(records, r, LONGEST)) ) {
+        pusher = r[0] >> 56;
+        length = (r[0] >> 48) & 0xFF;
+        number = r[0] & 0xFFFFFFFFFFFFUL;
+        if ( (pusher >= PUSHERS) || (length != n) || (number < next[pusher]) ) {
+            (*broken)++;
+            continue;
+        }
+        makeRecord(expected, pusher, number);
+        for (i = 0; i < n; i++) {
+            *broken += (r[i] != expected[i]);
+        }
+        *skipped += number - next[pusher];
+        next[pusher] = number + 1;
+        (*popped)++;
+    }
+}
+
+int main(int argc, char *argv[]) {
+    unsigned long next[PUSHERS] = {0}, popped = 0, broken = 0, skipped = 0, i;
+    struct itimerval timer = {{0, 0}, {0, 0}};
+    struct sigaction action;
+    double seconds, interval, ns, end;
+    sigset_t alarm;
+
+    argc = parseBenchOptions(argc, argv);
+    seconds = (argc > 1) ? atof(argv[1]) : 2;
+    interval = (argc > 2) ? atof(argv[2]) : 10;
+
+    records = newSignalBuffer(DEPTH, sizeof(unsigned long));
+    if ( !(records) ) {
+        fprintf(stderr, "signal: out of memory\n");
+        return 1;
+    }
+    action.sa_handler = onAlarm;
+    action.sa_flags = SA_RESTART;
+    sigemptyset(&(action.sa_mask));
+    sigaction(SIGALRM, &action, NULL);
+    sigemptyset(&alarm);
+    sigaddset(&alarm, SIGALRM);
+    timer.it_interval.tv_usec = (long)interval;
+    timer.it_value.tv_usec = (long)interval;
+
+    startBenchCounters();
+    ns = benchNanoseconds();
+    end = ns + seconds * 1e9;
+    setitimer(ITIMER_REAL, &timer, NULL);
+    while (benchNanoseconds() < end) {
+        for (i = 0; i < 64; i++) {
+            pushRecord(0);
+        }
+        drainRecords(next, &popped, &broken, &skipped);
+    }
+
+    // Stop the timer, and let no late signal in while the last records drain
+    timer.it_interval.tv_usec = 0;
+    timer.it_value.tv_usec = 0;
+    setitimer(ITIMER_REAL, &timer, NULL);
+    sigprocmask(SIG_BLOCK, &alarm, NULL);
+    drainRecords(next, &popped, &broken, &skipped);
+    ns = benchNanoseconds() - ns;
+    stopBenchCounters();
+
+    // Every record was popped or failed, and only failed ones were skipped
+    skipped += (pushed[0] + failed[0] - next[0]) + (pushed[1] + failed[1] - next[1]);
+    broken += (popped != pushed[0] + pushed[1]) || (skipped != failed[0] + failed[1]);
+
+    beginBenchRow();
+    addBenchText("benchmark", "signal");
+    addBenchNumber("seconds", ns / 1e9);
+    addBenchNumber("thread_records", pushed[0]);
+    addBenchNumber("handler_records", pushed[1]);
+    addBenchNumber("failed_pushes", failed[0] + failed[1]);
+    addBenchNumber("pushes_interrupted", interrupted);
+    addBenchNumber("records_popped", popped);
+    addBenchNumber("ns_per_record", ns / (popped ? popped : 1));
+    addBenchText("records_whole_in_order", broken ? "no" : "yes");
+    addBenchCounters(popped);
+    endBenchRow();
+    freeSignalBuffer(records);
+
+    if (broken) {
+        fprintf(stderr, "signal: records were broken, lost or out of order\n");
+        return 1;
+    }
+    if (interrupted == 0) {
+        fprintf(stderr, "signal: no push was interrupted; run longer or with a shorter interval\n");
+        return 1;
+    }
+    return 0;
+}
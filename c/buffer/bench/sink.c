@@ -0,0 +1,239 @@
+//==============================================================================
+//                                   sink.c
+//------------------------------------------------------------------------------
+// Brief
+//   Compares persisting small records with a write() each against a sink
+//   that writes them out a megabyte at a time
+//
+// Description
+//   Each variant writes the same stream of 100-byte records to a file:
+//   -write: one write() per record, as a persistence thread popping records
+//    from a buffer_t one at a time does
+//   -writeToSink: a sink of 512 pages flushing every megabyte
+//   -writeToSink+O_DIRECT: the same with the file opened O_DIRECT, skipped if
+//    the file system refuses it
+//   and does so twice, once leaving the data in the page cache and once
+//   making it durable with fdatasync() after every megabyte. syscalls counts
+//   the writes and syncs made. The file is read back after each run and
+//   compared with the stream.
+//   Last, an O_DIRECT sink is given one record shorter than a page and left
+//   idle, calling only checkSink(), which must write the record out once it
+//   is flushAge old.
+//   Build
+//      gcc -O2 -o sink sink.c bench.c ../buffer.c ../bufferio.c ../buffersink.c
+//   Run
+//      ./sink [--csv|--json] [--counters] [records] [file]
+//   The file (default sink.dat in the current directory) is created, and
+//   removed afterwards
+//
+// Author
+//   Daniel Wilkinson-Thompson (daniel@wilkinson-thompson.com)
+//
+// Date
+//   2026-10-18
+//
+// Licence
+//   Copyright (c) 2026 Daniel Wilkinson-Thompson. All rights reserved.
+//------------------------------------------------------------------------------
+
+//------------------------------------------------------------------------------
+// Headers
+//------------------------------------------------------------------------------
+#define _GNU_SOURCE
+#include "bench.h"
+#include "../buffer.h"
+#include "../buffersink.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+//------------------------------------------------------------------------------
+// Constants
+//------------------------------------------------------------------------------
+#define RECORD_BYTES        100
+#define SINK_PAGES          512
+#define FLUSH_BYTES         (1UL << 20)
+#define IDLE_BYTES          600
+#define IDLE_AGE_MS         10
+#define IDLE_WAIT_MS        150
+
+//------------------------------------------------------------------------------
+// Functions
+//------------------------------------------------------------------------------
+// Fill in record number i of the stream
+void makeRecord(unsigned char *record, unsigned long i) {
+    unsigned int j;
+
+    memcpy(record, &i, sizeof(i));
+    for (j = sizeof(i); j < RECORD_BYTES; j++) {
+        record[j] = i * 31 + j;
+    }
+}
+
+// Read the file back and compare it with the stream
+// -The return value is 1 if it differs
+unsigned char checkFile(const char *name, unsigned long records) {
+    unsigned char record[RECORD_BYTES], got[RECORD_BYTES];
+    unsigned long i;
+    FILE *f;
+
+    f = fopen(name, "rb");
+    if ( !(f) ) {
+        return 1;
+    }
+    for (i = 0; i < records; i++) {
+        makeRecord(record, i);
+        if ( (fread(got, RECORD_BYTES, 1, f) != 1) || memcmp(got, record, RECORD_BYTES) ) {
+            fclose(f);
+            return 1;
+        }
+    }
+    i = (fread(got, 1, 1, f) != 0);
+    fclose(f);
+    return i;
+}
+
+// Write the stream one way
+// -The return value is -1 if the file can't be opened that way, 1 if a write
+//  failed, otherwise 0
+int runSink(unsigned int variant, unsigned char durable, const char *name, unsigned long records,
+            double *ns, unsigned long *calls) {
+    unsigned char record[RECORD_BYTES];
+    unsigned long i, written = 0;
+    sink_t *s = NULL;
+    int fd, failed = 0;
+
+    fd = open(name, O_WRONLY | O_CREAT | O_TRUNC | ((variant == 2) ? O_DIRECT : 0), 0600);
+    if (fd < 0) {
+        return -1;
+    }
+    if (variant) {
+        s = newSink(fd, SINK_PAGES, FLUSH_BYTES, 0, durable ? FLUSH_BYTES : 0);
+        if ( !(s) ) {
+            fprintf(stderr, "sink: out of memory\n");
+            exit(1);
+        }
+    }
+    *calls = 0;
+
+    *ns = benchNanoseconds();
+    for (i = 0; i < records; i++) {
+        makeRecord(record, i);
+        if (s) {
+            failed |= writeToSink(s, record, RECORD_BYTES);
+            continue;
+        }
+        failed |= (write(fd, record, RECORD_BYTES) != RECORD_BYTES);
+        written += RECORD_BYTES;
+        *calls += 1;
+        if ( durable && (written >= FLUSH_BYTES) ) {
+            failed |= fdatasync(fd);
+            written = 0;
+            *calls += 1;
+        }
+    }
+    if (s) {
+        failed |= durable ? syncSink(s) : (flushSink(s) < 0);
+        *calls = s->writes + s->syncs;
+    }
+    else if (durable) {
+        failed |= fdatasync(fd);
+        *calls += 1;
+    }
+    *ns = benchNanoseconds() - *ns;
+
+    if (s) {
+        freeSink(s);
+    }
+    close(fd);
+    return failed != 0;
+}
+
+// Leave an O_DIRECT sink idle with part of a page in it, calling only
+// checkSink(), as the sink's header says is enough
+// -The return value is -1 if the file can't be opened O_DIRECT, 1 if the
+//  record wasn't written out in time, otherwise 0
+int runIdleSink(const char *name) {
+    unsigned char record[IDLE_BYTES] = {0};
+    struct timespec wait = {0, 1000000};
+    unsigned int ms;
+    struct stat st;
+    sink_t *s;
+    int fd, failed;
+
+    fd = open(name, O_WRONLY | O_CREAT | O_TRUNC | O_DIRECT, 0600);
+    if (fd < 0) {
+        return -1;
+    }
+    s = newSink(fd, 4, 512, IDLE_AGE_MS, 0);
+    if ( !(s) ) {
+        fprintf(stderr, "sink: out of memory\n");
+        exit(1);
+    }
+    failed = (writeToSink(s, record, IDLE_BYTES) < 0);
+    for (ms = 0; ms < IDLE_WAIT_MS; ms++) {
+        failed |= (checkSink(s) < 0);
+        nanosleep(&wait, NULL);
+    }
+    failed |= fstat(fd, &st) || (st.st_size != IDLE_BYTES);
+    freeSink(s);
+    close(fd);
+    return failed != 0;
+}
+
+int main(int argc, char *argv[]) {
+    static const char *variants[] = {"write", "writeToSink", "writeToSink+O_DIRECT"};
+    unsigned long records, calls;
+    unsigned int v, errors = 0;
+    unsigned char durable, wrong;
+    const char *name;
+    double ns;
+    int result;
+
+    argc = parseBenchOptions(argc, argv);
+    records = (argc > 1) ? strtoul(argv[1], NULL, 0) : 1000000;
+    name = (argc > 2) ? argv[2] : "sink.dat";
+
+    for (durable = 0; durable < 2; durable++) {
+        for (v = 0; v < 3; v++) {
+            startBenchCounters();
+            result = runSink(v, durable, name, records, &ns, &calls);
+            stopBenchCounters();
+            if (result < 0) {
+                fprintf(stderr, "sink: can't open %s for %s: %s\n", name, variants[v], strerror(errno));
+                continue;
+            }
+            wrong = result || checkFile(name, records);
+            errors += wrong;
+
+            beginBenchRow();
+            addBenchText("benchmark", "sink");
+            addBenchText("variant", variants[v]);
+            addBenchText("durable", durable ? "yes" : "no");
+            addBenchNumber("records", records);
+            addBenchNumber("ns_per_record", ns / records);
+            addBenchNumber("mb_per_second", records * RECORD_BYTES / ns * 1e3);
+            addBenchNumber("syscalls", calls);
+            addBenchText("bytes_match", wrong ? "no" : "yes");
+            addBenchCounters(records);
+            endBenchRow();
+        }
+    }
+    result = runIdleSink(name);
+    unlink(name);
+
+    if (errors) {
+        fprintf(stderr, "sink: %u variants wrote the wrong file\n", errors);
+        return 1;
+    }
+    if (result > 0) {
+        fprintf(stderr, "sink: an idle O_DIRECT sink never wrote out its last page\n");
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,320 @@
+//==============================================================================
+//                                  splice.c
+//------------------------------------------------------------------------------
+// Brief
+//   Compares CPU time per forwarded gigabyte for copying through a ring with
+//   write()/read() and for the zero-copy paths in bufferio.c
+//
+// Description
+//   -ring to pipe: a page buffer is filled in place (as a producer writing
+//    records would) and emptied into a pipe, either with writeFromBuffer()
+//    (one copy into the pipe) or giftToPipe() (the pages themselves). A
+//    second thread splices the pipe into /dev/null
+//   -file to socket: a file in the page cache is sent over a Unix socket,
+//    either through a ring with readToBuffer() and writeFromBuffer() (two
+//    copies) or with spliceThroughPipe() (none). A second thread reads the
+//    socket, which costs the same copy in both cases
+//   Before timing, each path is run once on a smaller amount with the
+//   receiving thread checking every byte, so pages reused before the pipe
+//   let go of them, or bytes lost or reordered, fail the run. CPU time is the
+//   process's user plus system time, i.e. both threads.
+//   Build
+//      gcc -O2 -pthread -o splice splice.c bench.c ../buffer.c ../bufferio.c
+//   Run
+//      ./splice [--csv|--json] [--counters] [megabytes] [file]
+//   The file (default splice.dat in the current directory) is created, and
+//   removed afterwards
+//
+// Author
+//   Daniel Wilkinson-Thompson (daniel@wilkinson-thompson.com)
+//
+// Date
+//   2026-10-18
+//
+// Licence
+//   Copyright (c) 2026 Daniel Wilkinson-Thompson. All rights reserved.
+//------------------------------------------------------------------------------
+
+//------------------------------------------------------------------------------
+// Headers
+//------------------------------------------------------------------------------
+#define _GNU_SOURCE
+#include "bench.h"
+#include "../buffer.h"
+#include "../bufferio.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+//------------------------------------------------------------------------------
+// Constants
+//------------------------------------------------------------------------------
+#define RING_PAGES          256
+#define PIPE_BYTES          (1 << 20)
+#define CHECK_BYTES         (64UL << 20)
+
+//------------------------------------------------------------------------------
+// Type definitions
+//------------------------------------------------------------------------------
+// Receiving thread's job
+typedef struct {
+    int fd;
+    unsigned char pipe;
+    unsigned char check;
+    unsigned long bytes;
+    unsigned long wrong;
+} receiver_t;
+
+//------------------------------------------------------------------------------
+// Functions
+//------------------------------------------------------------------------------
+// Byte expected at a position of the stream
+unsigned char streamByte(unsigned long position) {
+    return position ^ (position >> 12) ^ (position >> 20);
+}
+
+// Receive everything from fd: a pipe is spliced to /dev/null, a socket read,
+// and either is read and checked with check set
+void* runReceiver(void *arg) {
+    static unsigned char in[PIPE_BYTES];
+    receiver_t *r = arg;
+    int null = open("/dev/null", O_WRONLY);
+    unsigned long i;
+    long n;
+
+    r->bytes = 0;
+    r->wrong = 0;
+    for (;;) {
+        if ( r->check || !(r->pipe) ) {
+            n = read(r->fd, in, sizeof(in));
+            for (i = 0; r->check && (i < (unsigned long)((n > 0) ? n : 0)); i++) {
+                r->wrong += (in[i] != streamByte(r->bytes + i));
+            }
+        }
+        else {
+            n = splice(r->fd, NULL, null, NULL, PIPE_BYTES, SPLICE_F_MOVE);
+        }
+        if (n <= 0) {
+            break;
+        }
+        r->bytes += n;
+    }
+    close(null);
+    return NULL;
+}
+
+// Process CPU time in nanoseconds, both threads
+double cpuNanoseconds(void) {
+    struct rusage usage;
+
+    getrusage(RUSAGE_SELF, &usage);
+    return (usage.ru_utime.tv_sec + usage.ru_stime.tv_sec) * 1e9 +
+           (usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) * 1e3;
+}
+
+// Fill a ring in place and forward it into a pipe
+// -The return value is 1 if the receiver didn't get exactly the stream
+unsigned char ringToPipe(unsigned char gift, unsigned long bytes, unsigned char check, double *wall, double *cpu) {
+    buffersegment_t s[2];
+    receiver_t receiver;
+    pthread_t thread;
+    unsigned long position = 0, i;
+    unsigned int j, l;
+    buffer_t *b;
+    int p[2];
+
+    b = newPageBuffer(RING_PAGES);
+    if ( !(b) || pipe(p) ) {
+        fprintf(stderr, "splice: out of memory\n");
+        exit(1);
+    }
+    fcntl(p[1], F_SETPIPE_SZ, PIPE_BYTES);
+    receiver.fd = p[0];
+    receiver.pipe = 1;
+    receiver.check = check;
+    pthread_create(&thread, NULL, runReceiver, &receiver);
+
+    *cpu = cpuNanoseconds();
+    *wall = benchNanoseconds();
+    while ( (position < bytes) || !(isBufferEmpty(b)) ) {
+        reserveInBuffer(b, s);
+        for (j = 0; j < 2; j++) {
+            l = (s[j].count < bytes - position) ? s[j].count : bytes - position;
+            if (check) {
+                for (i = 0; i < l; i++) {
+                    ((unsigned char*)s[j].data)[i] = streamByte(position + i);
+                }
+            }
+            else {
+                memset(s[j].data, position >> 12, l);
+            }
+            commitToBuffer(b, l);
+            position += l;
+        }
+        if (gift) {
+            giftToPipe(b, p[1], position == bytes);
+        }
+        else {
+            writeFromBuffer(b, p[1]);
+        }
+    }
+    close(p[1]);
+    pthread_join(thread, NULL);
+    *wall = benchNanoseconds() - *wall;
+    *cpu = cpuNanoseconds() - *cpu;
+
+    close(p[0]);
+    freePageBuffer(b);
+    return (receiver.bytes != bytes) || receiver.wrong;
+}
+
+// Send a file over a socket
+// -The return value is 1 if the receiver didn't get exactly the file
+unsigned char fileToSocket(unsigned char spliced, int file, unsigned long bytes, unsigned char check, double *wall, double *cpu) {
+    receiver_t receiver;
+    pthread_t thread;
+    long long offset = 0;
+    unsigned long sent = 0;
+    buffer_t *b;
+    long n;
+    int sockets[2], p[2];
+
+    b = newPageBuffer(RING_PAGES);
+    if ( !(b) || pipe(p) || socketpair(AF_UNIX, SOCK_STREAM, 0, sockets) ) {
+        fprintf(stderr, "splice: out of memory\n");
+        exit(1);
+    }
+    fcntl(p[1], F_SETPIPE_SZ, PIPE_BYTES);
+    receiver.fd = sockets[1];
+    receiver.pipe = 0;
+    receiver.check = check;
+    pthread_create(&thread, NULL, runReceiver, &receiver);
+
+    *cpu = cpuNanoseconds();
+    *wall = benchNanoseconds();
+    if (spliced) {
+        while (sent < bytes) {
+            n = spliceThroughPipe(file, &offset, p, sockets[0], bytes - sent);
+            if (n <= 0) {
+                break;
+            }
+            sent += n;
+        }
+    }
+    else {
+        lseek(file, 0, SEEK_SET);
+        while ( (readToBuffer(b, file) > 0) || !(isBufferEmpty(b)) ) {
+            if (writeFromBuffer(b, sockets[0]) < 0) {
+                break;
+            }
+        }
+    }
+    shutdown(sockets[0], SHUT_WR);
+    pthread_join(thread, NULL);
+    *wall = benchNanoseconds() - *wall;
+    *cpu = cpuNanoseconds() - *cpu;
+
+    close(sockets[0]);
+    close(sockets[1]);
+    close(p[0]);
+    close(p[1]);
+    freePageBuffer(b);
+    return (receiver.bytes != bytes) || receiver.wrong;
+}
+
+// Write the stream to a file and read it back once, so it is in the page
+// cache
+int makeFile(const char *name, unsigned long bytes) {
+    buffer_t *b;
+    buffersegment_t s[2];
+    unsigned long position = 0, i;
+    int fd;
+
+    fd = open(name, O_RDWR | O_CREAT | O_TRUNC, 0600);
+    b = newPageBuffer(RING_PAGES);
+    if ( (fd < 0) || !(b) ) {
+        fprintf(stderr, "splice: can't create %s: %s\n", name, strerror(errno));
+        exit(1);
+    }
+    while (position < bytes) {
+        reserveInBuffer(b, s);
+        for (i = 0; (i < s[0].count) && (position + i < bytes); i++) {
+            ((unsigned char*)s[0].data)[i] = streamByte(position + i);
+        }
+        commitToBuffer(b, i);
+        position += i;
+        while ( !(isBufferEmpty(b)) ) {
+            if (writeFromBuffer(b, fd) < 0) {
+                fprintf(stderr, "splice: can't write %s: %s\n", name, strerror(errno));
+                exit(1);
+            }
+        }
+    }
+    freePageBuffer(b);
+    return fd;
+}
+
+// Print one row
+void printSplice(const char *path, const char *variant, unsigned long bytes, double wall, double cpu, unsigned char wrong) {
+    beginBenchRow();
+    addBenchText("benchmark", "splice");
+    addBenchText("path", path);
+    addBenchText("variant", variant);
+    addBenchNumber("megabytes", bytes >> 20);
+    addBenchNumber("gb_per_second", bytes / wall);
+    addBenchNumber("cpu_seconds_per_gb", cpu / 1e9 / (bytes / 1e9));
+    addBenchText("bytes_match", wrong ? "no" : "yes");
+    addBenchCounters(bytes);
+    endBenchRow();
+}
+
+int main(int argc, char *argv[]) {
+    static const char *ringVariants[] = {"writeFromBuffer", "giftToPipe"};
+    static const char *fileVariants[] = {"readToBuffer+writeFromBuffer", "spliceThroughPipe"};
+    unsigned long bytes, check;
+    unsigned int v, errors = 0;
+    unsigned char wrong;
+    const char *name;
+    double wall, cpu;
+    int file;
+
+    argc = parseBenchOptions(argc, argv);
+    bytes = ((argc > 1) ? strtoul(argv[1], NULL, 0) : 2048) << 20;
+    name = (argc > 2) ? argv[2] : "splice.dat";
+    check = (bytes < CHECK_BYTES) ? bytes : CHECK_BYTES;
+
+    for (v = 0; v < 2; v++) {
+        wrong = ringToPipe(v, check, 1, &wall, &cpu);
+        startBenchCounters();
+        wrong |= ringToPipe(v, bytes, 0, &wall, &cpu);
+        stopBenchCounters();
+        errors += wrong;
+        printSplice("ring_to_pipe", ringVariants[v], bytes, wall, cpu, wrong);
+    }
+
+    for (v = 0; v < 2; v++) {
+        file = makeFile(name, check);
+        wrong = fileToSocket(v, file, check, 1, &wall, &cpu);
+        close(file);
+        file = makeFile(name, bytes);
+        startBenchCounters();
+        wrong |= fileToSocket(v, file, bytes, 0, &wall, &cpu);
+        stopBenchCounters();
+        errors += wrong;
+        printSplice("file_to_socket", fileVariants[v], bytes, wall, cpu, wrong);
+        close(file);
+    }
+    unlink(name);
+
+    if (errors) {
+        fprintf(stderr, "splice: %u cases delivered the wrong bytes\n", errors);
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,173 @@
+//==============================================================================
+//                                  stack.c
+//------------------------------------------------------------------------------
+// Brief
+//   Benchmarks stackbuffer_t with and without elimination against a
+//   mutex-wrapped B_STACK buffer_t, from 1 to 64 threads
+//
+// Description
+//   Every thread runs a worklist loop: push an element, then pop one, as a
+//   free list or work-stealing pool would. The stack is half full to start
+//   with, so pops rarely find it empty. Every element carries a value, and the
+//   sum of values pushed and popped (including a final drain) must match.
+//   Build
+//      gcc -O2 -pthread -o stack stack.c bench.c ../buffer.c ../stackbuffer.c
+//   Run
+//      ./stack [--csv|--json] [--counters] [operations per case] [stack depth]
+//
+// Author
+//   Daniel Wilkinson-Thompson (daniel@wilkinson-thompson.com)
+//
+// Date
+//   2026-10-18
+//
+// Licence
+//   Copyright (c) 2026 Daniel Wilkinson-Thompson. All rights reserved.
+//------------------------------------------------------------------------------
+
+//------------------------------------------------------------------------------
+// Headers
+//------------------------------------------------------------------------------
+#include "bench.h"
+#include "../buffer.h"
+#include "../stackbuffer.h"
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+//------------------------------------------------------------------------------
+// Constants
+//------------------------------------------------------------------------------
+#define MAX_THREADS     64
+
+//------------------------------------------------------------------------------
+// Type definitions
+//------------------------------------------------------------------------------
+typedef struct {
+    buffer_t *locked;
+    stackbuffer_t *stack;
+    pthread_mutex_t mutex;
+    unsigned long perThread;
+    unsigned long pushedSum;
+    unsigned long poppedSum;
+} stackBench_t;
+
+//------------------------------------------------------------------------------
+// Functions
+//------------------------------------------------------------------------------
+// Push then pop on the mutex-wrapped buffer
+void* lockedWorker(void *arg) {
+    stackBench_t *s = arg;
+    unsigned long i, value, pushed = 0, popped = 0;
+
+    for (i = 1; i <= s->perThread; i++) {
+        pthread_mutex_lock(&(s->mutex));
+        if ( !pushToBuffer(s->locked, &i, 1) ) {
+            pushed += i;
+        }
+        pthread_mutex_unlock(&(s->mutex));
+        pthread_mutex_lock(&(s->mutex));
+        if ( !popFromBuffer(s->locked, &value, 1) ) {
+            popped += value;
+        }
+        pthread_mutex_unlock(&(s->mutex));
+    }
+    __atomic_fetch_add(&(s->pushedSum), pushed, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&(s->poppedSum), popped, __ATOMIC_RELAXED);
+    return NULL;
+}
+
+// Push then pop on the concurrent stack
+void* stackWorker(void *arg) {
+    stackBench_t *s = arg;
+    unsigned long i, value, pushed = 0, popped = 0;
+
+    for (i = 1; i <= s->perThread; i++) {
+        if ( !pushToStackBuffer(s->stack, &i, 1) ) {
+            pushed += i;
+        }
+        if ( !popFromStackBuffer(s->stack, &value, 1) ) {
+            popped += value;
+        }
+    }
+    __atomic_fetch_add(&(s->pushedSum), pushed, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&(s->poppedSum), popped, __ATOMIC_RELAXED);
+    return NULL;
+}
+
+// Run one case, returning nanoseconds elapsed, or a negative value if the
+// sums don't match
+double runCase(stackBench_t *s, unsigned int threads, unsigned int depth, unsigned int slots, unsigned char locked) {
+    pthread_t workers[MAX_THREADS];
+    unsigned long value;
+    unsigned int i;
+    double elapsed;
+
+    s->locked = newBuffer(depth, sizeof(unsigned long), B_STACK & B_DROP);
+    s->stack = newStackBuffer(depth, sizeof(unsigned long), slots);
+    if ( !(s->locked) || !(s->stack) ) {
+        fprintf(stderr, "stack: out of memory\n");
+        exit(1);
+    }
+    s->pushedSum = 0;
+    s->poppedSum = 0;
+
+    // Start half full
+    for (value = 1; value <= depth / 2; value++) {
+        pushToBuffer(s->locked, &value, 1);
+        pushToStackBuffer(s->stack, &value, 1);
+        s->pushedSum += value;
+    }
+
+    startBenchCounters();
+    elapsed = benchNanoseconds();
+    for (i = 0; i < threads; i++) {
+        pthread_create(&workers[i], NULL, locked ? lockedWorker : stackWorker, s);
+    }
+    for (i = 0; i < threads; i++) {
+        pthread_join(workers[i], NULL);
+    }
+    elapsed = benchNanoseconds() - elapsed;
+    stopBenchCounters();
+
+    // Drain what is left
+    while ( locked ? !popFromBuffer(s->locked, &value, 1) : !popFromStackBuffer(s->stack, &value, 1) ) {
+        s->poppedSum += value;
+    }
+    freeBuffer(s->locked);
+    freeStackBuffer(s->stack);
+    return (s->pushedSum == s->poppedSum) ? elapsed : -1;
+}
+
+int main(int argc, char *argv[]) {
+    stackBench_t s;
+    unsigned long operations;
+    unsigned int depth, threads, slots, errors = 0;
+    double elapsed;
+
+    argc = parseBenchOptions(argc, argv);
+    operations = (argc > 1) ? strtoul(argv[1], NULL, 0) : 1UL << 22;
+    depth = (argc > 2) ? strtoul(argv[2], NULL, 0) : 1024;
+
+    pthread_mutex_init(&(s.mutex), NULL);
+    for (threads = 1; threads <= MAX_THREADS; threads *= 2) {
+        s.perThread = operations / 2 / threads;
+        slots = (threads > 1) ? threads / 2 : 1;
+        elapsed = runCase(&s, threads, depth, 0, 1);
+        errors += (elapsed < 0);
+        printBenchResult("stack", "mutex+pushToBuffer", threads, s.perThread * 2 * threads, elapsed);
+        elapsed = runCase(&s, threads, depth, 0, 0);
+        errors += (elapsed < 0);
+        printBenchResult("stack", "stackbuffer", threads, s.perThread * 2 * threads, elapsed);
+        elapsed = runCase(&s, threads, depth, slots, 0);
+        errors += (elapsed < 0);
+        printBenchResult("stack", "stackbuffer+elimination", threads, s.perThread * 2 * threads, elapsed);
+    }
+    pthread_mutex_destroy(&(s.mutex));
+
+    if (errors) {
+        fprintf(stderr, "stack: %u cases lost or duplicated elements\n", errors);
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,191 @@
+//==============================================================================
+//                                 waitfree.c
+//------------------------------------------------------------------------------
+// Brief
+//   Measures worst-case push latency of waitfreebuffer_t against mpscbuffer_t
+//   and a mutex-wrapped buffer_t while a consumer polls as hard as it can
+//
+// Description
+//   Producers time every single push of a 32-byte telemetry record and never
+//   retry, as a control loop would. One consumer thread pops continuously so
+//   the shared cache lines are always contended. The tail of the latency
+//   distribution (p99.99 and max) is what matters for a hard real-time
+//   budget; the mean is printed for comparison only.
+//   Each sample includes the cost of reading the clock twice.
+//   Build
+//      gcc -O2 -pthread -o waitfree waitfree.c bench.c ../buffer.c ../mpscbuffer.c ../waitfreebuffer.c
+//   Run
+//      ./waitfree [--csv|--json] [--counters] [pushes per producer] [buffer depth]
+//
+// Author
+//   Daniel Wilkinson-Thompson (daniel@wilkinson-thompson.com)
+//
+// Date
+//   2026-10-18
+//
+// Licence
+//   Copyright (c) 2026 Daniel Wilkinson-Thompson. All rights reserved.
+//------------------------------------------------------------------------------
+
+//------------------------------------------------------------------------------
+// Headers
+//------------------------------------------------------------------------------
+#include "bench.h"
+#include "../buffer.h"
+#include "../mpscbuffer.h"
+#include "../waitfreebuffer.h"
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+//------------------------------------------------------------------------------
+// Constants
+//------------------------------------------------------------------------------
+#define MAX_PRODUCERS   8
+#define POP_BATCH       64
+
+// Variants measured
+#define V_MUTEX         0
+#define V_MPSC          1
+#define V_WAITFREE_DROP 2
+#define V_WAITFREE_OVER 3
+
+//------------------------------------------------------------------------------
+// Type definitions
+//------------------------------------------------------------------------------
+typedef struct {
+    unsigned long timestamp;
+    unsigned long sequence;
+    double value[2];
+} telemetry_t;
+
+typedef struct {
+    buffer_t *locked;
+    mpscbuffer_t *mpsc;
+    waitfreebuffer_t *waitfree;
+    pthread_mutex_t mutex;
+    unsigned long pushes;
+    unsigned int variant;
+    volatile int running;
+} waitfreeBench_t;
+
+typedef struct {
+    waitfreeBench_t *bench;
+    unsigned int id;
+    double *samples;
+} producer_t;
+
+//------------------------------------------------------------------------------
+// Functions
+//------------------------------------------------------------------------------
+// Push once to the buffer under test
+void pushOnce(waitfreeBench_t *w, unsigned int id, telemetry_t *t) {
+    switch (w->variant) {
+        case V_MUTEX:
+            pthread_mutex_lock(&(w->mutex));
+            pushToBuffer(w->locked, t, 1);
+            pthread_mutex_unlock(&(w->mutex));
+            break;
+        case V_MPSC:
+            pushToMpscBuffer(w->mpsc, t, 1);
+            break;
+        default:
+            pushToWaitFreeBuffer(w->waitfree, id, t, 1);
+            break;
+    }
+}
+
+// Producer timing each push
+void* producer(void *arg) {
+    producer_t *p = arg;
+    telemetry_t t = {0, 0, {1.0, 2.0}};
+    unsigned long i;
+    double start;
+
+    for (i = 0; i < p->bench->pushes; i++) {
+        t.sequence = i;
+        start = benchNanoseconds();
+        pushOnce(p->bench, p->id, &t);
+        p->samples[i] = benchNanoseconds() - start;
+    }
+    return NULL;
+}
+
+// Consumer popping as fast as it can until told to stop
+void* consumer(void *arg) {
+    waitfreeBench_t *w = arg;
+    telemetry_t t[POP_BATCH];
+
+    while (w->running) {
+        switch (w->variant) {
+            case V_MUTEX:
+                pthread_mutex_lock(&(w->mutex));
+                popFromBuffer(w->locked, &t[0], POP_BATCH);
+                pthread_mutex_unlock(&(w->mutex));
+                break;
+            case V_MPSC:
+                popFromMpscBuffer(w->mpsc, &t[0], POP_BATCH);
+                break;
+            default:
+                popFromWaitFreeBuffer(w->waitfree, &t[0], POP_BATCH);
+                break;
+        }
+    }
+    return NULL;
+}
+
+int main(int argc, char *argv[]) {
+    static const char *names[] = {"mutex+pushToBuffer", "mpscbuffer", "waitfreebuffer-drop", "waitfreebuffer-overwrite"};
+    waitfreeBench_t w;
+    pthread_t consumerThread, producerThreads[MAX_PRODUCERS];
+    producer_t producers[MAX_PRODUCERS];
+    unsigned int depth, count, i;
+    double *samples;
+
+    argc = parseBenchOptions(argc, argv);
+    w.pushes = (argc > 1) ? strtoul(argv[1], NULL, 0) : 200000;
+    depth = (argc > 2) ? strtoul(argv[2], NULL, 0) : 1024;
+    samples = malloc(MAX_PRODUCERS * w.pushes * sizeof(double));
+    if ( !(samples) ) {
+        fprintf(stderr, "waitfree: out of memory\n");
+        return 1;
+    }
+    pthread_mutex_init(&(w.mutex), NULL);
+
+    for (count = 1; count <= MAX_PRODUCERS; count *= 2) {
+        for (w.variant = V_MUTEX; w.variant <= V_WAITFREE_OVER; w.variant++) {
+            w.locked = newBuffer(depth, sizeof(telemetry_t), B_FIFO & B_DROP);
+            w.mpsc = newMpscBuffer(depth, sizeof(telemetry_t));
+            w.waitfree = newWaitFreeBuffer(count, depth / count, sizeof(telemetry_t), (w.variant == V_WAITFREE_OVER) ? B_OVERWRITE : B_DROP);
+            if ( !(w.locked) || !(w.mpsc) || !(w.waitfree) ) {
+                fprintf(stderr, "waitfree: out of memory\n");
+                return 1;
+            }
+
+            startBenchCounters();
+            w.running = 1;
+            pthread_create(&consumerThread, NULL, consumer, &w);
+            for (i = 0; i < count; i++) {
+                producers[i].bench = &w;
+                producers[i].id = i;
+                producers[i].samples = samples + i * w.pushes;
+                pthread_create(&producerThreads[i], NULL, producer, &producers[i]);
+            }
+            for (i = 0; i < count; i++) {
+                pthread_join(producerThreads[i], NULL);
+            }
+            w.running = 0;
+            pthread_join(consumerThread, NULL);
+            stopBenchCounters();
+
+            printLatencyResult("waitfree", names[w.variant], count, samples, count * w.pushes);
+            freeBuffer(w.locked);
+            freeMpscBuffer(w.mpsc);
+            freeWaitFreeBuffer(w.waitfree);
+        }
+    }
+
+    pthread_mutex_destroy(&(w.mutex));
+    free(samples);
+    return 0;
+}
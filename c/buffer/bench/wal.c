@@ -0,0 +1,244 @@
+//==============================================================================
+//                                   wal.c
+//------------------------------------------------------------------------------
+// Brief
+//   Compares durable commits per second with a sync per record against the
+//   group commit of bufferwal.c, as the number of committing threads grows
+//
+// Description
+//   Each of a number of threads commits its share of a fixed number of
+//   64-byte records and waits for each to be durable before the next:
+//   -write+fdatasync: under a mutex, one pwrite() and one fdatasync() per
+//    record, the usual way to make each record durable on its own
+//   -commitToWal: commitToWal(), so that the records of all the threads
+//    waiting at once share a write and a sync
+//   After each log run the file is read back with readWalRecord(), which must
+//   find every record, each thread's in the order it committed them. Read
+//   into too little room, the first record must come back as B_WAL_TOO_LONG
+//   with its length, not as torn. The log is then cut part way into its last
+//   record, as a crash mid-write leaves it, and must read back as every
+//   record but that one.
+//   Build
+//      gcc -O2 -pthread -o wal wal.c bench.c ../buffer.c ../bufferwal.c
+//   Run
+//      ./wal [--csv|--json] [--counters] [records] [file]
+//   The file (default wal.dat in the current directory) is created, and
+//   removed afterwards
+//
+// Author
+//   Daniel Wilkinson-Thompson (daniel@wilkinson-thompson.com)
+//
+// Date
+//   2026-10-18
+//
+// Licence
+//   Copyright (c) 2026 Daniel Wilkinson-Thompson. All rights reserved.
+//------------------------------------------------------------------------------
+
+//------------------------------------------------------------------------------
+// Headers
+//------------------------------------------------------------------------------
+#define _GNU_SOURCE
+#include "bench.h"
+#include "../buffer.h"
+#include "../bufferwal.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+//------------------------------------------------------------------------------
+// Constants
+//------------------------------------------------------------------------------
+#define RECORD_BYTES        64
+#define WAL_BYTES           (1 << 20)
+#define MAX_THREADS         256
+
+//------------------------------------------------------------------------------
+// Type definitions
+//------------------------------------------------------------------------------
+// A record: who committed it and the how manyth of theirs it is
+typedef struct {
+    unsigned int thread;
+    unsigned int sequence;
+    unsigned char padding[RECORD_BYTES - 8];
+} record_t;
+
+// One committing thread
+typedef struct {
+    unsigned int thread;
+    unsigned int records;
+    unsigned int failed;
+} committer_t;
+
+//------------------------------------------------------------------------------
+// Variables
+//------------------------------------------------------------------------------
+wal_t *wal;
+int file;
+unsigned long long fileOffset;
+pthread_mutex_t fileLock = PTHREAD_MUTEX_INITIALIZER;
+
+//------------------------------------------------------------------------------
+// Functions
+//------------------------------------------------------------------------------
+// Commit records one at a time, each synced on its own
+void* runSyncedCommitter(void *arg) {
+    committer_t *c = arg;
+    record_t r;
+    unsigned int i;
+
+    memset(&r, 0, sizeof(r));
+    r.thread = c->thread;
+    for (i = 0; i < c->records; i++) {
+        r.sequence = i;
+        pthread_mutex_lock(&fileLock);
+        c->failed += (pwrite(file, &r, sizeof(r), fileOffset) != sizeof(r)) || fdatasync(file);
+        fileOffset += sizeof(r);
+        pthread_mutex_unlock(&fileLock);
+    }
+    return NULL;
+}
+
+// Commit records one at a time through the log
+void* runWalCommitter(void *arg) {
+    committer_t *c = arg;
+    record_t r;
+    unsigned int i;
+
+    memset(&r, 0, sizeof(r));
+    r.thread = c->thread;
+    for (i = 0; i < c->records; i++) {
+        r.sequence = i;
+        c->failed += (commitToWal(wal, &r, sizeof(r)) == 0);
+    }
+    return NULL;
+}
+
+// Read the log back
+// -The return value is the number of good records, or -1 if one was out of
+//  order or the log didn't end where expected (end is B_WAL_END or
+//  B_WAL_TORN)
+long readBack(unsigned int threads, long end) {
+    unsigned int next[MAX_THREADS] = {0};
+    unsigned long long offset = 0, lsn = 0;
+    record_t r;
+    long n, good = 0;
+
+    while ( (n = readWalRecord(file, &offset, &lsn, &r, sizeof(r))) >= 0 ) {
+        if ( (n != sizeof(r)) || (r.thread >= threads) || (r.sequence != next[r.thread]++) ) {
+            return -1;
+        }
+        good++;
+    }
+    return (n == end) ? good : -1;
+}
+
+// Read the first record into too little room
+// -The return value is 1 unless it is reported as needing sizeof(record_t)
+//  bytes, with offset and LSN left on it
+unsigned char readTooLong(void) {
+    unsigned long long offset = 0, lsn = 0;
+    record_t r;
+    long n;
+
+    n = readWalRecord(file, &offset, &lsn, &r, sizeof(r) - 1);
+    return (n > B_WAL_TOO_LONG) || (B_WAL_NEEDED(n) != sizeof(r)) || offset || lsn;
+}
+
+// Commit every record one way
+// -The return value is 1 if a commit failed or the log didn't read back
+unsigned char runCommits(unsigned char grouped, unsigned int threads, unsigned long records,
+                         const char *name, double *ns, unsigned long *syncs, unsigned char *torn) {
+    committer_t committers[MAX_THREADS];
+    pthread_t thread[MAX_THREADS];
+    unsigned int i, failed = 0;
+
+    file = open(name, O_RDWR | O_CREAT | O_TRUNC, 0600);
+    if (file < 0) {
+        fprintf(stderr, "wal: can't create %s: %s\n", name, strerror(errno));
+        exit(1);
+    }
+    fileOffset = 0;
+    if (grouped) {
+        wal = newWal(file, WAL_BYTES, 0, 0);
+        if ( !(wal) ) {
+            fprintf(stderr, "wal: can't start the log\n");
+            exit(1);
+        }
+    }
+
+    *ns = benchNanoseconds();
+    for (i = 0; i < threads; i++) {
+        committers[i].thread = i;
+        committers[i].records = records / threads + (i < records % threads);
+        committers[i].failed = 0;
+        pthread_create(&(thread[i]), NULL, grouped ? runWalCommitter : runSyncedCommitter, &(committers[i]));
+    }
+    for (i = 0; i < threads; i++) {
+        pthread_join(thread[i], NULL);
+        failed += committers[i].failed;
+    }
+    *ns = benchNanoseconds() - *ns;
+    *syncs = records;
+    *torn = 0;
+
+    // Read back, then again after tearing the last record
+    if (grouped) {
+        *syncs = wal->flushes;
+        freeWal(wal);
+        failed += (readBack(threads, B_WAL_END) != (long)records);
+        failed += readTooLong();
+        ftruncate(file, lseek(file, 0, SEEK_END) - RECORD_BYTES / 2);
+        *torn = (readBack(threads, B_WAL_TORN) == (long)records - 1);
+        failed += !(*torn);
+    }
+    close(file);
+    return failed != 0;
+}
+
+int main(int argc, char *argv[]) {
+    static const char *variants[] = {"write+fdatasync", "commitToWal"};
+    static const unsigned int threadCounts[] = {1, 4, 16, 64, 256};
+    unsigned long records, syncs;
+    unsigned int v, t, errors = 0;
+    unsigned char wrong, torn;
+    const char *name;
+    double ns;
+
+    argc = parseBenchOptions(argc, argv);
+    records = (argc > 1) ? strtoul(argv[1], NULL, 0) : 10000;
+    name = (argc > 2) ? argv[2] : "wal.dat";
+
+    for (t = 0; t < sizeof(threadCounts) / sizeof(threadCounts[0]); t++) {
+        for (v = 0; v < 2; v++) {
+            startBenchCounters();
+            wrong = runCommits(v, threadCounts[t], records, name, &ns, &syncs, &torn);
+            stopBenchCounters();
+            errors += wrong;
+
+            beginBenchRow();
+            addBenchText("benchmark", "wal");
+            addBenchText("variant", variants[v]);
+            addBenchNumber("threads", threadCounts[t]);
+            addBenchNumber("records", records);
+            addBenchNumber("commits_per_second", records / ns * 1e9);
+            addBenchNumber("us_per_commit", ns / records * threadCounts[t] / 1e3);
+            addBenchNumber("records_per_sync", (double)records / syncs);
+            addBenchText("recovered", v ? (wrong ? "no" : "yes") : "");
+            addBenchText("torn_detected", v ? (torn ? "yes" : "no") : "");
+            addBenchCounters(records);
+            endBenchRow();
+        }
+    }
+    unlink(name);
+
+    if (errors) {
+        fprintf(stderr, "wal: %u cases failed to commit or read back\n", errors);
+        return 1;
+    }
+    return 0;
+}
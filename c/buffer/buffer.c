@@ -7,14 +7,28 @@
 // Contents
 //   - newBuffer
 //   - freeBuffer
+//   - newBufferArray
+//   - freeBufferArray
+//   - initBuffer
 //   - isBufferEmpty
 //   - isBufferFull
 //   - popFromBuffer
 //   - pushToBuffer
-//   - popByte (private)
-//   - pushByte (private)
-//   - increment (private)
-//   - decrement (private)
+//   - peekBuffer
+//   - discardFromBuffer
+//   - reserveInBuffer
+//   - commitToBuffer
+//   - bufferMemoryUsage
+//   - bufferSequence
+//   - popSequencedFromBuffer
+//   - admitToBuffer
+//   - passBufferGap
+//   - countBufferElements (private)
+//   - countWaitingRefusals (private)
+//   - copyFromBufferTail (private)
+//   - prefetchFromBufferTail (private)
+//   - prefetchBufferElement (private)
+//   - heapBlockSize (private)
 //
 // Description
 //   Declaration
@@ -30,6 +44,15 @@
 //      int yourMaximumLove[4];
 //      popFromBuffer(b, &howMuchYouLoveBuffers, 1);
 //      popFromBuffer(b, &yourMaximumLove[0], 4);
+//   Storage
+//      head and tail are element indices into data, not pointers. Elements
+//      are stored whole, in the order they were pushed, so a push or a FIFO
+//      pop is at most two memcpy() calls, one each side of the wrap.
+//   Sequence numbers
+//      pushed = sequence + (elements held) + skipped + (refusals waiting for
+//      the next gap), always. Refusals only wait while there is a gap, and
+//      only refused pushes and the pop that reaches a gap take the slow path
+//      through admitToBuffer() or passBufferGap().
 //
 // Warnings
 //  -Each buffer is stored in the heap.  If there is not enough RAM, calling the
@@ -58,16 +81,32 @@
 //------------------------------------------------------------------------------
 // Headers
 //------------------------------------------------------------------------------
+#ifndef _POSIX_C_SOURCE
+#define _POSIX_C_SOURCE 200112L
+#endif
 #include "buffer.h"
+#include <limits.h>
 #include <stdlib.h>
+#include <string.h>
+
+//------------------------------------------------------------------------------
+// Private constants
+//------------------------------------------------------------------------------
+// Bytes copied between rounds of prefetches
+// -Whole pages, so each memcpy() is still long enough to run at full speed,
+//  and the prefetches reach across the page boundaries where hardware
+//  prefetchers stop
+#define B_PREFETCH_STEP     4096
 
 //------------------------------------------------------------------------------
 // Private function prototypes
 //------------------------------------------------------------------------------
-unsigned char popByte(buffer_t *b);
-void pushByte(buffer_t *b, unsigned char d);
-void increment(buffer_t *b, void **ht);
-void decrement(buffer_t *b, void **ht);
+unsigned int countBufferElements(buffer_t *b);
+unsigned long long countWaitingRefusals(buffer_t *b, unsigned int count);
+void copyFromBufferTail(buffer_t *b, unsigned char *out, unsigned int l, unsigned int count);
+void prefetchFromBufferTail(buffer_t *b, unsigned long start, unsigned long end);
+void prefetchBufferElement(buffer_t *b, unsigned int slot);
+unsigned long heapBlockSize(unsigned long bytes);
 
 //------------------------------------------------------------------------------
 // Functions
@@ -76,21 +115,29 @@ void decrement(buffer_t *b, void **ht);
 buffer_t* newBuffer(unsigned int numberOfElements, unsigned char elementSizeInBytes, unsigned char behavior) {
     
     buffer_t *b;
-    b = malloc(sizeof(buffer_t));
     
     // Allocate memory for buffer wrapper
     // -If there is not enough free RAM in the heap, return a NULL pointer
+    // -Only B_SEPARATE_LINES needs more than malloc's alignment
+#ifdef B_SEPARATE_LINES
+    if ( posix_memalign((void**)&b, __alignof__(buffer_t), sizeof(buffer_t)) ) {
+        b = NULL;
+        return NULL;
+    }
+#else
+    b = malloc(sizeof(buffer_t));
     if ( !(b) ) {
         b = NULL;
         return NULL;
     }
+#endif
 
     // Allocate memory for buffer data
     // -If there is not enough free RAM in the heap, free all allocated RAM and
     //  return a NULL pointer
-    // -Strictly speaking ((numberOfElements+1)*elementSizeInBytes) is always
-    //  more data storage than we need (numberOfElements*elementSizeInBytes+1),
-    //  but this simplifies checking whether the buffer is full.
+    // -One element more than numberOfElements is allocated, so that a full
+    //  buffer (head one slot behind tail) can be told apart from an empty
+    //  one (head equal to tail)
     b->data = calloc(numberOfElements + 1, elementSizeInBytes);
     if ( !(b->data) ) {
         free(b);
@@ -99,11 +146,8 @@ buffer_t* newBuffer(unsigned int numberOfElements, unsigned char elementSizeInBy
     }
 
     // Initialize buffer
-    b->behavior.byte = behavior;
-    b->head = b->data;
-    b->tail = b->data;
-    b->width = elementSizeInBytes;
-    b->depth = numberOfElements + 1;
+    initBuffer(b, b->data, numberOfElements, elementSizeInBytes, behavior);
+    b->behavior.bits.heap = 1;
     return b;
 }
 
@@ -113,17 +157,67 @@ void freeBuffer(buffer_t *b) {
     // Deallocate data buffer
     free(b->data);
     
-    // Set all pointers to NULL
+    // Set data pointer to NULL
     //  -Just in case something nasty happens during deallocation of b
     b->data = NULL;
-    b->head = NULL;
-    b->tail = NULL;
+    b->head = 0;
+    b->tail = 0;
     
     // Deallocate buffer_t variable
     free(b);
     b = NULL;
 }
 
+// Generate array of buffers
+buffer_t* newBufferArray(unsigned int count, unsigned int numberOfElements, unsigned char elementSizeInBytes, unsigned char behavior) {
+    buffer_t *bs;
+    unsigned char *storage;
+    unsigned long headers, stride;
+    unsigned int i;
+
+    // Headers first, then the storage of each buffer, each rounded up to
+    // whole cache lines
+    // -A total that doesn't fit in an unsigned long would wrap, and allocate
+    //  less than the buffers use
+    if (count == 0) {
+        return NULL;
+    }
+    headers = ((unsigned long)count * sizeof(buffer_t) + B_CACHE_LINE - 1) & ~(B_CACHE_LINE - 1UL);
+    stride = (((unsigned long)numberOfElements + 1) * elementSizeInBytes + B_CACHE_LINE - 1) & ~(B_CACHE_LINE - 1UL);
+    if ( (stride && (count > (ULONG_MAX - headers) / stride)) ||
+         posix_memalign((void**)&bs, B_CACHE_LINE, headers + count * stride) ) {
+        return NULL;
+    }
+
+    // Initialize buffers
+    // -Storage is not zeroed: nothing is read before it has been pushed
+    storage = (unsigned char*)bs + headers;
+    for (i = 0; i < count; i++) {
+        initBuffer(&bs[i], storage + i * stride, numberOfElements, elementSizeInBytes, behavior);
+    }
+    return bs;
+}
+
+// Free array of buffers
+void freeBufferArray(buffer_t *bs) {
+    free(bs);
+}
+
+// Set up a buffer header over storage the caller owns
+void initBuffer(buffer_t *b, void *storage, unsigned int numberOfElements, unsigned char elementSizeInBytes, unsigned char behavior) {
+    b->data = storage;
+    b->behavior.byte = behavior;
+    b->behavior.bits.heap = 0;
+    b->head = 0;
+    b->pushed = 0;
+    b->tail = 0;
+    b->gap = 0;
+    b->sequence = 0;
+    b->skipped = 0;
+    b->width = elementSizeInBytes;
+    b->depth = numberOfElements + 1;
+}
+
 // Buffer empty check
 unsigned char isBufferEmpty(buffer_t *b) {
     return (b->head == b->tail);
@@ -131,144 +225,379 @@ unsigned char isBufferEmpty(buffer_t *b) {
 
 // Buffer full check
 unsigned char isBufferFull(buffer_t *b) {
-    return ( (b->tail == b->head + 1) || ((b->tail == b->data) && ( b->head >= (b->data + (b->depth - 1) * (b->width)) )) );
+    return ( (b->head + 1 == b->tail) || ((b->tail == 0) && (b->head == b->depth - 1)) );
 }
 
-// Increment head/tail pointer
-void increment(buffer_t *b, void **ht){
-    
-    // Check whether head/tail pointer is at the last element
-    if (*ht < b->data + (b->depth - 1) * (b->width)) {
-        *ht = *ht + 1;
-    }
-    
-    // If ht the last element, wrap to the first element
-    else {
-        *ht = b->data;
-    }
+// Number of elements in the buffer
+unsigned int countBufferElements(buffer_t *b) {
+    return (b->head >= b->tail) ? b->head - b->tail : b->head + b->depth - b->tail;
 }
 
-// Decrement head/tail pointer
-void decrement(buffer_t *b, void **ht){
-    
-    // Check whether head/tail pointer is at the first element
-    if (*ht > b->data) {
-        *ht = *ht-1;
-    }
-    
-    // If ht is at the first element, wrap to the last element
-    else {
-        *ht = b->data + (b->depth-1) * (b->width);
+// Refused elements counted in pushed but in no gap yet, with count elements
+// held
+unsigned long long countWaitingRefusals(buffer_t *b, unsigned int count) {
+    return b->pushed - b->sequence - count - b->skipped;
+}
+
+// Copy l of the count elements held out from the tail, keeping prefetches
+// B_PREFETCH_DISTANCE bytes ahead of the copy
+// -Prefetches run on past the last element copied into the ones the next pop
+//  will take, but never past the last element held
+void copyFromBufferTail(buffer_t *b, unsigned char *out, unsigned int l, unsigned int count) {
+    unsigned char *data = b->data;
+    unsigned long ring, bytes, held, from, done, ahead, at, block;
+
+    ring = (unsigned long)b->depth * b->width;
+    bytes = (unsigned long)l * b->width;
+    held = (unsigned long)count * b->width;
+    from = (unsigned long)b->tail * b->width;
+
+    for (done = 0, ahead = 0; done < bytes; done += block) {
+
+        // Next block, up to B_PREFETCH_STEP bytes and not across the wrap
+        at = from + done;
+        if (at >= ring) {
+            at -= ring;
+        }
+        block = bytes - done;
+        if (block > B_PREFETCH_STEP) {
+            block = B_PREFETCH_STEP;
+        }
+        if (block > ring - at) {
+            block = ring - at;
+        }
+
+        // Prefetch every line up to B_PREFETCH_DISTANCE past this block
+        at = done + block + B_PREFETCH_DISTANCE;
+        prefetchFromBufferTail(b, ahead, (at < held) ? at : held);
+        ahead = at;
+
+        at = from + done;
+        if (at >= ring) {
+            at -= ring;
+        }
+        memcpy(out + done, data + at, block);
     }
 }
 
-// Byte-size pop function
-unsigned char popByte(buffer_t *b){
-    unsigned char d;
+// Prefetch the lines holding bytes start to end (exclusive) counted from the
+// tail, wrapping with the ring
+void prefetchFromBufferTail(buffer_t *b, unsigned long start, unsigned long end) {
+    unsigned char *data = b->data;
+    unsigned long ring, from, at;
 
-    // FILO: Push to head, pop from head
-    if (b->behavior.bits.stack) {
-        
-        // Decrement head first as it is currently pointing to a free slot
-        decrement(b, &(b->head));
-        d =  *( (unsigned char*)b->head );
+    ring = (unsigned long)b->depth * b->width;
+    from = (unsigned long)b->tail * b->width;
+    if (start >= end) {
+        return;
     }
-    
-    // FIFO: Push to head, pop from tail
-    else {
-        d =  *( (unsigned char*)b->tail );
-        increment(b, &(b->tail));
+
+    // Every B_CACHE_LINE bytes, and the last byte, since start needn't be at
+    // the start of a line
+    for ( ; start < end; start += B_CACHE_LINE) {
+        at = from + start;
+        if (at >= ring) {
+            at -= ring;
+        }
+        __builtin_prefetch(data + at, 0, 3);
     }
+    at = from + end - 1;
+    if (at >= ring) {
+        at -= ring;
+    }
+    __builtin_prefetch(data + at, 0, 3);
+}
 
-    return d;
+// Prefetch every line of the element in a slot
+void prefetchBufferElement(buffer_t *b, unsigned int slot) {
+    unsigned char *element = (unsigned char*)b->data + (unsigned long)slot * b->width;
+    unsigned int offset;
+
+    for (offset = 0; offset < b->width; offset += B_CACHE_LINE) {
+        __builtin_prefetch(element + offset, 0, 3);
+    }
 }
 
 // Arbitrary-size pop function
 unsigned int popFromBuffer(buffer_t *b, void *d, unsigned int l){
-    unsigned int elementIndex, byteIndex;
-
-    for (elementIndex = 0; elementIndex < l; elementIndex++) {
-        for (byteIndex = 0; byteIndex < b->width; byteIndex++) {
-            if (!isBufferEmpty(b)){
-                
-                // Stacks swap bytes of multi-byte elements, so swap back
-                // on pop operation
-                if (b->behavior.bits.stack){
-                    *( (unsigned char*)(d + ((elementIndex + 1) * b->width) - 1 - byteIndex) ) = popByte(b);
-                }
-                
-                // Queue does not swap bytes, so no need to swap on pop
-                else {
-                    *( (unsigned char*)(d + (elementIndex * b->width) + byteIndex) ) = popByte(b);
-                }
+    unsigned char *data = b->data, *out = d;
+    unsigned int count, failed = 0, elementIndex, first, ahead;
+    unsigned long end, held;
+
+    // Only pop what is there
+    count = countBufferElements(b);
+    if (l > count) {
+        failed = l - count;
+        l = count;
+    }
+
+    // FILO: Push to head, pop from head, so the newest element comes first
+    // -Each element copied prefetches the one 'ahead' elements below it, in
+    //  this pop or the next, as long as the buffer holds one there
+    if (b->behavior.bits.stack) {
+        ahead = (B_PREFETCH_DISTANCE + b->width - 1) / b->width;
+        for (elementIndex = 0; elementIndex < l; elementIndex++) {
+            if ( (B_PREFETCH_DISTANCE > 0) && (elementIndex + ahead < count) ) {
+                prefetchBufferElement(b, (b->head > ahead) ? b->head - ahead - 1 : b->head + b->depth - ahead - 1);
             }
-            else {
-                // Push any bytes back to buffer that form an incomplete element
-                // -Ideally this should never run, but added just in case
-                unsigned int failedbytes;
-                for (failedbytes=byteIndex; failedbytes > 0; failedbytes--){
-                    
-                    // Careful not to swap bytes here...
-                    pushByte(b, *( (unsigned char*)(d + elementIndex * b->width + failedbytes ) ));
-                }
-                
-                // Return a count of failed pop operations
-                // -Include partial pops in counter
-                return l - elementIndex;
+            if (b->head == 0) {
+                b->head = b->depth;
             }
+            b->head--;
+            memcpy(out + elementIndex * b->width, data + b->head * b->width, b->width);
         }
     }
-    return 0;
-}
 
-// Byte-size push function
-void pushByte(buffer_t *b, unsigned char d){
-    
-    // If we are overwriting a full buffer, increment tail pointer so that the
-    // head doesn't move past the tail
-    if ( (isBufferFull(b)) && (b->behavior.bits.overwrite) ) {
-        increment(b, &(b->tail));
+    // FIFO: Push to head, pop from tail
+    // -Short pops copy each side of the wrap in one go, long ones in blocks
+    //  with prefetches running ahead
+    // -Either way prefetches run B_PREFETCH_DISTANCE bytes past what is
+    //  popped, into what the next pop takes, but not past the last element
+    //  held. A short pop only prefetches the lines that came into range, so
+    //  single-element pops prefetch each line about once
+    else {
+        if (b->skipped) {
+            passBufferGap(b, l, count);
+        }
+        if ( (B_PREFETCH_DISTANCE > 0) && ((unsigned long)l * b->width > B_PREFETCH_DISTANCE) ) {
+            copyFromBufferTail(b, out, l, count);
+        }
+        else {
+            if (B_PREFETCH_DISTANCE > 0) {
+                end = (unsigned long)l * b->width + B_PREFETCH_DISTANCE;
+                held = (unsigned long)count * b->width;
+                prefetchFromBufferTail(b, B_PREFETCH_DISTANCE, (end < held) ? end : held);
+            }
+            first = b->depth - b->tail;
+            if (first > l) {
+                first = l;
+            }
+            memcpy(out, data + b->tail * b->width, first * b->width);
+            memcpy(out + first * b->width, data, (l - first) * b->width);
+        }
+        b->tail += l;
+        if (b->tail >= b->depth) {
+            b->tail -= b->depth;
+        }
+        b->sequence += l;
     }
-    
-    // Regardless of FIFO or FILO, always push to head
-    *((unsigned char*)b->head) = d;
-    increment(b, &(b->head));
+
+    // Return a count of failed pop operations
+    return failed;
 }
 
 // Arbitrary-size push function
 unsigned int pushToBuffer(buffer_t *b, void *d, unsigned int l) {
-    unsigned int elementIndex, byteIndex;
-    
-    // Loop through all elements
-    for (elementIndex = 0; elementIndex < l; elementIndex++) {
-
-        // Loop through all bytes of each element
-        for (byteIndex = 0; byteIndex < b->width; byteIndex++) {
-        
-            // Only push to buffer if it is not full or overwriting is allowed
-            if ( (!isBufferFull(b)) || (b->behavior.bits.overwrite) ) {
-                pushByte(b, *( (unsigned char*)(d + elementIndex * (b->width) + byteIndex) ));
+    unsigned char *data = b->data, *in = d;
+    unsigned int room, failed = 0, first;
+
+    // Every element pushed uses up a sequence number, kept or not
+    room = b->depth - 1 - countBufferElements(b);
+    b->pushed += l;
+    if (l > room) {
+
+        // Only push to buffer what fits, unless overwriting is allowed
+        if ( !(b->behavior.bits.overwrite) ) {
+            failed = l;
+            l = admitToBuffer(b, l, room);
+            failed -= l;
+        }
+
+        // If we are overwriting a full buffer, drop the oldest elements: first
+        // those in the buffer (by moving the tail on), then the oldest of the
+        // new ones if there are more of them than the buffer holds. Both use
+        // up their sequence numbers
+        else {
+            b->sequence += l - room;
+            if (l > b->depth - 1) {
+                in += (l - (b->depth - 1)) * b->width;
+                l = b->depth - 1;
             }
-            
-            // If buffer is full, return a count of those elments not pushed
-            else {
-                
-                // Pop all bytes of incomplete elements
-                // -This should never run, but added just in case
-                unsigned int failedbytes;
-                for (failedbytes = byteIndex; failedbytes > 0; failedbytes--) {
-                   
-                    // If it is a queue pop comes from tail, so decrement head
-                    decrement(b, &(b->head));
-                }
-                
-                // Return a count of failed push operations
-                // -Include partial pushes in count
-                return l - elementIndex;
+            b->tail += l - room;
+            if (b->tail >= b->depth) {
+                b->tail -= b->depth;
             }
         }
     }
-    return 0;
+
+    // Regardless of FIFO or FILO, always push to head, copying each side of
+    // the wrap in one go
+    first = b->depth - b->head;
+    if (first > l) {
+        first = l;
+    }
+    memcpy(data + b->head * b->width, in, first * b->width);
+    memcpy(data, in + first * b->width, (l - first) * b->width);
+    b->head += l;
+    if (b->head >= b->depth) {
+        b->head -= b->depth;
+    }
+
+    // Return a count of failed push operations
+    return failed;
+}
+
+// Look at the used region in place
+unsigned int peekBuffer(buffer_t *b, buffersegment_t segments[2]) {
+    unsigned int count;
+
+    // Oldest elements run from tail to head, or to the end of the storage and
+    // on from its start
+    count = countBufferElements(b);
+    segments[0].data = (unsigned char*)b->data + (unsigned long)b->tail * b->width;
+    segments[0].count = (count < b->depth - b->tail) ? count : b->depth - b->tail;
+    segments[1].data = b->data;
+    segments[1].count = count - segments[0].count;
+    return count;
+}
+
+// Drop elements from the tail
+unsigned int discardFromBuffer(buffer_t *b, unsigned int l) {
+    unsigned int count, failed = 0;
+
+    count = countBufferElements(b);
+    if (l > count) {
+        failed = l - count;
+        l = count;
+    }
+    if (b->skipped) {
+        passBufferGap(b, l, count);
+    }
+    b->tail += l;
+    if (b->tail >= b->depth) {
+        b->tail -= b->depth;
+    }
+    b->sequence += l;
+    return failed;
+}
+
+// Look at the free region in place
+unsigned int reserveInBuffer(buffer_t *b, buffersegment_t segments[2]) {
+    unsigned int room;
+
+    // Free slots run from head to the slot before tail, or to the end of the
+    // storage and on from its start
+    room = b->depth - 1 - countBufferElements(b);
+    segments[0].data = (unsigned char*)b->data + (unsigned long)b->head * b->width;
+    segments[0].count = (room < b->depth - b->head) ? room : b->depth - b->head;
+    segments[1].data = b->data;
+    segments[1].count = room - segments[0].count;
+    return room;
+}
+
+// Move the head over elements written in place
+unsigned int commitToBuffer(buffer_t *b, unsigned int l) {
+    unsigned int room, failed = 0;
+
+    room = b->depth - 1 - countBufferElements(b);
+    if (l > room) {
+        failed = l - room;
+        l = room;
+    }
+    b->pushed += l;
+    b->head += l;
+    if (b->head >= b->depth) {
+        b->head -= b->depth;
+    }
+    return failed;
+}
+
+// Bytes reserved by the allocator for a heap block of the given size
+unsigned long heapBlockSize(unsigned long bytes) {
+    bytes = (bytes + B_MALLOC_HEADER + B_MALLOC_ALIGNMENT - 1) & ~(B_MALLOC_ALIGNMENT - 1);
+    if (bytes >= B_MALLOC_MMAP_THRESHOLD) {
+        return (bytes + B_MALLOC_HEADER + B_MALLOC_PAGE - 1) & ~(B_MALLOC_PAGE - 1);
+    }
+    return (bytes < B_MALLOC_MINIMUM) ? B_MALLOC_MINIMUM : bytes;
+}
+
+// Memory used by buffer
+unsigned long bufferMemoryUsage(buffer_t *b) {
+    unsigned long storage = (unsigned long)b->depth * b->width;
+
+    // Declared buffers: the header and the storage array, nothing more
+    if ( !(b->behavior.bits.heap) ) {
+        return sizeof(buffer_t) + storage;
+    }
+
+    // Heap buffers: two allocations, each with allocator overhead
+    return heapBlockSize(sizeof(buffer_t)) + heapBlockSize(storage);
+}
+
+// Sequence number of the element at the tail
+unsigned long long bufferSequence(buffer_t *b) {
+    return b->sequence;
+}
+
+// Pop, saying where in the sequence the popped elements start
+// -Stops at a gap, so the elements popped are numbered one apart
+unsigned int popSequencedFromBuffer(buffer_t *b, void *d, unsigned int l, unsigned long long *sequence) {
+    unsigned int before;
+
+    *sequence = b->sequence;
+    if (b->skipped) {
+        before = (b->gap >= b->tail) ? b->gap - b->tail : b->gap + b->depth - b->tail;
+        if (l > before) {
+            return l - before + popFromBuffer(b, d, before);
+        }
+    }
+    return popFromBuffer(b, d, l);
+}
+
+// Keep what fits of a B_DROP push, numbering the rest as refused
+// -pushed already counts all l elements
+// -Refused elements go in the gap if they come straight after it, or open
+//  one if there is none. Otherwise they wait, counted in pushed alone, for
+//  the tail to reach the gap; elements kept meanwhile are numbered as if
+//  they had not been refused
+unsigned int admitToBuffer(buffer_t *b, unsigned int l, unsigned int room) {
+    unsigned int count = b->depth - 1 - room, kept, refused;
+
+    // Stacks don't number their elements
+    kept = (l < room) ? l : room;
+    if (b->behavior.bits.stack) {
+        return kept;
+    }
+    refused = l - kept;
+
+    // Empty even after the push (a buffer of no elements): the numbers go by
+    // at once
+    if (count + kept == 0) {
+        b->sequence += refused;
+    }
+    else if ( !(b->skipped) ) {
+        b->gap = (b->head + kept) % b->depth;
+        b->skipped = refused;
+    }
+    else if ( (b->gap == b->head) && (kept == 0) ) {
+        b->skipped += refused;
+    }
+    return kept;
+}
+
+// Move the sequence past the gap if a pop or discard of l of the count
+// elements held reaches it
+// -Refusals waiting for the tail to get here make the next gap, at head
+void passBufferGap(buffer_t *b, unsigned int l, unsigned int count) {
+    unsigned long long waiting;
+    unsigned int before;
+
+    before = (b->gap >= b->tail) ? b->gap - b->tail : b->gap + b->depth - b->tail;
+    if (l < before) {
+        return;
+    }
+    waiting = countWaitingRefusals(b, count);
+    b->sequence += b->skipped;
+    b->skipped = 0;
+    if (waiting) {
+        if (count == l) {
+            b->sequence += waiting;
+        }
+        else {
+            b->gap = b->head;
+            b->skipped = waiting;
+        }
+    }
 }
 
 #endif
\ No newline at end of file
@@ -5,12 +5,24 @@
 //   Implements circular buffer to hold data elements of a fixed number of bytes
 //
 // Contents
+//   - BUFFER_DECLARE
+//   - BUFFER_DECLARE_LOCAL
 //   - newBuffer
 //   - freeBuffer
+//   - newBufferArray
+//   - freeBufferArray
+//   - initBuffer
 //   - isBufferEmpty
 //   - isBufferFull
 //   - popFromBuffer
 //   - pushToBuffer
+//   - peekBuffer
+//   - discardFromBuffer
+//   - reserveInBuffer
+//   - commitToBuffer
+//   - bufferMemoryUsage
+//   - bufferSequence
+//   - popSequencedFromBuffer
 //
 // Description
 //   Declaration
@@ -26,6 +38,19 @@
 //      int yourMaximumLove[4];
 //      popFromBuffer(b, &howMuchYouLoveBuffers, 1);
 //      popFromBuffer(b, &yourMaximumLove[0], 4);
+//   Sequence numbers
+//      Every element pushed to a FIFO buffer has a 64-bit sequence number,
+//      counting from 0, with nothing stored per element: it is the number of
+//      elements pushed before it, kept or not (for B_DROP, see Warnings).
+//      The buffer counts elements in at its head and out at its tail, and
+//      the oldest element's number is the count out. Elements overwritten
+//      with B_OVERWRITE, and elements a full B_DROP buffer refuses, still use
+//      up their numbers, so a consumer that pops with popSequencedFromBuffer()
+//      sees exactly how many it missed, and where:
+//      unsigned long long first, expected = 0;
+//      n = 64 - popSequencedFromBuffer(b, &batch[0], 64, &first);
+//      if (n && (first != expected)) lost += first - expected;
+//      expected = first + n;
 //
 // Warnings
 //  -Each buffer is stored in the heap.  If there is not enough RAM, calling the
@@ -35,8 +60,18 @@
 //      b = newBuffer(3, sizeof(int), B_FILO & B_DROP);
 //      if ( b == NULL ) return -1;
 //      ...
+//  -Buffers declared with BUFFER_DECLARE or BUFFER_DECLARE_LOCAL are not stored
+//   in the heap, so never call freeBuffer() on them
 //  -Both pushToBuffer and popFromBuffer have the potential to access unmapped
 //   memory, since only a pointer and an offset are used to read/write to memory
+//  -A B_DROP FIFO buffer records one run of refused elements among those it
+//   holds. If it refuses more while elements pushed after that run are still
+//   queued, the elements it keeps after them are numbered as if those had
+//   not been refused, and the gap for them shows up once the consumer has
+//   reached the first run, after every element then held. Numbers never
+//   change once pushed and always go up, and the gaps add up to the elements
+//   lost, but a buffer that keeps overflowing can number some elements lower
+//   than the count pushed before them
 //
 // Author
 //   Daniel Wilkinson-Thompson (daniel@wilkinson-thompson.com)
@@ -51,6 +86,11 @@
 #ifndef BUFFER_H
 #define BUFFER_H
 
+//------------------------------------------------------------------------------
+// Headers
+//------------------------------------------------------------------------------
+#include <string.h>
+
 //------------------------------------------------------------------------------
 // Constants
 //------------------------------------------------------------------------------
@@ -76,26 +116,284 @@
 // -Existing elements don't move
 #define B_DROP         0xBF
 
+// Allocator bookkeeping assumed by bufferMemoryUsage()
+// -Each heap block costs its size plus B_MALLOC_HEADER bytes, rounded up to a
+//  multiple of B_MALLOC_ALIGNMENT, and never less than B_MALLOC_MINIMUM bytes
+// -Blocks of B_MALLOC_MMAP_THRESHOLD bytes or more are mapped on their own,
+//  so they cost another header and are rounded up to whole B_MALLOC_PAGE pages
+// -The defaults match glibc malloc with its default mmap threshold; define
+//  these before including buffer.h to model a different allocator
+#ifndef B_MALLOC_HEADER
+#define B_MALLOC_HEADER     (sizeof(void*))
+#endif
+#ifndef B_MALLOC_ALIGNMENT
+#define B_MALLOC_ALIGNMENT  (2 * sizeof(void*))
+#endif
+#ifndef B_MALLOC_MINIMUM
+#define B_MALLOC_MINIMUM    (4 * sizeof(void*))
+#endif
+#ifndef B_MALLOC_MMAP_THRESHOLD
+#define B_MALLOC_MMAP_THRESHOLD (128 * 1024)
+#endif
+#ifndef B_MALLOC_PAGE
+#define B_MALLOC_PAGE       4096
+#endif
+
+// Cache line size used to keep data written by different threads apart
+// -Define as 128 on CPUs whose adjacent-line prefetcher pulls in lines in
+//  pairs, so that neighbouring lines don't false-share either
+#ifndef B_CACHE_LINE
+#define B_CACHE_LINE        64
+#endif
+
+// Software prefetch distance for popFromBuffer(), in bytes
+// -Every pop prefetches the lines this far past the elements it copies, in
+//  this pop or the ones the next pop takes, wrapping with the ring and never
+//  past the last element held. This helps when the elements are cold, e.g.
+//  written long ago or by another core, and matters most for large elements
+// -0 turns prefetching off. It takes effect where buffer.c is compiled, e.g.
+//      gcc -DB_PREFETCH_DISTANCE=1024 -c buffer.c
+#ifndef B_PREFETCH_DISTANCE
+#define B_PREFETCH_DISTANCE 1024
+#endif
+
 
 //------------------------------------------------------------------------------
 // Type definitions
 //------------------------------------------------------------------------------
+// -head is the index of the slot the next element is pushed to and tail the
+//  index of the oldest element; both run from 0 to depth - 1
+// -pushed is the sequence number the next element pushed gets: how many have
+//  been pushed, kept, overwritten or refused. It is written with head
+// -sequence is the sequence number of the element at tail: how many elements
+//  have left a FIFO buffer, popped, discarded or overwritten, plus the runs
+//  of refused elements the tail has passed. It is written wherever tail is
+// -A B_DROP FIFO buffer that refused elements after some it still holds has
+//  a gap: skipped elements are numbered between the element before slot gap
+//  and the one in it. skipped is 0 with no gap. Refusals that come while the
+//  gap is still ahead of the tail, behind elements pushed after it, are
+//  counted in pushed alone; they make up the next gap, at head, once the
+//  tail reaches this one (see Warnings). Both are written by refused pushes
+//  and by pops that reach the gap, and share tail's cache line
+// -The behaviour bits are unsigned char bit-fields, so behavior takes one
+//  byte rather than an int's worth
+// -data is the only pointer, so the storage can be moved (memcpy, shared
+//  memory mapped at another address, ...) by copying it and updating data
+// -Fields nothing writes after newBuffer() come first, then head (written by
+//  pushes, and by pops of stacks), then tail (written by FIFO pops)
+// -By default the whole header fits in one cache line, which suits thousands
+//  of buffers each used by one thread. When one thread pushes and another
+//  pops (under a lock of their own), build everything that includes buffer.h
+//  with -DB_SEPARATE_LINES. head and tail then each get a cache line of their
+//  own, so the two threads stop stealing one line from each other, at the
+//  cost of a 3-line (192 or 384 byte) header
+#ifdef B_SEPARATE_LINES
+#define B_OWN_LINE          __attribute__((aligned(B_CACHE_LINE)))
+#else
+#define B_OWN_LINE
+#endif
+
+// -Compile-time check that a member starts a cache line and that nothing else
+//  shares its line(s) before end (the offset of the next member, or the size
+//  of the struct), for use on every struct with per-thread lines
+#define B_ASSERT_OWN_LINE(type, member, end) \
+    _Static_assert( (__builtin_offsetof(type, member) % B_CACHE_LINE == 0) && \
+                    ((end) - __builtin_offsetof(type, member) >= B_CACHE_LINE), \
+                    #type "." #member " must have a cache line to itself" )
+
 typedef struct B_BUFFER {
     void *data;
-    void *head;
-    void *tail;
     unsigned int depth;
     unsigned char width;
     union B_BEHAVIOR {
         unsigned char byte;
         struct B_BITS {
-            unsigned unused:6;
-            unsigned overwrite:1;
-            unsigned stack:1;
+            unsigned char heap:1;
+            unsigned char unused:5;
+            unsigned char overwrite:1;
+            unsigned char stack:1;
         } bits;
     } behavior;
+    unsigned int head B_OWN_LINE;
+    unsigned long long pushed;
+    unsigned int tail B_OWN_LINE;
+    unsigned int gap;
+    unsigned long long sequence;
+    unsigned long long skipped;
 } buffer_t;
 
+#ifdef B_SEPARATE_LINES
+B_ASSERT_OWN_LINE(buffer_t, head, __builtin_offsetof(buffer_t, tail));
+B_ASSERT_OWN_LINE(buffer_t, tail, sizeof(buffer_t));
+#else
+_Static_assert( sizeof(buffer_t) <= B_CACHE_LINE, "buffer_t must fit in a cache line" );
+#endif
+
+// -A run of elements lying next to each other in a buffer's storage, for
+//  reading or writing it in place
+typedef struct B_SEGMENT {
+    void *data;
+    unsigned int count;
+} buffersegment_t;
+
+
+//------------------------------------------------------------------------------
+// Fixed-capacity buffers
+//------------------------------------------------------------------------------
+// -Declare a buffer whose capacity and element size are known at compile time,
+//  without calling malloc. The declaration creates a pointer called 'name'
+//  that is used with the same functions as a buffer from newBuffer(), e.g.:
+//      BUFFER_DECLARE(samples, 256, sizeof(int), B_FIFO & B_DROP);
+//      ...
+//      pushToBuffer(samples, &sample, 1);
+// -BUFFER_DECLARE uses static storage, so it may appear at file scope or
+//  inside a function (where it keeps its contents between calls)
+// -BUFFER_DECLARE_LOCAL uses automatic (stack) storage, so it may only appear
+//  inside a function and the buffer disappears when the function returns
+// -BUFFER_CAPACITY(name) and BUFFER_WIDTH(name) are integer constant
+//  expressions, so they can size arrays or appear in static assertions
+// -BUFFER_PUSH(name, d, l) and BUFFER_POP(name, d, l) behave exactly like
+//  pushToBuffer() and popFromBuffer() on a declared buffer, but are inlined
+//  with its depth and width as constants, so the wrap arithmetic and the
+//  copies of small elements fold into a few instructions, e.g.:
+//      BUFFER_PUSH(samples, &sample, 1);
+//      BUFFER_POP(samples, &sample, 1);
+//  Both kinds of call can be mixed on the same buffer
+// -Never call freeBuffer() on a declared buffer
+#define BUFFER_DECLARE(name, numberOfElements, elementSizeInBytes, config) \
+    B_DECLARE(static, name, numberOfElements, elementSizeInBytes, config)
+
+#define BUFFER_DECLARE_LOCAL(name, numberOfElements, elementSizeInBytes, config) \
+    B_DECLARE(, name, numberOfElements, elementSizeInBytes, config)
+
+#define BUFFER_CAPACITY(name)   (sizeof(name##Data) / sizeof(name##Data[0]) - 1)
+#define BUFFER_WIDTH(name)      (sizeof(name##Data[0]))
+
+// -Storage layout must match newBuffer(): one spare element of storage and a
+//  depth of numberOfElements + 1
+// -The lowest behaviour bit is cleared, marking the buffer as not on the heap
+#define B_DECLARE(storage, name, numberOfElements, elementSizeInBytes, config) \
+    _Static_assert( ((elementSizeInBytes) > 0) && ((elementSizeInBytes) < 256), \
+                    "buffer element size must fit in an unsigned char" ); \
+    storage unsigned char name##Data[(numberOfElements) + 1][(elementSizeInBytes)]; \
+    storage buffer_t name##Buffer = { \
+        .data = name##Data, \
+        .head = 0, \
+        .pushed = 0, \
+        .tail = 0, \
+        .gap = 0, \
+        .sequence = 0, \
+        .skipped = 0, \
+        .depth = (numberOfElements) + 1, \
+        .width = (elementSizeInBytes), \
+        .behavior = { .byte = (config) & 0xFE } \
+    }; \
+    storage buffer_t * const name = &name##Buffer
+
+#define BUFFER_PUSH(name, d, l) \
+    pushToFixedBuffer(name, d, l, BUFFER_CAPACITY(name) + 1, BUFFER_WIDTH(name))
+
+#define BUFFER_POP(name, d, l) \
+    popFromFixedBuffer(name, d, l, BUFFER_CAPACITY(name) + 1, BUFFER_WIDTH(name))
+
+// -What pushes and pops do when a B_DROP buffer refuses elements or reaches a
+//  gap, shared by the functions below and the ones in buffer.c. Never call
+//  them directly
+// -admitToBuffer() is called once pushed counts the l elements, with room
+//  free slots, and returns how many of them to keep
+// -passBufferGap() is called by a FIFO pop or discard of l of the count
+//  elements held, before it moves tail on
+unsigned int admitToBuffer(buffer_t *b, unsigned int l, unsigned int room);
+void passBufferGap(buffer_t *b, unsigned int l, unsigned int count);
+
+// -The bodies of pushToBuffer() and popFromBuffer() (without the prefetching,
+//  which only pays for long pops) with depth and width passed in, for
+//  BUFFER_PUSH and BUFFER_POP to call with constants. Copies that don't wrap
+//  are one memcpy() of l * width bytes, which is a constant, and so a plain
+//  load and store, whenever l is
+// -Call them through the macros, which can't pass a depth or width the
+//  storage doesn't have
+static inline __attribute__((always_inline))
+unsigned int pushToFixedBuffer(buffer_t *b, const void *d, unsigned int l, unsigned int depth, unsigned int width) {
+    unsigned char *data = b->data;
+    const unsigned char *in = d;
+    unsigned int room, failed = 0, first;
+
+    room = depth - 1 - ((b->head >= b->tail) ? b->head - b->tail : b->head + depth - b->tail);
+    b->pushed += l;
+    if (l > room) {
+        if ( !(b->behavior.bits.overwrite) ) {
+            failed = l;
+            l = admitToBuffer(b, l, room);
+            failed -= l;
+        }
+        else {
+            b->sequence += l - room;
+            if (l > depth - 1) {
+                in += (l - (depth - 1)) * width;
+                l = depth - 1;
+            }
+            b->tail += l - room;
+            if (b->tail >= depth) {
+                b->tail -= depth;
+            }
+        }
+    }
+    if (b->head + l <= depth) {
+        memcpy(data + b->head * width, in, l * width);
+    }
+    else {
+        first = depth - b->head;
+        memcpy(data + b->head * width, in, first * width);
+        memcpy(data, in + first * width, (l - first) * width);
+    }
+    b->head += l;
+    if (b->head >= depth) {
+        b->head -= depth;
+    }
+    return failed;
+}
+
+static inline __attribute__((always_inline))
+unsigned int popFromFixedBuffer(buffer_t *b, void *d, unsigned int l, unsigned int depth, unsigned int width) {
+    unsigned char *data = b->data, *out = d;
+    unsigned int count, failed = 0, i, first;
+
+    count = (b->head >= b->tail) ? b->head - b->tail : b->head + depth - b->tail;
+    if (l > count) {
+        failed = l - count;
+        l = count;
+    }
+    if (b->behavior.bits.stack) {
+        for (i = 0; i < l; i++) {
+            if (b->head == 0) {
+                b->head = depth;
+            }
+            b->head--;
+            memcpy(out + i * width, data + b->head * width, width);
+        }
+    }
+    else {
+        if (b->skipped) {
+            passBufferGap(b, l, count);
+        }
+        if (b->tail + l <= depth) {
+            memcpy(out, data + b->tail * width, l * width);
+        }
+        else {
+            first = depth - b->tail;
+            memcpy(out, data + b->tail * width, first * width);
+            memcpy(out + first * width, data, (l - first) * width);
+        }
+        b->tail += l;
+        if (b->tail >= depth) {
+            b->tail -= depth;
+        }
+        b->sequence += l;
+    }
+    return failed;
+}
+
 
 //------------------------------------------------------------------------------
 // Function prototypes
@@ -107,7 +405,7 @@ typedef struct B_BUFFER {
 // -Because the buffer is stored in the heap, it must be freed using the
 //  freeBuffer() function described below.
 // -Take care when freeing a buffer referenced by multiple pointers
-// -Never use free(b), as b contains pointers to allocated memory that must be
+// -Never use free(b), as b contains a pointer to allocated memory that must be
 //  freed first
 // -A NULL return implies that the buffer was not properly initialized,
 //  typically because there was not enough free memory in the heap
@@ -121,9 +419,9 @@ typedef struct B_BUFFER {
 buffer_t* newBuffer(unsigned int numberOfElements, unsigned char elementSizeInBytes, unsigned char config);
 
 // --------------------------- Free the buffer -------------------------------
-// -All pointers within b are set to NULL before b is freed
+// -The data pointer within b is set to NULL before b is freed
 // -Take care when freeing a buffer referenced by multiple pointers
-// -Never use free(b), as b contains pointers to allocated memory that must be
+// -Never use free(b), as b contains a pointer to allocated memory that must be
 //  freed first
 // -Example usage:
 //      buffer_t *b;
@@ -132,6 +430,39 @@ buffer_t* newBuffer(unsigned int numberOfElements, unsigned char elementSizeInBy
 //      freeBuffer(b);
 void freeBuffer(buffer_t *b);
 
+// ------------------ Generate many identical buffers at once -----------------
+// -Creates count buffers, as newBuffer(numberOfElements, elementSizeInBytes,
+//  config) would, with one heap allocation for all headers and storage
+// -The return value is an array of count buffer_t, so the handle of buffer i
+//  is &bs[i]. Headers sit next to each other, and each buffer's storage
+//  starts on its own B_CACHE_LINE
+// -A NULL return implies that there was not enough free memory in the heap,
+//  or that count buffers of this size would need more bytes than an unsigned
+//  long can hold
+// -Free the whole array with freeBufferArray(), never freeBuffer() on one of
+//  its buffers
+// -Example usage:
+//      buffer_t *bs;
+//      bs = newBufferArray(10000, 16, sizeof(int), B_FIFO & B_DROP);
+//      if ( bs == NULL ) return -1;
+//      pushToBuffer(&bs[42], &request, 1);
+//      ...
+//      freeBufferArray(bs);
+buffer_t* newBufferArray(unsigned int count, unsigned int numberOfElements, unsigned char elementSizeInBytes, unsigned char config);
+
+// ----------------------- Free an array of buffers --------------------------
+// -bs must have come from newBufferArray(); all its buffers go at once
+void freeBufferArray(buffer_t *bs);
+
+// -------------------- Set up a buffer over existing storage -----------------
+// -Makes b an empty buffer of numberOfElements elements of elementSizeInBytes
+//  bytes, held in storage, which must have room for numberOfElements + 1 of
+//  them (one spare, as newBuffer() allocates)
+// -For code that places headers and storage itself (pools, chunks, mapped
+//  pages). Neither is freed by the library, so never call freeBuffer() on b
+// -Every field is set here, so callers keep working as buffer_t gains fields
+void initBuffer(buffer_t *b, void *storage, unsigned int numberOfElements, unsigned char elementSizeInBytes, unsigned char config);
+
 // ------------------- Check whether the buffer is empty ----------------------
 // -A return value of 1 implies the buffer is empty, zero implies not empty
 // -Example usage:
@@ -158,6 +489,7 @@ unsigned char isBufferFull(buffer_t *b);
 // starting at the memory location pointed to by d
 // -The return value is the number of elements that could not be popped
 // -The return value is always zero using B_OVERWRITE
+// -Pops prefetch B_PREFETCH_DISTANCE bytes ahead of what they copy
 // -Example usage:
 //      buffer_t *b;
 //      int output[16];
@@ -180,4 +512,85 @@ unsigned int popFromBuffer(buffer_t *b, void *d, unsigned int l);
 //      failedBytes = pushToBuffer(b, &input[0], 4);
 unsigned int pushToBuffer(buffer_t *b, void *d, unsigned int l);
 
+// -------------------- Look at the elements in the buffer --------------------
+// -Fills segments[0] and segments[1] with the elements in the buffer, oldest
+//  first, without copying or removing them. segments[1] is only used when the
+//  elements wrap round the end of the storage; otherwise its count is zero
+// -The return value is the number of elements in the buffer
+// -The segments stay valid until the next push, pop or discard
+// -For FIFO buffers; a stack pops from the other end
+// -Example usage:
+//      buffersegment_t s[2];
+//      peekBuffer(b, s);
+//      fwrite(s[0].data, b->width, s[0].count, f);
+//      fwrite(s[1].data, b->width, s[1].count, f);
+//      discardFromBuffer(b, s[0].count + s[1].count);
+unsigned int peekBuffer(buffer_t *b, buffersegment_t segments[2]);
+
+// ---------------- Discard the oldest elements from the buffer ---------------
+// -Removes the l oldest elements without copying them anywhere, e.g. once
+//  they have been read in place with peekBuffer()
+// -The return value is the number of elements that could not be discarded
+// -For FIFO buffers; a stack pops from the other end
+unsigned int discardFromBuffer(buffer_t *b, unsigned int l);
+
+// ---------------------- Look at the free space in the buffer ----------------
+// -Fills segments[0] and segments[1] with the free slots after the newest
+//  element, so elements can be written (or read from a file or socket)
+//  straight into the buffer. segments[1] is only used when the free slots
+//  wrap round the end of the storage; otherwise its count is zero
+// -The return value is the number of free slots. Nothing is overwritten, even
+//  with B_OVERWRITE
+// -Write to the start of segments[0] first, then segments[1], and make the
+//  elements part of the buffer with commitToBuffer()
+// -Example usage:
+//      buffersegment_t s[2];
+//      reserveInBuffer(b, s);
+//      received = read(socket, s[0].data, s[0].count);
+//      if (received > 0) commitToBuffer(b, received);
+unsigned int reserveInBuffer(buffer_t *b, buffersegment_t segments[2]);
+
+// ------------------- Add elements written in place to the buffer ------------
+// -Adds the next l slots returned by reserveInBuffer() as the newest elements
+// -The return value is the number of elements that could not be added
+//  because there were fewer than l free slots
+unsigned int commitToBuffer(buffer_t *b, unsigned int l);
+
+// ------------------- Bytes of memory used by the buffer ---------------------
+// -Counts the buffer_t header and the element storage, including the spare
+//  element that newBuffer() allocates
+// -For buffers from newBuffer(), each of the two heap blocks is rounded up to
+//  what the allocator actually reserves, as modelled by the B_MALLOC_*
+//  constants above; buffers from BUFFER_DECLARE or newBufferArray() have no
+//  allocator overhead of their own
+// -Divide by the number of elements the buffer holds for the overhead per
+//  element, e.g.:
+//      buffer_t *b;
+//      b = newBuffer(16, sizeof(int), B_FIFO & B_DROP);
+//      printf("%lu bytes, %.1f per element", bufferMemoryUsage(b),
+//             bufferMemoryUsage(b) / 16.0);
+unsigned long bufferMemoryUsage(buffer_t *b);
+
+// ---------------- Sequence number of the oldest element ---------------------
+// -The number the next FIFO pop or discard starts at, or the next push gets
+//  if the buffer is empty. It never goes down, and jumps past the elements
+//  a B_DROP buffer refused once the tail reaches them
+// -For FIFO buffers; a stack's pops leave it alone
+unsigned long long bufferSequence(buffer_t *b);
+
+// ---------------- Pop data, with the sequence number of the first -----------
+// -As popFromBuffer(), setting *sequence to the sequence number of the first
+//  element popped. The elements popped are numbered from there on, one
+//  apart: a pop stops short at a run of refused elements, and the next one
+//  starts after it. A jump from the last one the consumer saw is the number
+//  of elements it missed. A consumer that records the next number it needs
+//  can skip anything below it, so handling a batch twice does no harm
+// -For FIFO buffers
+// -Example usage:
+//      unsigned long long first;
+//      n = 64 - popSequencedFromBuffer(b, &batch[0], 64, &first);
+//      for (i = (first < next) ? next - first : 0; i < n; i++) handle(&batch[i]);
+//      if (first + n > next) next = first + n;
+unsigned int popSequencedFromBuffer(buffer_t *b, void *d, unsigned int l, unsigned long long *sequence);
+
 #endif
\ No newline at end of file
@@ -0,0 +1,517 @@
+//==============================================================================
+//                               bufferfollow.c
+//------------------------------------------------------------------------------
+// Brief
+//   Follows growing files, as tail -F does, reading what is appended straight
+//   into a buffer_t per file
+//
+// Contents
+//   - newFollower
+//   - freeFollower
+//   - followFile
+//   - unfollowFile
+//   - followerDescriptor
+//   - pollFollower
+//   - followedOffset
+//   - findFollowWatch (private)
+//   - addFollowWatch (private)
+//   - dropFollowWatch (private)
+//   - markFollowedFile (private)
+//   - openFollowedFile (private)
+//   - closeFollowedFile (private)
+//   - readFollowedFile (private)
+//   - readFollowEvents (private)
+//
+// Description
+//   Each open file has a watch of its own, for appends (IN_MODIFY) and for
+//   being renamed, deleted or unlinked (IN_MOVE_SELF, IN_DELETE_SELF,
+//   IN_ATTRIB), and each directory holding followed files has one shared
+//   watch for names appearing in it (IN_CREATE, IN_MOVED_TO). Watch
+//   descriptors map back to files through a hash table, so an event costs the
+//   same however many files are followed. Events only put files on the
+//   pending list; pollFollower() then reads each pending file once, however
+//   many events it had.
+//   A file that may have been replaced is checked with stat() on its path
+//   once the open file has been read to its end, and swapped for what is
+//   there now if that is a different file.
+//
+// Author
+//   Daniel Wilkinson-Thompson (daniel@wilkinson-thompson.com)
+//
+// Date
+//   2026-10-18
+//
+// Licence
+//   Copyright (c) 2026 Daniel Wilkinson-Thompson. All rights reserved.
+//------------------------------------------------------------------------------
+
+#ifndef BUFFERFOLLOW_C
+#define BUFFERFOLLOW_C
+
+//------------------------------------------------------------------------------
+// Headers
+//------------------------------------------------------------------------------
+#define _GNU_SOURCE
+#include "bufferfollow.h"
+#include "bufferio.h"
+#include <fcntl.h>
+#include <poll.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/inotify.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+//------------------------------------------------------------------------------
+// Constants
+//------------------------------------------------------------------------------
+// Watch hash table slots to start with (a power of two)
+#ifndef B_FOLLOW_SLOTS
+#define B_FOLLOW_SLOTS          64
+#endif
+
+// Bytes of inotify events read at once
+#ifndef B_FOLLOW_EVENT_BYTES
+#define B_FOLLOW_EVENT_BYTES    16384
+#endif
+
+// Hash table markers for never-used and removed slots
+#define B_FOLLOW_FREE           -1
+#define B_FOLLOW_REMOVED        -2
+
+// Events watched for
+#define B_FOLLOW_FILE_EVENTS    (IN_MODIFY | IN_MOVE_SELF | IN_DELETE_SELF | IN_ATTRIB)
+#define B_FOLLOW_DIR_EVENTS     (IN_CREATE | IN_MOVED_TO | IN_ONLYDIR)
+
+//------------------------------------------------------------------------------
+// Private function prototypes
+//------------------------------------------------------------------------------
+followwatch_t* findFollowWatch(follower_t *f, int wd);
+followwatch_t* addFollowWatch(follower_t *f, int wd, followedfile_t *file);
+void dropFollowWatch(follower_t *f, int wd);
+void markFollowedFile(follower_t *f, followedfile_t *file);
+void openFollowedFile(follower_t *f, followedfile_t *file);
+void closeFollowedFile(follower_t *f, followedfile_t *file);
+unsigned long readFollowedFile(follower_t *f, followedfile_t *file);
+void readFollowEvents(follower_t *f);
+
+//------------------------------------------------------------------------------
+// Functions
+//------------------------------------------------------------------------------
+// Generate follower
+follower_t* newFollower(void) {
+    follower_t *f;
+    unsigned int i;
+
+    f = malloc(sizeof(follower_t));
+    if ( !(f) ) {
+        return NULL;
+    }
+    f->watches = malloc(B_FOLLOW_SLOTS * sizeof(followwatch_t));
+    f->inotify = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if ( !(f->watches) || (f->inotify < 0) ) {
+        if (f->inotify >= 0) {
+            close(f->inotify);
+        }
+        free(f->watches);
+        free(f);
+        return NULL;
+    }
+    for (i = 0; i < B_FOLLOW_SLOTS; i++) {
+        f->watches[i].wd = B_FOLLOW_FREE;
+    }
+    f->slots = B_FOLLOW_SLOTS;
+    f->used = 0;
+    f->files = NULL;
+    f->pending = NULL;
+    return f;
+}
+
+// Free follower
+void freeFollower(follower_t *f) {
+    while (f->files) {
+        unfollowFile(f, f->files);
+    }
+    close(f->inotify);
+    free(f->watches);
+    f->watches = NULL;
+    free(f);
+}
+
+// Slot holding a watch, or NULL
+followwatch_t* findFollowWatch(follower_t *f, int wd) {
+    unsigned int i, mask = f->slots - 1;
+
+    for (i = (unsigned int)wd & mask; f->watches[i].wd != B_FOLLOW_FREE; i = (i + 1) & mask) {
+        if (f->watches[i].wd == wd) {
+            return &(f->watches[i]);
+        }
+    }
+    return NULL;
+}
+
+// Add a watch, or another user of a directory watch
+// -The table doubles once it is half used (removed slots included), so
+//  probes stay short
+// -The return value is NULL if there was not enough memory
+followwatch_t* addFollowWatch(follower_t *f, int wd, followedfile_t *file) {
+    followwatch_t *w, *old = f->watches;
+    unsigned int i, j, mask, slots = f->slots;
+
+    w = findFollowWatch(f, wd);
+    if (w) {
+        w->users++;
+        w->file = file;
+        return w;
+    }
+
+    if ( 2 * (f->used + 1) > f->slots ) {
+        while ( 2 * (f->used + 1) > slots ) {
+            slots *= 2;
+        }
+        w = malloc(slots * sizeof(followwatch_t));
+        if ( !(w) ) {
+            return NULL;
+        }
+        for (i = 0; i < slots; i++) {
+            w[i].wd = B_FOLLOW_FREE;
+        }
+        f->used = 0;
+        mask = slots - 1;
+        for (i = 0; i < f->slots; i++) {
+            if (old[i].wd >= 0) {
+                for (j = (unsigned int)old[i].wd & mask; w[j].wd != B_FOLLOW_FREE; j = (j + 1) & mask);
+                w[j] = old[i];
+                f->used++;
+            }
+        }
+        f->watches = w;
+        f->slots = slots;
+        free(old);
+    }
+
+    mask = f->slots - 1;
+    for (i = (unsigned int)wd & mask; f->watches[i].wd >= 0; i = (i + 1) & mask);
+    if (f->watches[i].wd == B_FOLLOW_FREE) {
+        f->used++;
+    }
+    w = &(f->watches[i]);
+    w->wd = wd;
+    w->users = 1;
+    w->file = file;
+    return w;
+}
+
+// Drop one user of a watch, removing it from inotify with the last
+// -The removed slot is kept marked so later watches are still found
+void dropFollowWatch(follower_t *f, int wd) {
+    followwatch_t *w = findFollowWatch(f, wd);
+
+    if ( w && (--(w->users) == 0) ) {
+        inotify_rm_watch(f->inotify, wd);
+        w->wd = B_FOLLOW_REMOVED;
+    }
+}
+
+// Put a file on the pending list
+void markFollowedFile(follower_t *f, followedfile_t *file) {
+    if ( !(file->pending) ) {
+        file->pending = 1;
+        file->nextPending = f->pending;
+        f->pending = file;
+    }
+}
+
+// Open what is at the file's path and watch it
+// -fd stays -1 if there is nothing there
+void openFollowedFile(follower_t *f, followedfile_t *file) {
+    struct stat st;
+    int wd;
+
+    file->fd = open(file->path, O_RDONLY | O_CLOEXEC);
+    if (file->fd < 0) {
+        return;
+    }
+    if ( fstat(file->fd, &st) ||
+         ((wd = inotify_add_watch(f->inotify, file->path, B_FOLLOW_FILE_EVENTS)) < 0) ||
+         !(addFollowWatch(f, wd, file)) ) {
+        close(file->fd);
+        file->fd = -1;
+        return;
+    }
+    file->watch = wd;
+    file->inode = st.st_ino;
+    file->device = st.st_dev;
+}
+
+// Stop reading the open file
+void closeFollowedFile(follower_t *f, followedfile_t *file) {
+    if (file->fd >= 0) {
+        close(file->fd);
+        file->fd = -1;
+    }
+    if (file->watch >= 0) {
+        dropFollowWatch(f, file->watch);
+        file->watch = -1;
+    }
+}
+
+// Read everything new, replacing the file if it was rotated
+// -Sets stalled if the file must be read again once its buffer has been
+//  popped from
+// -The return value is the number of bytes read
+unsigned long readFollowedFile(follower_t *f, followedfile_t *file) {
+    unsigned long total = 0;
+    struct stat st;
+    long n;
+
+    file->stalled = 0;
+    for (;;) {
+        if (file->fd >= 0) {
+
+            // Shrunk below what has been read: truncated, so start again
+            if ( !(fstat(file->fd, &st)) && ((unsigned long long)st.st_size < file->offset) ) {
+                if ( !(isBufferEmpty(file->b)) ) {
+                    file->stalled = 1;
+                    return total;
+                }
+                file->offset = 0;
+                file->truncations++;
+            }
+
+            // One read fills the buffer or reaches the end of the file
+            n = preadToBuffer(file->b, file->fd, file->offset);
+            if (n > 0) {
+                file->offset += n;
+                total += n;
+            }
+            if (isBufferFull(file->b)) {
+                file->stalled = 1;
+                return total;
+            }
+        }
+        if ( !(file->moved) ) {
+            return total;
+        }
+
+        // The path may hold another file now. Nothing there yet leaves the
+        // old one open, and its directory's watch says when something is
+        if (stat(file->path, &st)) {
+            return total;
+        }
+        file->moved = 0;
+        if ( (file->fd >= 0) && (st.st_ino == file->inode) && (st.st_dev == file->device) ) {
+            return total;
+        }
+        if ( !(isBufferEmpty(file->b)) ) {
+            file->moved = 1;
+            file->stalled = 1;
+            return total;
+        }
+        if (file->fd >= 0) {
+            file->rotations++;
+        }
+        closeFollowedFile(f, file);
+        file->offset = 0;
+        openFollowedFile(f, file);
+        if (file->fd < 0) {
+            file->moved = 1;
+            return total;
+        }
+    }
+}
+
+// Mark every file an event is about
+void readFollowEvents(follower_t *f) {
+    char events[B_FOLLOW_EVENT_BYTES] __attribute__((aligned(__alignof__(struct inotify_event))));
+    struct inotify_event *e;
+    followedfile_t *file;
+    followwatch_t *w;
+    long n, i;
+
+    while ( (n = read(f->inotify, events, sizeof(events))) > 0 ) {
+        for (i = 0; i < n; i += sizeof(struct inotify_event) + e->len) {
+            e = (struct inotify_event*)(events + i);
+
+            // The kernel's event queue overflowed (wd is -1), so events were
+            // lost: any followed file may have grown or been replaced
+            if (e->mask & IN_Q_OVERFLOW) {
+                for (file = f->files; file; file = file->next) {
+                    file->moved = 1;
+                    markFollowedFile(f, file);
+                }
+                continue;
+            }
+
+            w = findFollowWatch(f, e->wd);
+            if ( !(w) ) {
+                continue;
+            }
+
+            // A name appeared in a directory: any file followed by that name
+            // may have been replaced
+            if ( !(w->file) ) {
+                for (file = f->files; file; file = file->next) {
+                    if ( (file->directory == e->wd) && e->len && !(strcmp(file->name, e->name)) ) {
+                        file->moved = 1;
+                        markFollowedFile(f, file);
+                    }
+                }
+                continue;
+            }
+
+            file = w->file;
+            if ( e->mask & (IN_MOVE_SELF | IN_DELETE_SELF | IN_ATTRIB) ) {
+                file->moved = 1;
+            }
+            markFollowedFile(f, file);
+
+            // inotify removed the watch itself (the file is gone): forget it
+            // without calling inotify_rm_watch() on a descriptor it may reuse
+            if (e->mask & IN_IGNORED) {
+                w->wd = B_FOLLOW_REMOVED;
+                if (file->watch == e->wd) {
+                    file->watch = -1;
+                }
+            }
+        }
+    }
+}
+
+// Follow a file
+followedfile_t* followFile(follower_t *f, const char *path, buffer_t *b, unsigned long long offset) {
+    followedfile_t *file;
+    struct stat st;
+    unsigned long length = strlen(path);
+    char *slash;
+    int wd;
+
+    file = malloc(sizeof(followedfile_t) + length + 1);
+    if ( !(file) ) {
+        return NULL;
+    }
+    file->path = (char*)(file + 1);
+    memcpy(file->path, path, length + 1);
+
+    // Watch the directory for the name (re)appearing
+    slash = strrchr(file->path, '/');
+    if (slash == file->path) {
+        wd = inotify_add_watch(f->inotify, "/", B_FOLLOW_DIR_EVENTS);
+    }
+    else if (slash) {
+        *slash = '\0';
+        wd = inotify_add_watch(f->inotify, file->path, B_FOLLOW_DIR_EVENTS);
+        *slash = '/';
+    }
+    else {
+        wd = inotify_add_watch(f->inotify, ".", B_FOLLOW_DIR_EVENTS);
+    }
+    if ( (wd < 0) || !(addFollowWatch(f, wd, NULL)) ) {
+        free(file);
+        return NULL;
+    }
+    file->directory = wd;
+    file->name = slash ? slash + 1 : file->path;
+
+    file->b = b;
+    file->context = NULL;
+    file->rotations = 0;
+    file->truncations = 0;
+    file->watch = -1;
+    file->moved = 0;
+    file->stalled = 0;
+    file->pending = 0;
+    file->nextPending = NULL;
+    file->offset = 0;
+
+    // Resume at offset if the file is still long enough to have it
+    openFollowedFile(f, file);
+    if (file->fd < 0) {
+        file->moved = 1;
+    }
+    else if ( !(fstat(file->fd, &st)) ) {
+        if (offset == B_FOLLOW_END) {
+            file->offset = st.st_size;
+        }
+        else if ((unsigned long long)st.st_size >= offset) {
+            file->offset = offset;
+        }
+    }
+
+    file->previous = NULL;
+    file->next = f->files;
+    if (f->files) {
+        f->files->previous = file;
+    }
+    f->files = file;
+    markFollowedFile(f, file);
+    return file;
+}
+
+// Stop following a file
+void unfollowFile(follower_t *f, followedfile_t *file) {
+    followedfile_t **p;
+
+    if (file->pending) {
+        for (p = &(f->pending); *p != file; p = &((*p)->nextPending));
+        *p = file->nextPending;
+    }
+    if (file->previous) {
+        file->previous->next = file->next;
+    }
+    else {
+        f->files = file->next;
+    }
+    if (file->next) {
+        file->next->previous = file->previous;
+    }
+    closeFollowedFile(f, file);
+    dropFollowWatch(f, file->directory);
+    free(file);
+}
+
+// Descriptor to wait on
+int followerDescriptor(follower_t *f) {
+    return f->inotify;
+}
+
+// Read what has been appended
+unsigned int pollFollower(follower_t *f, int timeout, followedfile_t **ready, unsigned int max) {
+    struct pollfd events = { .fd = f->inotify, .events = POLLIN };
+    followedfile_t *file, *stalled = NULL, **last = &stalled;
+    unsigned int count = 0;
+
+    if ( !(f->pending) && (timeout != 0) ) {
+        poll(&events, 1, timeout);
+    }
+    readFollowEvents(f);
+
+    // Read each pending file once; those that stalled are ready too, since
+    // their buffers must be popped from, and go back on the list
+    while ( f->pending && (count < max) ) {
+        file = f->pending;
+        f->pending = file->nextPending;
+        file->pending = 0;
+        if ( readFollowedFile(f, file) || file->stalled ) {
+            ready[count++] = file;
+        }
+        if (file->stalled) {
+            file->pending = 1;
+            file->nextPending = NULL;
+            *last = file;
+            last = &(file->nextPending);
+        }
+    }
+    *last = f->pending;
+    f->pending = stalled;
+    return count;
+}
+
+// Offset to resume from
+unsigned long long followedOffset(followedfile_t *file) {
+    buffersegment_t s[2];
+
+    return file->offset - peekBuffer(file->b, s);
+}
+
+#endif
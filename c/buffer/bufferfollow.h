@@ -0,0 +1,188 @@
+//==============================================================================
+//                               bufferfollow.h
+//------------------------------------------------------------------------------
+// Brief
+//   Follows growing files, as tail -F does, reading what is appended straight
+//   into a buffer_t per file
+//
+// Contents
+//   - newFollower
+//   - freeFollower
+//   - followFile
+//   - unfollowFile
+//   - followerDescriptor
+//   - pollFollower
+//   - followedOffset
+//
+// Description
+//   A follower watches any number of files with one inotify descriptor, so a
+//   single thread sleeps until one of them changes and then only touches
+//   those that did. New bytes are read with preadv() at the file offset
+//   straight into the free space of the file's buffer, with no temporary
+//   array. Log rotation is followed:
+//   -rename and create (logrotate's default): the old file is read to its
+//    end, then the new file at the same path is followed from its start
+//   -copy and truncate: a file that shrinks below the offset read so far is
+//    read again from its start
+//   -delete and create: as for rename
+//   Each file's buffer only ever holds bytes of the file being followed, so
+//   followedOffset() is exactly where a consumer that has popped everything
+//   so far would resume. Store it with the data the consumer produced, and
+//   pass it to followFile() after a restart.
+//   Declaration
+//      follower_t *f;
+//      followedfile_t *log, *ready[64];
+//      f = newFollower();
+//      log = followFile(f, "/var/log/app.log", newBuffer(65536, 1, B_FIFO & B_DROP), savedOffset);
+//   Following
+//      for (;;) {
+//          n = pollFollower(f, -1, ready, 64);
+//          for (i = 0; i < n; i++) {
+//              ...pop or decodeFrame() from ready[i]->b...
+//              saveOffset(ready[i]->path, followedOffset(ready[i]));
+//          }
+//      }
+//   To wait on other descriptors as well, add followerDescriptor(f) to an
+//   epoll set and call pollFollower(f, 0, ...) when it is readable.
+//
+// Warnings
+//  -Followers are not thread-safe: one thread polls, and pops from the
+//   buffers between polls
+//  -Each followed file needs its own FIFO buffer of 1-byte elements, empty
+//   when followFile() is called. A full buffer stops reading that file until
+//   it has been popped from; the file stays ready so the next pollFollower()
+//   carries on without waiting
+//  -A rotated or truncated file is only replaced once its buffer is empty,
+//   so pop everything out of each ready file's buffer between polls
+//  -Truncation is spotted when the file is smaller than what has been read.
+//   If it grows past that again before pollFollower() looks, the truncation
+//   is missed, as with tail -F
+//  -Bytes appended to a file after it has been renamed and its replacement
+//   has been read from are lost
+//  -If the kernel's inotify queue overflows, events are lost, so every
+//   followed file is read and its path checked again on the next poll
+//  -Never follow the same file twice with one follower. inotify watches are
+//   per file and directory, not per path
+//  -Linux-only
+//
+// Author
+//   Daniel Wilkinson-Thompson (daniel@wilkinson-thompson.com)
+//
+// Date
+//   2026-10-18
+//
+// Licence
+//   Copyright (c) 2026 Daniel Wilkinson-Thompson. All rights reserved.
+//------------------------------------------------------------------------------
+
+#ifndef BUFFERFOLLOW_H
+#define BUFFERFOLLOW_H
+
+//------------------------------------------------------------------------------
+// Headers
+//------------------------------------------------------------------------------
+#include "buffer.h"
+
+//------------------------------------------------------------------------------
+// Constants
+//------------------------------------------------------------------------------
+// followFile() offset that starts at the current end of the file
+#define B_FOLLOW_END        (~0ULL)
+
+
+//------------------------------------------------------------------------------
+// Type definitions
+//------------------------------------------------------------------------------
+// -One followed file. path, b and context are the caller's; the rest is
+//  read-only outside bufferfollow.c
+// -offset is the file offset of the next byte to read into b, fd is -1 while
+//  nothing exists at path, and watch is the inotify watch on the open file
+// -moved is set when the file at path may have been replaced, and stalled
+//  while b is full or must be emptied before the file can be replaced
+// -rotations and truncations count how often each has been followed
+typedef struct B_FOLLOWED_FILE {
+    char *path;
+    const char *name;
+    buffer_t *b;
+    void *context;
+    unsigned long long offset;
+    unsigned long long inode;
+    unsigned long long device;
+    unsigned long rotations;
+    unsigned long truncations;
+    int fd;
+    int watch;
+    int directory;
+    unsigned char moved;
+    unsigned char stalled;
+    unsigned char pending;
+    struct B_FOLLOWED_FILE *nextPending;
+    struct B_FOLLOWED_FILE *next;
+    struct B_FOLLOWED_FILE *previous;
+} followedfile_t;
+
+// -One inotify watch: on a followed file, or (file NULL) on a directory
+//  holding users followed files
+typedef struct B_FOLLOW_WATCH {
+    int wd;
+    unsigned int users;
+    followedfile_t *file;
+} followwatch_t;
+
+// -watches is an open-addressing hash table of every watch, by descriptor
+// -pending lists the files to read on the next poll
+typedef struct B_FOLLOWER {
+    int inotify;
+    followwatch_t *watches;
+    unsigned int slots;
+    unsigned int used;
+    followedfile_t *files;
+    followedfile_t *pending;
+} follower_t;
+
+
+//------------------------------------------------------------------------------
+// Function prototypes
+//------------------------------------------------------------------------------
+
+// -------------------------- Generate a new follower -------------------------
+// -A NULL return implies there was not enough memory, or no inotify instance
+//  could be created (see /proc/sys/fs/inotify/max_user_instances)
+follower_t* newFollower(void);
+
+// ----------------------------- Free the follower ----------------------------
+// -Stops following every file. Their buffers are the caller's to free
+void freeFollower(follower_t *f);
+
+// ------------------------------ Follow a file -------------------------------
+// -Starts reading path into b from offset, or from the current end of the
+//  file with B_FOLLOW_END. If the file is smaller than offset it was
+//  truncated or replaced since offset was saved, so it is read from its start
+// -path need not exist yet; it is followed from its start once it does
+// -The return value is NULL if there was not enough memory or the directory
+//  holding path can't be watched
+followedfile_t* followFile(follower_t *f, const char *path, buffer_t *b, unsigned long long offset);
+
+// ---------------------------- Stop following a file -------------------------
+// -The file's buffer is left as it is
+void unfollowFile(follower_t *f, followedfile_t *file);
+
+// ------------------------- Descriptor to wait on ----------------------------
+// -Readable when pollFollower() has something to do
+int followerDescriptor(follower_t *f);
+
+// ------------------------- Read what has been appended ----------------------
+// -Waits up to timeout milliseconds (-1 for ever, 0 not at all) for followed
+//  files to change, unless some are still waiting to be read, then reads
+//  each changed file's new bytes into its buffer
+// -Stores up to max files in ready and returns how many it stored: those that
+//  got new bytes, and those that can't be read further until their buffers
+//  have been popped from. Files beyond max are read by the next call
+unsigned int pollFollower(follower_t *f, int timeout, followedfile_t **ready, unsigned int max);
+
+// --------------------------- Offset to resume from --------------------------
+// -File offset of the oldest byte still in the file's buffer, i.e. of the
+//  next byte a consumer will pop
+unsigned long long followedOffset(followedfile_t *file);
+
+#endif
@@ -0,0 +1,437 @@
+//==============================================================================
+//                               bufferframing.c
+//------------------------------------------------------------------------------
+// Brief
+//   Finds whole messages in a byte stream held in a buffer_t and hands them
+//   out in place, and writes framed messages straight into a buffer_t
+//
+// Contents
+//   - initFrameDecoder
+//   - decodeFrame
+//   - consumeFrame
+//   - maxEncodedFrameLength
+//   - encodeFrame
+//   - frameByte (private)
+//   - findFrameDelimiter (private)
+//   - joinFrameBytes (private)
+//   - unstuffCobsFrame (private)
+//   - unescapeSlipFrame (private)
+//   - putFrameBytes (private)
+//   - putFrameByte (private)
+//
+// Description
+//   The buffer's bytes are looked at through the (at most) two segments
+//   peekBuffer() returns, and frame offsets count from the tail. Delimiters
+//   are found with memchr(). A frame that lies in one segment is used where
+//   it is; one that straddles the two is copied to scratch with two memcpy()
+//   calls. COBS and SLIP output is never longer than its input and never
+//   runs ahead of it, so both decode over their own bytes.
+//   Encoders write through a cursor over the two segments reserveInBuffer()
+//   returns. Runs of bytes that need no stuffing or escaping are copied with
+//   memcpy(); COBS finds each run with memchr() first, so every code byte can
+//   be written before its block.
+//
+// Author
+//   Daniel Wilkinson-Thompson (daniel@wilkinson-thompson.com)
+//
+// Date
+//   2026-10-18
+//
+// Licence
+//   Copyright (c) 2026 Daniel Wilkinson-Thompson. All rights reserved.
+//------------------------------------------------------------------------------
+
+#ifndef BUFFERFRAMING_C
+#define BUFFERFRAMING_C
+
+//------------------------------------------------------------------------------
+// Headers
+//------------------------------------------------------------------------------
+#include "bufferframing.h"
+#include <string.h>
+
+//------------------------------------------------------------------------------
+// Private type definitions
+//------------------------------------------------------------------------------
+// Write position in the free space of a buffer
+typedef struct B_FRAME_CURSOR {
+    buffersegment_t s[2];
+    unsigned int segment;
+    unsigned int offset;
+    unsigned int written;
+} framecursor_t;
+
+//------------------------------------------------------------------------------
+// Private function prototypes
+//------------------------------------------------------------------------------
+unsigned char frameByte(buffersegment_t s[2], unsigned int offset);
+unsigned int findFrameDelimiter(buffersegment_t s[2], unsigned int from, unsigned int count, unsigned char delimiter);
+unsigned char* joinFrameBytes(buffersegment_t s[2], unsigned int from, unsigned int length, unsigned char *scratch);
+long unstuffCobsFrame(unsigned char *frame, unsigned int length);
+long unescapeSlipFrame(unsigned char *frame, unsigned int length);
+void putFrameBytes(framecursor_t *c, const unsigned char *bytes, unsigned int length);
+unsigned char* putFrameByte(framecursor_t *c, unsigned char byte);
+
+//------------------------------------------------------------------------------
+// Functions
+//------------------------------------------------------------------------------
+// Initialize decoder
+unsigned char initFrameDecoder(framedecoder_t *d, unsigned char format, unsigned char option, unsigned int maxLength) {
+    if ( (format > B_FRAME_DELIMITED) ||
+         ( ((format == B_FRAME_LENGTH_BE) || (format == B_FRAME_LENGTH_LE)) &&
+           ((option == 0) || (option > 4) || (maxLength < option)) ) ) {
+        return 1;
+    }
+    d->format = format;
+    d->option = option;
+    d->skipping = 0;
+    d->maxLength = maxLength;
+    d->scanned = 0;
+    return 0;
+}
+
+// Byte at an offset from the tail
+unsigned char frameByte(buffersegment_t s[2], unsigned int offset) {
+    if (offset < s[0].count) {
+        return ((unsigned char*)s[0].data)[offset];
+    }
+    return ((unsigned char*)s[1].data)[offset - s[0].count];
+}
+
+// Offset of the first delimiter at or after from, or count if there is none
+unsigned int findFrameDelimiter(buffersegment_t s[2], unsigned int from, unsigned int count, unsigned char delimiter) {
+    unsigned char *found;
+
+    if (from < s[0].count) {
+        found = memchr((unsigned char*)s[0].data + from, delimiter, s[0].count - from);
+        if (found) {
+            return found - (unsigned char*)s[0].data;
+        }
+        from = s[0].count;
+    }
+    found = memchr((unsigned char*)s[1].data + (from - s[0].count), delimiter, count - from);
+    return found ? s[0].count + (found - (unsigned char*)s[1].data) : count;
+}
+
+// Frame bytes in one piece: in place if they are already, else in scratch
+unsigned char* joinFrameBytes(buffersegment_t s[2], unsigned int from, unsigned int length, unsigned char *scratch) {
+    unsigned int first;
+
+    if (from + length <= s[0].count) {
+        return (unsigned char*)s[0].data + from;
+    }
+    if (from >= s[0].count) {
+        return (unsigned char*)s[1].data + (from - s[0].count);
+    }
+    first = s[0].count - from;
+    memcpy(scratch, (unsigned char*)s[0].data + from, first);
+    memcpy(scratch + first, s[1].data, length - first);
+    return scratch;
+}
+
+// Decode COBS in place; returns the decoded length, or -1 if it is invalid
+// -Each code byte c is followed by c - 1 data bytes, then an implied zero
+//  unless c is 0xFF or it is the last block
+long unstuffCobsFrame(unsigned char *frame, unsigned int length) {
+    unsigned int in = 0, out = 0, code;
+
+    while (in < length) {
+        code = frame[in++];
+        if (code - 1 > length - in) {
+            return -1;
+        }
+        memmove(frame + out, frame + in, code - 1);
+        in += code - 1;
+        out += code - 1;
+        if ( (code < 0xFF) && (in < length) ) {
+            frame[out++] = 0;
+        }
+    }
+    return out;
+}
+
+// Decode SLIP escapes in place; returns the decoded length, or -1 if an
+// escape is invalid
+long unescapeSlipFrame(unsigned char *frame, unsigned int length) {
+    unsigned int in, out = 0;
+
+    for (in = 0; in < length; in++) {
+        if (frame[in] == B_SLIP_ESC) {
+            if (++in == length) {
+                return -1;
+            }
+            if (frame[in] == B_SLIP_ESC_END) {
+                frame[out++] = B_SLIP_END;
+            }
+            else if (frame[in] == B_SLIP_ESC_ESC) {
+                frame[out++] = B_SLIP_ESC;
+            }
+            else {
+                return -1;
+            }
+        }
+        else {
+            frame[out++] = frame[in];
+        }
+    }
+    return out;
+}
+
+// Find next frame
+unsigned char decodeFrame(framedecoder_t *d, buffer_t *b, unsigned char *scratch, frame_t *f) {
+    buffersegment_t s[2];
+    unsigned int count, length, end, i;
+    unsigned char delimiter;
+    long decoded;
+
+    f->data = NULL;
+    f->length = 0;
+    f->consumed = 0;
+    f->status = B_FRAME_INCOMPLETE;
+
+    // Length prefix, then payload
+    if ( (d->format == B_FRAME_LENGTH_BE) || (d->format == B_FRAME_LENGTH_LE) ) {
+        count = peekBuffer(b, s);
+        if (count < d->option) {
+            return B_FRAME_INCOMPLETE;
+        }
+        length = 0;
+        for (i = 0; i < d->option; i++) {
+            if (d->format == B_FRAME_LENGTH_BE) {
+                length = (length << 8) | frameByte(s, i);
+            }
+            else {
+                length |= (unsigned int)frameByte(s, i) << (8 * i);
+            }
+        }
+        if (length > d->maxLength - d->option) {
+            f->consumed = d->option;
+            f->status = B_FRAME_BAD;
+            return B_FRAME_BAD;
+        }
+        if (count - d->option < length) {
+            return B_FRAME_INCOMPLETE;
+        }
+        f->data = joinFrameBytes(s, d->option, length, scratch);
+        f->length = length;
+        f->consumed = d->option + length;
+        f->status = B_FRAME_READY;
+        return B_FRAME_READY;
+    }
+
+    // Payload, then delimiter
+    delimiter = (d->format == B_FRAME_COBS) ? 0 : (d->format == B_FRAME_SLIP) ? B_SLIP_END : d->option;
+    for (;;) {
+        count = peekBuffer(b, s);
+        if (d->scanned > count) {
+            d->scanned = 0;
+        }
+        end = findFrameDelimiter(s, d->scanned, count, delimiter);
+
+        // No delimiter yet: remember how far we looked, and drop the rest of
+        // a frame that is already known to be too long
+        if (end == count) {
+            d->scanned = count;
+            if (d->skipping) {
+                discardFromBuffer(b, count);
+                d->scanned = 0;
+            }
+            else if (count > d->maxLength) {
+                d->skipping = 1;
+                d->scanned = 0;
+                f->consumed = count;
+                f->status = B_FRAME_BAD;
+                return B_FRAME_BAD;
+            }
+            return B_FRAME_INCOMPLETE;
+        }
+        d->scanned = 0;
+
+        // End of a frame that was too long, or an empty COBS/SLIP frame
+        if ( d->skipping || ((end == 0) && (d->format != B_FRAME_DELIMITED)) ) {
+            d->skipping = 0;
+            discardFromBuffer(b, end + 1);
+            continue;
+        }
+        break;
+    }
+
+    f->consumed = end + 1;
+    f->status = B_FRAME_BAD;
+    if (end > d->maxLength) {
+        return B_FRAME_BAD;
+    }
+    f->data = joinFrameBytes(s, 0, end, scratch);
+    if (d->format == B_FRAME_COBS) {
+        decoded = unstuffCobsFrame(f->data, end);
+    }
+    else if (d->format == B_FRAME_SLIP) {
+        decoded = unescapeSlipFrame(f->data, end);
+    }
+    else {
+        decoded = end;
+    }
+    if (decoded < 0) {
+        f->data = NULL;
+        return B_FRAME_BAD;
+    }
+    f->length = decoded;
+    f->status = B_FRAME_READY;
+    return B_FRAME_READY;
+}
+
+// Remove frame
+void consumeFrame(buffer_t *b, frame_t *f) {
+    discardFromBuffer(b, f->consumed);
+    f->data = NULL;
+    f->length = 0;
+    f->consumed = 0;
+    f->status = B_FRAME_INCOMPLETE;
+}
+
+// Longest encoding
+unsigned long maxEncodedFrameLength(unsigned char format, unsigned char option, unsigned int length) {
+    switch (format) {
+        case B_FRAME_LENGTH_BE:
+        case B_FRAME_LENGTH_LE:
+            return (unsigned long)option + length;
+        case B_FRAME_COBS:
+            return (unsigned long)length + length / 254 + 2;
+        case B_FRAME_SLIP:
+            return 2UL * length + 1;
+        default:
+            return (unsigned long)length + 1;
+    }
+}
+
+// Copy bytes to the cursor, crossing into the second segment if need be
+void putFrameBytes(framecursor_t *c, const unsigned char *bytes, unsigned int length) {
+    unsigned int first;
+
+    while (length > 0) {
+        if (c->offset == c->s[c->segment].count) {
+            c->segment++;
+            c->offset = 0;
+        }
+        first = c->s[c->segment].count - c->offset;
+        if (first > length) {
+            first = length;
+        }
+        memcpy((unsigned char*)c->s[c->segment].data + c->offset, bytes, first);
+        c->offset += first;
+        c->written += first;
+        bytes += first;
+        length -= first;
+    }
+}
+
+// Write one byte at the cursor; returns where it went
+unsigned char* putFrameByte(framecursor_t *c, unsigned char byte) {
+    unsigned char *at;
+
+    if (c->offset == c->s[c->segment].count) {
+        c->segment++;
+        c->offset = 0;
+    }
+    at = (unsigned char*)c->s[c->segment].data + c->offset++;
+    *at = byte;
+    c->written++;
+    return at;
+}
+
+// Write frame
+unsigned char encodeFrame(buffer_t *b, unsigned char format, unsigned char option, const void *payload, unsigned int length) {
+    const unsigned char *in = payload, *zero;
+    unsigned char *out;
+    framecursor_t c;
+    unsigned int i, run;
+
+    // Refuse what can't be framed, then make sure the longest encoding fits
+    if ( ((format == B_FRAME_LENGTH_BE) || (format == B_FRAME_LENGTH_LE)) &&
+         ((option == 0) || (option > 4) || ((option < 4) && (length >> (8 * option)))) ) {
+        return 2;
+    }
+    if ( (format == B_FRAME_DELIMITED) && memchr(in, option, length) ) {
+        return 2;
+    }
+    if (reserveInBuffer(b, c.s) < maxEncodedFrameLength(format, option, length)) {
+        return 1;
+    }
+    c.segment = 0;
+    c.offset = 0;
+    c.written = 0;
+
+    switch (format) {
+
+        // Prefix, then the payload as it is
+        case B_FRAME_LENGTH_BE:
+        case B_FRAME_LENGTH_LE:
+            for (i = 0; i < option; i++) {
+                putFrameByte(&c, length >> (8 * ((format == B_FRAME_LENGTH_BE) ? option - 1 - i : i)));
+            }
+            putFrameBytes(&c, in, length);
+            break;
+
+        // Each run of non-zero bytes, in blocks of up to 254, after a code
+        // byte of its length + 1. Every zero is dropped, and implied by a
+        // block shorter than 254
+        case B_FRAME_COBS:
+            for (i = 0; ; i++) {
+                zero = memchr(in + i, 0, length - i);
+                run = zero ? (unsigned int)(zero - (in + i)) : length - i;
+                for ( ; run >= 254; run -= 254, i += 254) {
+                    putFrameByte(&c, 0xFF);
+                    putFrameBytes(&c, in + i, 254);
+                }
+                putFrameByte(&c, run + 1);
+                putFrameBytes(&c, in + i, run);
+                i += run;
+                if ( !(zero) ) {
+                    break;
+                }
+            }
+            putFrameByte(&c, 0);
+            break;
+
+        // Runs without END or ESC as they are, those two escaped
+        // -Escapes are frequent in binary data, so when the frame can't wrap
+        //  it is written byte by byte without the cursor
+        case B_FRAME_SLIP:
+            if (c.s[0].count >= maxEncodedFrameLength(format, option, length)) {
+                out = c.s[0].data;
+                for (i = 0; i < length; i++) {
+                    if ( (in[i] == B_SLIP_END) || (in[i] == B_SLIP_ESC) ) {
+                        *out++ = B_SLIP_ESC;
+                        *out++ = (in[i] == B_SLIP_END) ? B_SLIP_ESC_END : B_SLIP_ESC_ESC;
+                    }
+                    else {
+                        *out++ = in[i];
+                    }
+                }
+                *out++ = B_SLIP_END;
+                c.written = out - (unsigned char*)c.s[0].data;
+                break;
+            }
+            for (i = 0; i < length; i += run + 1) {
+                for (run = 0; (i + run < length) && (in[i + run] != B_SLIP_END) && (in[i + run] != B_SLIP_ESC); run++);
+                putFrameBytes(&c, in + i, run);
+                if (i + run < length) {
+                    putFrameByte(&c, B_SLIP_ESC);
+                    putFrameByte(&c, (in[i + run] == B_SLIP_END) ? B_SLIP_ESC_END : B_SLIP_ESC_ESC);
+                }
+            }
+            putFrameByte(&c, B_SLIP_END);
+            break;
+
+        // Payload, then delimiter
+        default:
+            putFrameBytes(&c, in, length);
+            putFrameByte(&c, option);
+            break;
+    }
+
+    commitToBuffer(b, c.written);
+    return 0;
+}
+
+#endif
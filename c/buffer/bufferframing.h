@@ -0,0 +1,181 @@
+//==============================================================================
+//                               bufferframing.h
+//------------------------------------------------------------------------------
+// Brief
+//   Finds whole messages in a byte stream held in a buffer_t and hands them
+//   out in place, and writes framed messages straight into a buffer_t
+//
+// Contents
+//   - initFrameDecoder
+//   - decodeFrame
+//   - consumeFrame
+//   - maxEncodedFrameLength
+//   - encodeFrame
+//
+// Description
+//   Serial ports and TCP sockets deliver bytes, not messages. Feed them into
+//   a buffer of 1-byte elements as they arrive, then take out one frame at a
+//   time. The decoder scans the bytes where they lie with peekBuffer() and,
+//   when a frame doesn't wrap round the end of the storage, points straight
+//   at it, so nothing is copied and the tail moves once per frame instead of
+//   once per byte. Supported formats:
+//   -B_FRAME_LENGTH_BE, B_FRAME_LENGTH_LE: a 1 to 4-byte unsigned length
+//    (big or little-endian), then that many payload bytes
+//   -B_FRAME_COBS: Consistent Overhead Byte Stuffing, each frame followed by
+//    a 0x00 byte
+//   -B_FRAME_SLIP: RFC 1055 SLIP, frames separated by 0xC0 bytes
+//   -B_FRAME_DELIMITED: payload followed by a delimiter byte, e.g. '\n' for
+//    lines of text
+//   Declaration
+//      buffer_t *rx;
+//      framedecoder_t decoder;
+//      unsigned char scratch[512];
+//      frame_t frame;
+//      rx = newBuffer(4096, 1, B_FIFO & B_DROP);
+//      initFrameDecoder(&decoder, B_FRAME_LENGTH_BE, 2, sizeof(scratch));
+//   Receiving
+//      pushToBuffer(rx, bytes, received);
+//      while (decodeFrame(&decoder, rx, scratch, &frame) != B_FRAME_INCOMPLETE) {
+//          if (frame.status == B_FRAME_READY) {
+//              handleMessage(frame.data, frame.length);
+//          }
+//          consumeFrame(rx, &frame);
+//      }
+//   Sending
+//      The encoder reserves room for the longest encoding of the payload with
+//      reserveInBuffer(), writes the frame there (in two pieces if it wraps)
+//      and commits only the bytes it wrote, so no temporary array is needed:
+//      if ( encodeFrame(tx, B_FRAME_COBS, 0, message, length) ) {
+//          // tx is full: flush it and try again
+//      }
+//
+// Warnings
+//  -The buffer must be a FIFO with 1-byte elements, for decoding and encoding
+//  -frame.data points into the buffer or into scratch, so it is only valid
+//   until consumeFrame() or the next push
+//  -COBS and SLIP frames are decoded where they lie, so their bytes in the
+//   buffer are overwritten. Don't peek at them after decodeFrame()
+//  -Frames bigger than maxLength on the wire are reported as B_FRAME_BAD.
+//   Delimited formats (COBS, SLIP, delimiter) skip to the next delimiter and
+//   carry on. A length prefix gives no way to find the next frame, so after a
+//   bad length prefix the stream should be dropped
+//  -A buffer whose capacity is smaller than maxLength can never hold the
+//   biggest frames
+//
+// Author
+//   Daniel Wilkinson-Thompson (daniel@wilkinson-thompson.com)
+//
+// Date
+//   2026-10-18
+//
+// Licence
+//   Copyright (c) 2026 Daniel Wilkinson-Thompson. All rights reserved.
+//------------------------------------------------------------------------------
+
+#ifndef BUFFERFRAMING_H
+#define BUFFERFRAMING_H
+
+//------------------------------------------------------------------------------
+// Headers
+//------------------------------------------------------------------------------
+#include "buffer.h"
+
+//------------------------------------------------------------------------------
+// Constants
+//------------------------------------------------------------------------------
+// Frame formats
+#define B_FRAME_LENGTH_BE   0
+#define B_FRAME_LENGTH_LE   1
+#define B_FRAME_COBS        2
+#define B_FRAME_SLIP        3
+#define B_FRAME_DELIMITED   4
+
+// decodeFrame() results
+// -B_FRAME_INCOMPLETE: no whole frame has arrived yet
+// -B_FRAME_READY: frame.data and frame.length hold the next payload
+// -B_FRAME_BAD: the next frame.consumed bytes are not a valid frame
+#define B_FRAME_INCOMPLETE  0
+#define B_FRAME_READY       1
+#define B_FRAME_BAD         2
+
+// SLIP special bytes
+#define B_SLIP_END          0xC0
+#define B_SLIP_ESC          0xDB
+#define B_SLIP_ESC_END      0xDC
+#define B_SLIP_ESC_ESC      0xDD
+
+
+//------------------------------------------------------------------------------
+// Type definitions
+//------------------------------------------------------------------------------
+// -option is the number of length bytes for B_FRAME_LENGTH_BE/LE and the
+//  delimiter byte for B_FRAME_DELIMITED
+// -scanned is how many bytes of the next frame have already been searched
+//  for its delimiter, so bytes are only searched once however they trickle in
+// -skipping is set while the rest of a frame that was too long is dropped
+typedef struct B_FRAME_DECODER {
+    unsigned char format;
+    unsigned char option;
+    unsigned char skipping;
+    unsigned int maxLength;
+    unsigned int scanned;
+} framedecoder_t;
+
+// -data and length are the payload, with the length prefix, stuffing,
+//  escapes and delimiter taken out
+// -consumed is the number of bytes the frame takes up in the buffer
+typedef struct B_FRAME {
+    unsigned char *data;
+    unsigned int length;
+    unsigned int consumed;
+    unsigned char status;
+} frame_t;
+
+
+//------------------------------------------------------------------------------
+// Function prototypes
+//------------------------------------------------------------------------------
+
+// ------------------------ Initialize a frame decoder ------------------------
+// -format is one of the B_FRAME_* formats above
+// -option is the number of length bytes (1 to 4) for length prefixes, the
+//  delimiter byte for B_FRAME_DELIMITED, and ignored otherwise
+// -maxLength is the most bytes a frame may take up in the buffer, not
+//  counting its delimiter. The scratch passed to decodeFrame() must hold at
+//  least this many bytes
+// -A return value of 1 implies the format or option was not valid
+unsigned char initFrameDecoder(framedecoder_t *d, unsigned char format, unsigned char option, unsigned int maxLength);
+
+// --------------------- Find the next frame in a buffer ----------------------
+// -Looks for a whole frame at the tail of b without removing anything, and
+//  returns B_FRAME_INCOMPLETE, B_FRAME_READY or B_FRAME_BAD (see above)
+// -A frame lying in one piece is handed out in place. Only a frame that
+//  wraps round the end of the buffer's storage is copied, to scratch
+// -After B_FRAME_READY or B_FRAME_BAD, call consumeFrame() before the next
+//  decodeFrame()
+// -Empty COBS and SLIP frames (back-to-back delimiters) are skipped
+unsigned char decodeFrame(framedecoder_t *d, buffer_t *b, unsigned char *scratch, frame_t *f);
+
+// ------------------ Remove a frame from the front of a buffer ---------------
+// -Discards the f->consumed bytes of the frame decodeFrame() last found
+void consumeFrame(buffer_t *b, frame_t *f);
+
+// ------------------- Longest encoding of a payload ---------------------------
+// -Bytes encodeFrame() needs free in the buffer for a payload of length bytes
+//  in the given format, delimiter included: option + length for length
+//  prefixes, length + length / 254 + 2 for COBS, 2 * length + 1 for SLIP and
+//  length + 1 for B_FRAME_DELIMITED
+unsigned long maxEncodedFrameLength(unsigned char format, unsigned char option, unsigned int length);
+
+// ------------------------ Write a frame to a buffer -------------------------
+// -Encodes length bytes of payload in the given format (option as for
+//  initFrameDecoder()) directly into the free space of b, which must have at
+//  least maxEncodedFrameLength() bytes free, and adds the encoded bytes to b
+// -A return value of zero implies the frame was written
+// -A return value of 1 implies b didn't have room, and nothing was written
+// -A return value of 2 implies the payload can't be framed: its length
+//  doesn't fit the length prefix, or it contains the delimiter of a
+//  B_FRAME_DELIMITED format
+unsigned char encodeFrame(buffer_t *b, unsigned char format, unsigned char option, const void *payload, unsigned int length);
+
+#endif
@@ -0,0 +1,313 @@
+//==============================================================================
+//                                 bufferio.c
+//------------------------------------------------------------------------------
+// Brief
+//   Moves bytes between buffer_t rings and file descriptors without copying
+//   them through temporary arrays
+//
+// Contents
+//   - newPageBuffer
+//   - freePageBuffer
+//   - readToBuffer
+//   - preadToBuffer
+//   - writeFromBuffer
+//   - giftToPipe
+//   - spliceThroughPipe
+//   - segmentsToIovecs (private)
+//   - releaseGiftedPages (private)
+//   - copyGiftedPage (private)
+//
+// Description
+//   A page buffer's storage is a whole number of pages, so its wrap point is
+//   a page boundary and every page gifted starts where the tail is. Once a
+//   page has left the buffer entirely, madvise(MADV_DONTNEED) replaces it.
+//   If vmsplice() ever stops part way through a page, the part it did not
+//   take stays in the buffer, and the page is swapped for a private copy
+//   with mremap(), so the buffer never writes to a page the pipe holds. The
+//   rest of the page goes with write() on a later call, once it is full or
+//   flushed, as after any flush. Nothing ever waits for room in the pipe
+//   beyond what the pipe's own blocking mode does.
+//
+// Author
+//   Daniel Wilkinson-Thompson (daniel@wilkinson-thompson.com)
+//
+// Date
+//   2026-10-18
+//
+// Licence
+//   Copyright (c) 2026 Daniel Wilkinson-Thompson. All rights reserved.
+//------------------------------------------------------------------------------
+
+#ifndef BUFFERIO_C
+#define BUFFERIO_C
+
+//------------------------------------------------------------------------------
+// Headers
+//------------------------------------------------------------------------------
+#define _GNU_SOURCE
+#include "bufferio.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <stdlib.h>
+#include <sys/ioctl.h>
+#include <sys/mman.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+//------------------------------------------------------------------------------
+// Private function prototypes
+//------------------------------------------------------------------------------
+int segmentsToIovecs(buffersegment_t s[2], struct iovec io[2]);
+void releaseGiftedPages(buffer_t *b, unsigned long length);
+unsigned char copyGiftedPage(buffer_t *b, unsigned long page);
+
+//------------------------------------------------------------------------------
+// Functions
+//------------------------------------------------------------------------------
+// Generate page buffer
+buffer_t* newPageBuffer(unsigned int pages) {
+    unsigned long bytes = (unsigned long)pages * sysconf(_SC_PAGESIZE);
+    buffer_t *b;
+
+    if ( (pages == 0) || (bytes > 0xFFFFFFFFUL) ) {
+        return NULL;
+    }
+
+    // Only B_SEPARATE_LINES needs more than malloc's alignment
+#ifdef B_SEPARATE_LINES
+    if ( posix_memalign((void**)&b, __alignof__(buffer_t), sizeof(buffer_t)) ) {
+        return NULL;
+    }
+#else
+    b = malloc(sizeof(buffer_t));
+    if ( !(b) ) {
+        return NULL;
+    }
+#endif
+    b->data = mmap(NULL, bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (b->data == MAP_FAILED) {
+        free(b);
+        return NULL;
+    }
+
+    // Storage isn't from malloc, so bufferMemoryUsage() adds no allocator
+    // overhead for it
+    initBuffer(b, b->data, bytes - 1, 1, B_FIFO & B_DROP);
+    return b;
+}
+
+// Free page buffer
+void freePageBuffer(buffer_t *b) {
+    munmap(b->data, b->depth);
+    b->data = NULL;
+    free(b);
+}
+
+// Segments as iovecs; returns how many of them are in use
+int segmentsToIovecs(buffersegment_t s[2], struct iovec io[2]) {
+    io[0].iov_base = s[0].data;
+    io[0].iov_len = s[0].count;
+    io[1].iov_base = s[1].data;
+    io[1].iov_len = s[1].count;
+    return s[1].count ? 2 : 1;
+}
+
+// Read into free space
+long readToBuffer(buffer_t *b, int fd) {
+    buffersegment_t s[2];
+    struct iovec io[2];
+    long n;
+
+    if ( !(reserveInBuffer(b, s)) ) {
+        errno = ENOBUFS;
+        return -1;
+    }
+    n = readv(fd, io, segmentsToIovecs(s, io));
+    if (n > 0) {
+        commitToBuffer(b, n);
+    }
+    return n;
+}
+
+// Read into free space from an offset
+long preadToBuffer(buffer_t *b, int fd, unsigned long long offset) {
+    buffersegment_t s[2];
+    struct iovec io[2];
+    long n;
+
+    if ( !(reserveInBuffer(b, s)) ) {
+        errno = ENOBUFS;
+        return -1;
+    }
+    n = preadv(fd, io, segmentsToIovecs(s, io), offset);
+    if (n > 0) {
+        commitToBuffer(b, n);
+    }
+    return n;
+}
+
+// Write out contents
+long writeFromBuffer(buffer_t *b, int fd) {
+    buffersegment_t s[2];
+    struct iovec io[2];
+    long n;
+
+    if ( !(peekBuffer(b, s)) ) {
+        return 0;
+    }
+    n = writev(fd, io, segmentsToIovecs(s, io));
+    if (n > 0) {
+        discardFromBuffer(b, n);
+    }
+    return n;
+}
+
+// Drop length bytes of gifted pages from the tail, replacing the pages
+// -The pages start at the tail, and may wrap round the end of the storage
+void releaseGiftedPages(buffer_t *b, unsigned long length) {
+    unsigned char *data = b->data;
+    unsigned long first;
+
+    first = b->depth - b->tail;
+    if (first > length) {
+        first = length;
+    }
+    madvise(data + b->tail, first, MADV_DONTNEED);
+    if (length > first) {
+        madvise(data, length - first, MADV_DONTNEED);
+    }
+    discardFromBuffer(b, length);
+}
+
+// Swap the page at the tail for a copy of itself
+// -The pipe keeps the old page, and the buffer goes on with the copy, so
+//  later writes to the page can't change bytes already gifted
+// -Returns 0 on success, or 1 if no page could be mapped
+unsigned char copyGiftedPage(buffer_t *b, unsigned long page) {
+    unsigned char *at = (unsigned char*)b->data + b->tail;
+    void *copy;
+
+    copy = mmap(NULL, page, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (copy == MAP_FAILED) {
+        return 1;
+    }
+    memcpy(copy, at, page);
+    if (mremap(copy, page, page, MREMAP_MAYMOVE | MREMAP_FIXED, at) == MAP_FAILED) {
+        munmap(copy, page);
+        return 1;
+    }
+    return 0;
+}
+
+// Gift whole pages to a pipe
+long giftToPipe(buffer_t *b, int pipe, unsigned char flush) {
+    unsigned long page = sysconf(_SC_PAGESIZE), moved = 0, lead, rest;
+    buffersegment_t s[2];
+    struct iovec io[2];
+    unsigned int count;
+    int flags;
+    long n;
+
+    // An earlier flush left the tail inside a page: copy up to the end of
+    // it, once the page is full
+    count = peekBuffer(b, s);
+    lead = (page - b->tail % page) % page;
+    if (lead) {
+        if ( (count < lead) && !(flush) ) {
+            return 0;
+        }
+        n = write(pipe, s[0].data, (count < lead) ? count : lead);
+        if (n <= 0) {
+            return n;
+        }
+        discardFromBuffer(b, n);
+        moved = n;
+        if ( (unsigned long)n < lead ) {
+            return moved;
+        }
+        count = peekBuffer(b, s);
+    }
+
+    // Gift the whole pages; the first segment can only end inside a page if
+    // it is the only one
+    // -vmsplice() ignores O_NONBLOCK on the pipe, so it is passed on as
+    //  SPLICE_F_NONBLOCK
+    s[0].count -= s[0].count % page;
+    s[1].count -= s[1].count % page;
+    if (s[0].count) {
+        flags = fcntl(pipe, F_GETFL);
+        flags = SPLICE_F_GIFT | ( ((flags >= 0) && (flags & O_NONBLOCK)) ? SPLICE_F_NONBLOCK : 0 );
+        n = vmsplice(pipe, io, segmentsToIovecs(s, io), flags);
+        if (n < 0) {
+            return moved ? (long)moved : -1;
+        }
+
+        // Pages the pipe took whole leave the buffer. If it stopped part way
+        // through a page, the rest of that page stays for a later write(),
+        // and the buffer goes on with a copy of the page rather than the one
+        // the pipe holds. Should even one page be more than memory allows,
+        // the buffer keeps the shared page: nothing is lost, but bytes
+        // pushed there before the reader drains the pipe would show through
+        rest = n % page;
+        releaseGiftedPages(b, n - rest);
+        if (rest) {
+            copyGiftedPage(b, page);
+            discardFromBuffer(b, rest);
+        }
+        moved += n;
+        count -= n;
+        if ( (unsigned long)n < s[0].count + s[1].count ) {
+            return moved;
+        }
+    }
+
+    // Last, partly filled page, unless the pipe filled up before it
+    if ( flush && (count > 0) && (count < page) ) {
+        peekBuffer(b, s);
+        n = write(pipe, s[0].data, count);
+        if (n < 0) {
+            return moved ? (long)moved : -1;
+        }
+        discardFromBuffer(b, n);
+        moved += n;
+    }
+    return moved;
+}
+
+// Splice between descriptors
+long spliceThroughPipe(int in, long long *offset, int p[2], int out, unsigned long length) {
+    unsigned long moved = 0;
+    int pending = 0;
+    long n = 0;
+
+    if ( p && ioctl(p[0], FIONREAD, &pending) ) {
+        pending = 0;
+    }
+    while (moved < length) {
+
+        // Fill the pipe, unless it still holds bytes from before
+        if ( p && (pending == 0) ) {
+            n = splice(in, (loff_t*)offset, p[1], NULL, length - moved, SPLICE_F_MOVE | SPLICE_F_MORE);
+            if (n <= 0) {
+                break;
+            }
+            pending = n;
+        }
+
+        // Empty it into out
+        n = splice(p ? p[0] : in, p ? NULL : (loff_t*)offset, out, NULL,
+                   p ? ( ((unsigned long)pending < length - moved) ? (unsigned long)pending : length - moved ) : length - moved,
+                   SPLICE_F_MOVE | SPLICE_F_MORE);
+        if (n <= 0) {
+            break;
+        }
+        if (p) {
+            pending -= n;
+        }
+        moved += n;
+    }
+    return ( (moved == 0) && (n < 0) ) ? -1 : (long)moved;
+}
+
+#endif
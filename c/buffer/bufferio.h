@@ -0,0 +1,130 @@
+//==============================================================================
+//                                 bufferio.h
+//------------------------------------------------------------------------------
+// Brief
+//   Moves bytes between buffer_t rings and file descriptors without copying
+//   them through temporary arrays
+//
+// Contents
+//   - newPageBuffer
+//   - freePageBuffer
+//   - readToBuffer
+//   - preadToBuffer
+//   - writeFromBuffer
+//   - giftToPipe
+//   - spliceThroughPipe
+//
+// Description
+//   readToBuffer() and writeFromBuffer() read straight into the free space of
+//   a buffer of bytes and write straight from its contents, using readv() and
+//   writev() on the (at most) two segments either side of the wrap.
+//   For forwarding through pipes, Linux can also avoid the copy into or out
+//   of the kernel altogether:
+//   -giftToPipe() hands whole pages of a page buffer to a pipe with
+//    vmsplice(SPLICE_F_GIFT). The pipe keeps the pages themselves, so the
+//    buffer gives them up with madvise(MADV_DONTNEED) and gets fresh, zeroed
+//    pages in their place the next time it writes there. The bytes already
+//    in the pipe can never change under the reader
+//   -spliceThroughPipe() moves bytes from a file or socket to another one
+//    through a pipe with splice(), never touching user space
+//   Forwarding a buffer to a socket
+//      buffer_t *b;
+//      int p[2];
+//      b = newPageBuffer(256);
+//      pipe(p);
+//      ...fill b with readToBuffer() or pushToBuffer()...
+//      giftToPipe(b, p[1], 0);
+//      spliceThroughPipe(p[0], NULL, NULL, socket, 1 << 20);
+//   Forwarding a file to a socket
+//      spliceThroughPipe(file, &offset, p, socket, length);
+//
+// Warnings
+//  -All functions take FIFO buffers with 1-byte elements
+//  -giftToPipe() only takes page buffers, since vmsplice() can only gift
+//   whole, page-aligned pages. Never call freeBuffer() on a page buffer
+//  -Reading gifted pages back (pages behind the tail) gives zeroes, not the
+//   bytes that were sent
+//  -Each gifted page comes back as a page fault and a zeroed page when the
+//   buffer next writes there. That can cost more than the copy write() makes
+//   (see bench/splice.c), so measure before choosing giftToPipe() over
+//   writeFromBuffer(). spliceThroughPipe() has no such cost
+//  -giftToPipe(), spliceThroughPipe(), F_SETPIPE_SZ and friends are
+//   Linux-only
+//
+// Author
+//   Daniel Wilkinson-Thompson (daniel@wilkinson-thompson.com)
+//
+// Date
+//   2026-10-18
+//
+// Licence
+//   Copyright (c) 2026 Daniel Wilkinson-Thompson. All rights reserved.
+//------------------------------------------------------------------------------
+
+#ifndef BUFFERIO_H
+#define BUFFERIO_H
+
+//------------------------------------------------------------------------------
+// Headers
+//------------------------------------------------------------------------------
+#include "buffer.h"
+
+//------------------------------------------------------------------------------
+// Function prototypes
+//------------------------------------------------------------------------------
+
+// ------------------------ Generate a new page buffer ------------------------
+// -Creates a FIFO buffer of bytes whose storage is pages whole pages, mapped
+//  on their own and page-aligned, so every page of it can be gifted
+// -The buffer holds pages * page size - 1 bytes, and is used with the usual
+//  functions
+// -A NULL return implies there was not enough memory
+buffer_t* newPageBuffer(unsigned int pages);
+
+// --------------------------- Free a page buffer -----------------------------
+void freePageBuffer(buffer_t *b);
+
+// ---------------------- Read from a descriptor into a buffer ----------------
+// -One readv() into all the free space of b
+// -The return value is what readv() returned: the number of bytes added, 0 at
+//  end of file, or -1 with errno set. If b is full, nothing is read and the
+//  return value is -1 with errno set to ENOBUFS
+long readToBuffer(buffer_t *b, int fd);
+
+// -------------------- Read from a file offset into a buffer -----------------
+// -As readToBuffer(), with one preadv() at offset, leaving the file position
+//  of fd alone
+long preadToBuffer(buffer_t *b, int fd, unsigned long long offset);
+
+// ---------------------- Write from a buffer to a descriptor -----------------
+// -One writev() of everything in b; whatever was written is removed from b
+// -The return value is what writev() returned: the number of bytes removed,
+//  or -1 with errno set. An empty b writes nothing and returns 0
+long writeFromBuffer(buffer_t *b, int fd);
+
+// --------------------- Hand the pages of a buffer to a pipe -----------------
+// -Gifts every whole page at the tail of b to the pipe with vmsplice() and
+//  drops them from b. A partly filled last page stays in b until it is full,
+//  unless flush is set, in which case its bytes are copied with write()
+// -Blocks while the pipe is full, unless pipe is non-blocking. A non-blocking
+//  pipe takes what fits and giftToPipe() returns at once, with a short count,
+//  or -1 and errno EAGAIN if nothing fitted
+// -Bytes that did not reach the pipe, for whatever reason, stay in b
+// -The return value is the number of bytes moved to the pipe, or -1 with
+//  errno set if nothing could be moved
+long giftToPipe(buffer_t *b, int pipe, unsigned char flush);
+
+// ----------------- Move bytes between descriptors through a pipe ------------
+// -Moves up to length bytes from in to out with splice(), through the pipe
+//  p (p[0] is the read end, p[1] the write end) without copying them to user
+//  space. offset is the position to read from in, advanced as bytes are
+//  read, or NULL to read from in's own file position (pipes and sockets)
+// -If in is the read end of a pipe already, pass p as NULL and the bytes are
+//  spliced straight to out
+// -Returns once length bytes have moved, in reaches end of file, or a call
+//  would block. Bytes a call leaves in p are sent first by the next one
+// -The return value is the number of bytes that reached out, or -1 with
+//  errno set if nothing could be moved
+long spliceThroughPipe(int in, long long *offset, int p[2], int out, unsigned long length);
+
+#endif
@@ -0,0 +1,337 @@
+//==============================================================================
+//                                bufferpool.c
+//------------------------------------------------------------------------------
+// Brief
+//   Allocates buffer_t storage from size-classed slabs that can be compacted
+//   and handed back to the operating system
+//
+// Contents
+//   - newBufferPool
+//   - freeBufferPool
+//   - newPooledBuffer
+//   - freePooledBuffer
+//   - compactBufferPool
+//   - bufferPoolMemoryUsage
+//   - poolSizeClass (private)
+//   - newPoolSlab (private)
+//   - takePoolChunk (private)
+//   - movePoolChunk (private)
+//   - compareSlabUse (private)
+//   - compactPoolClass (private)
+//
+// Description
+//   Each size class has a list of slabs and a current slab. New chunks come
+//   from the current slab; once it is full the fullest slab with room takes
+//   over, so buffers pack into few slabs and the rest drain as buffers are
+//   freed. Compaction sorts a class's slabs fullest first, then moves chunks
+//   from the back of that order to the front until the two meet.
+//
+// Author
+//   Daniel Wilkinson-Thompson (daniel@wilkinson-thompson.com)
+//
+// Date
+//   2026-10-18
+//
+// Licence
+//   Copyright (c) 2026 Daniel Wilkinson-Thompson. All rights reserved.
+//------------------------------------------------------------------------------
+
+#ifndef BUFFERPOOL_C
+#define BUFFERPOOL_C
+
+//------------------------------------------------------------------------------
+// Headers
+//------------------------------------------------------------------------------
+#ifndef _DEFAULT_SOURCE
+#define _DEFAULT_SOURCE
+#endif
+#include "bufferpool.h"
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+
+//------------------------------------------------------------------------------
+// Private function prototypes
+//------------------------------------------------------------------------------
+int poolSizeClass(unsigned long bytes);
+bufferslab_t* newPoolSlab(bufferpool_t *p, int sizeClass);
+bufferslab_t* takePoolChunk(bufferpool_t *p, int sizeClass, unsigned int *chunk);
+void movePoolChunk(bufferslab_t *from, unsigned int chunk, bufferslab_t *to, int sizeClass);
+int compareSlabUse(const void *a, const void *b);
+unsigned long compactPoolClass(bufferpool_t *p, int sizeClass);
+
+//------------------------------------------------------------------------------
+// Functions
+//------------------------------------------------------------------------------
+// Generate pool
+bufferpool_t* newBufferPool(void) {
+    return calloc(1, sizeof(bufferpool_t));
+}
+
+// Free pool
+void freeBufferPool(bufferpool_t *p) {
+    bufferslab_t *slab, *next;
+    unsigned int chunk;
+    int sizeClass;
+
+    for (sizeClass = 0; sizeClass < B_POOL_CLASSES; sizeClass++) {
+        for (slab = p->slabs[sizeClass]; slab; slab = next) {
+            next = slab->next;
+            for (chunk = 0; chunk < slab->chunks; chunk++) {
+                free(slab->owners[chunk]);
+            }
+            munmap(slab->base, B_POOL_SLAB_BYTES);
+            free(slab);
+        }
+    }
+    free(p);
+}
+
+// Smallest size class that holds bytes, or -1 if none does
+int poolSizeClass(unsigned long bytes) {
+    int sizeClass;
+
+    for (sizeClass = 0; sizeClass < B_POOL_CLASSES; sizeClass++) {
+        if (bytes <= ((unsigned long)B_POOL_MIN_BYTES << sizeClass)) {
+            return sizeClass;
+        }
+    }
+    return -1;
+}
+
+// Map a new slab and add it to its class
+bufferslab_t* newPoolSlab(bufferpool_t *p, int sizeClass) {
+    bufferslab_t *slab;
+    unsigned int chunks, chunk;
+
+    // Descriptor, owners and free list in one heap block
+    chunks = B_POOL_SLAB_BYTES / (B_POOL_MIN_BYTES << sizeClass);
+    slab = malloc(sizeof(bufferslab_t) + chunks * (sizeof(pooledbuffer_t*) + sizeof(unsigned int)));
+    if ( !(slab) ) {
+        return NULL;
+    }
+    slab->base = mmap(NULL, B_POOL_SLAB_BYTES, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (slab->base == MAP_FAILED) {
+        free(slab);
+        return NULL;
+    }
+    slab->owners = (pooledbuffer_t**)(slab + 1);
+    slab->free = (unsigned int*)(slab->owners + chunks);
+    slab->chunks = chunks;
+    slab->used = 0;
+    slab->released = 0;
+
+    // Lowest chunks are handed out first
+    for (chunk = 0; chunk < chunks; chunk++) {
+        slab->owners[chunk] = NULL;
+        slab->free[chunk] = chunks - 1 - chunk;
+    }
+
+    slab->next = p->slabs[sizeClass];
+    p->slabs[sizeClass] = slab;
+    p->mapped++;
+    return slab;
+}
+
+// Take a free chunk of a class, mapping a new slab if every slab is full
+bufferslab_t* takePoolChunk(bufferpool_t *p, int sizeClass, unsigned int *chunk) {
+    bufferslab_t *slab, *best;
+
+    // Current slab is full: switch to the fullest slab with room, preferring
+    // ones whose pages are still there
+    best = p->current[sizeClass];
+    if ( !(best) || (best->used == best->chunks) ) {
+        best = NULL;
+        for (slab = p->slabs[sizeClass]; slab; slab = slab->next) {
+            if ( (slab->used < slab->chunks) &&
+                 ( !(best) || (best->released > slab->released) ||
+                   ((best->released == slab->released) && (slab->used > best->used)) ) ) {
+                best = slab;
+            }
+        }
+        if ( !(best) ) {
+            best = newPoolSlab(p, sizeClass);
+            if ( !(best) ) {
+                return NULL;
+            }
+        }
+        p->current[sizeClass] = best;
+    }
+
+    // Pages of a released slab come back, zeroed, as they are touched
+    if (best->released) {
+        best->released = 0;
+        p->released--;
+    }
+
+    *chunk = best->free[best->chunks - best->used - 1];
+    best->used++;
+    return best;
+}
+
+// Generate pooled buffer
+buffer_t* newPooledBuffer(bufferpool_t *p, unsigned int numberOfElements, unsigned char elementSizeInBytes, unsigned char config) {
+    pooledbuffer_t *pb;
+    unsigned long bytes;
+    int sizeClass;
+
+    // Same storage as newBuffer(): one spare element
+    bytes = ((unsigned long)numberOfElements + 1) * elementSizeInBytes;
+    sizeClass = poolSizeClass(bytes);
+    if (sizeClass < 0) {
+        return NULL;
+    }
+
+    // Only B_SEPARATE_LINES needs more than malloc's alignment
+#ifdef B_SEPARATE_LINES
+    if ( posix_memalign((void**)&pb, __alignof__(pooledbuffer_t), sizeof(pooledbuffer_t)) ) {
+        return NULL;
+    }
+#else
+    pb = malloc(sizeof(pooledbuffer_t));
+    if ( !(pb) ) {
+        return NULL;
+    }
+#endif
+    pb->slab = takePoolChunk(p, sizeClass, &(pb->chunk));
+    if ( !(pb->slab) ) {
+        free(pb);
+        return NULL;
+    }
+    pb->slab->owners[pb->chunk] = pb;
+
+    // Initialize buffer, as newBuffer() would
+    initBuffer(&(pb->buffer), pb->slab->base + (unsigned long)pb->chunk * (B_POOL_MIN_BYTES << sizeClass),
+               numberOfElements, elementSizeInBytes, config);
+    return &(pb->buffer);
+}
+
+// Free pooled buffer
+void freePooledBuffer(bufferpool_t *p, buffer_t *b) {
+    pooledbuffer_t *pb = (pooledbuffer_t*)b;
+    bufferslab_t *slab = pb->slab;
+
+    // Slabs are only released by compactBufferPool(), so a buffer created and
+    // freed over and over doesn't keep faulting pages in and out
+    slab->owners[pb->chunk] = NULL;
+    slab->used--;
+    slab->free[slab->chunks - slab->used - 1] = pb->chunk;
+    (void)p;
+
+    b->data = NULL;
+    free(pb);
+}
+
+// Move the storage of one buffer to a free chunk of another slab
+void movePoolChunk(bufferslab_t *from, unsigned int chunk, bufferslab_t *to, int sizeClass) {
+    pooledbuffer_t *pb = from->owners[chunk];
+    unsigned int target;
+
+    target = to->free[to->chunks - to->used - 1];
+    to->used++;
+    to->owners[target] = pb;
+
+    pb->buffer.data = to->base + (unsigned long)target * (B_POOL_MIN_BYTES << sizeClass);
+    memcpy(pb->buffer.data, from->base + (unsigned long)chunk * (B_POOL_MIN_BYTES << sizeClass),
+           (unsigned long)pb->buffer.depth * pb->buffer.width);
+    pb->slab = to;
+    pb->chunk = target;
+
+    from->owners[chunk] = NULL;
+    from->used--;
+    from->free[from->chunks - from->used - 1] = chunk;
+}
+
+// qsort() order: fullest slab first
+int compareSlabUse(const void *a, const void *b) {
+    const bufferslab_t *x = *(bufferslab_t* const*)a, *y = *(bufferslab_t* const*)b;
+    return (x->used < y->used) - (x->used > y->used);
+}
+
+// Compact one size class
+unsigned long compactPoolClass(bufferpool_t *p, int sizeClass) {
+    bufferslab_t *slab, **order;
+    unsigned long count = 0, released = 0;
+    unsigned int first, last, chunk = 0;
+
+    for (slab = p->slabs[sizeClass]; slab; slab = slab->next) {
+        count++;
+    }
+    if (count == 0) {
+        return 0;
+    }
+
+    // Without memory to sort, just release what is already empty
+    order = malloc(count * sizeof(bufferslab_t*));
+    if (order) {
+        count = 0;
+        for (slab = p->slabs[sizeClass]; slab; slab = slab->next) {
+            order[count++] = slab;
+        }
+        qsort(order, count, sizeof(bufferslab_t*), compareSlabUse);
+
+        // Fill the fullest slabs from the emptiest
+        first = 0;
+        last = count - 1;
+        while (first < last) {
+            if (order[first]->used == order[first]->chunks) {
+                first++;
+            }
+            else if (order[last]->used == 0) {
+                last--;
+                chunk = 0;
+            }
+            else {
+                while ( !(order[last]->owners[chunk]) ) {
+                    chunk++;
+                }
+                movePoolChunk(order[last], chunk, order[first], sizeClass);
+            }
+        }
+        free(order);
+    }
+
+    // Give back the pages of empty slabs
+    for (slab = p->slabs[sizeClass]; slab; slab = slab->next) {
+        if ( (slab->used == 0) && !(slab->released) &&
+             !(madvise(slab->base, B_POOL_SLAB_BYTES, MADV_DONTNEED)) ) {
+            slab->released = 1;
+            p->released++;
+            released += B_POOL_SLAB_BYTES;
+        }
+    }
+
+    // Start filling from the fullest slab again
+    p->current[sizeClass] = NULL;
+    return released;
+}
+
+// Compact pool
+unsigned long compactBufferPool(bufferpool_t *p) {
+    unsigned long released = 0;
+    int sizeClass;
+
+    for (sizeClass = 0; sizeClass < B_POOL_CLASSES; sizeClass++) {
+        released += compactPoolClass(p, sizeClass);
+    }
+    return released;
+}
+
+// Memory held by pool
+unsigned long bufferPoolMemoryUsage(bufferpool_t *p) {
+    bufferslab_t *slab;
+    unsigned long bytes = sizeof(bufferpool_t);
+    int sizeClass;
+
+    for (sizeClass = 0; sizeClass < B_POOL_CLASSES; sizeClass++) {
+        for (slab = p->slabs[sizeClass]; slab; slab = slab->next) {
+            bytes += sizeof(bufferslab_t) + slab->chunks * (sizeof(pooledbuffer_t*) + sizeof(unsigned int));
+            if ( !(slab->released) ) {
+                bytes += B_POOL_SLAB_BYTES;
+            }
+        }
+    }
+    return bytes;
+}
+
+#endif
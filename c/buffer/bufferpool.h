@@ -0,0 +1,149 @@
+//==============================================================================
+//                                bufferpool.h
+//------------------------------------------------------------------------------
+// Brief
+//   Allocates buffer_t storage from size-classed slabs that can be compacted
+//   and handed back to the operating system
+//
+// Contents
+//   - newBufferPool
+//   - freeBufferPool
+//   - newPooledBuffer
+//   - freePooledBuffer
+//   - compactBufferPool
+//   - bufferPoolMemoryUsage
+//
+// Description
+//   Long-running programs that create and free many buffers of varied sizes
+//   leave the heap full of holes that malloc can't give back. A pool instead
+//   rounds each buffer's storage up to a power-of-two size class and takes it
+//   from slabs of B_POOL_SLAB_BYTES mapped for that class. Because buffer_t
+//   only refers to its storage through the data pointer, compactBufferPool()
+//   can move the storage of live buffers out of sparse slabs into the gaps of
+//   dense ones, then drop the pages of every slab left empty.
+//   Declaration
+//      bufferpool_t *pool;
+//      buffer_t *b;
+//      pool = newBufferPool();
+//      b = newPooledBuffer(pool, 64, sizeof(int), B_FIFO & B_DROP);
+//   Use b with pushToBuffer(), popFromBuffer() etc. as usual, then
+//      freePooledBuffer(pool, b);
+//   Now and then, e.g. from a housekeeping timer
+//      compactBufferPool(pool);
+//
+// Warnings
+//  -Pools are not thread-safe. Only one thread at a time may create, free or
+//   compact, and compactBufferPool() may only run while no thread is using a
+//   pooled buffer, since it changes their data pointers
+//  -Never call freeBuffer() on a pooled buffer, or bufferMemoryUsage(), which
+//   doesn't know about slabs
+//  -Storage bigger than B_POOL_MAX_BYTES ((numberOfElements + 1) *
+//   elementSizeInBytes) is refused; use newBuffer() for those
+//  -freeBufferPool() frees every buffer still in the pool
+//
+// Author
+//   Daniel Wilkinson-Thompson (daniel@wilkinson-thompson.com)
+//
+// Date
+//   2026-10-18
+//
+// Licence
+//   Copyright (c) 2026 Daniel Wilkinson-Thompson. All rights reserved.
+//------------------------------------------------------------------------------
+
+#ifndef BUFFERPOOL_H
+#define BUFFERPOOL_H
+
+//------------------------------------------------------------------------------
+// Headers
+//------------------------------------------------------------------------------
+#include "buffer.h"
+
+//------------------------------------------------------------------------------
+// Constants
+//------------------------------------------------------------------------------
+// Bytes mapped at a time for one size class
+#define B_POOL_SLAB_BYTES   (256 * 1024)
+
+// Size classes are B_POOL_MIN_BYTES, twice that, four times that, ...
+#define B_POOL_MIN_BYTES    64
+#define B_POOL_CLASSES      10
+
+// Largest storage a pool will serve
+#define B_POOL_MAX_BYTES    (B_POOL_MIN_BYTES << (B_POOL_CLASSES - 1))
+
+
+//------------------------------------------------------------------------------
+// Type definitions
+//------------------------------------------------------------------------------
+// -A slab is B_POOL_SLAB_BYTES of chunks of one size class. Its descriptor
+//  lives on the heap, so dropping the slab's pages loses nothing
+// -owners[chunk] is the buffer using that chunk, or NULL. The first
+//  (chunks - used) entries of free are the free chunks
+// -released is set once the slab's pages have been given back
+typedef struct B_POOL_SLAB {
+    unsigned char *base;
+    struct B_POOL_SLAB *next;
+    struct B_POOLED_BUFFER **owners;
+    unsigned int *free;
+    unsigned int chunks;
+    unsigned int used;
+    unsigned char released;
+} bufferslab_t;
+
+// -The buffer_t handed out is the first member, so its address is also the
+//  address of this struct
+typedef struct B_POOLED_BUFFER {
+    buffer_t buffer;
+    bufferslab_t *slab;
+    unsigned int chunk;
+} pooledbuffer_t;
+
+// -current[class] is the slab new chunks of that class come from, until it
+//  is full
+typedef struct B_BUFFER_POOL {
+    bufferslab_t *slabs[B_POOL_CLASSES];
+    bufferslab_t *current[B_POOL_CLASSES];
+    unsigned long mapped;
+    unsigned long released;
+} bufferpool_t;
+
+
+//------------------------------------------------------------------------------
+// Function prototypes
+//------------------------------------------------------------------------------
+
+// ------------------------- Generate a new pool ------------------------------
+// -No slabs are mapped until the first buffer is created
+// -A NULL return implies that there was not enough free memory in the heap
+bufferpool_t* newBufferPool(void);
+
+// ------------------------------ Free the pool -------------------------------
+// -Unmaps every slab and frees every buffer still in the pool
+void freeBufferPool(bufferpool_t *p);
+
+// ---------------------- Generate a new pooled buffer ------------------------
+// -Same parameters and behaviour as newBuffer()
+// -A NULL return implies the storage is bigger than B_POOL_MAX_BYTES, or that
+//  no memory was left for a new slab
+buffer_t* newPooledBuffer(bufferpool_t *p, unsigned int numberOfElements, unsigned char elementSizeInBytes, unsigned char config);
+
+// --------------------------- Free a pooled buffer ---------------------------
+// -b must have come from newPooledBuffer() on the same pool
+void freePooledBuffer(bufferpool_t *p, buffer_t *b);
+
+// ------------------------------ Compact the pool ----------------------------
+// -For each size class, moves the storage of buffers from the emptiest slabs
+//  into the free chunks of the fullest ones, then gives the pages of every
+//  empty slab back with madvise(MADV_DONTNEED). Released slabs stay mapped
+//  and are reused before new ones are mapped
+// -Contents, head and tail of every buffer are unchanged; only data moves
+// -The return value is the number of bytes given back
+unsigned long compactBufferPool(bufferpool_t *p);
+
+// ------------------------- Memory held by the pool --------------------------
+// -Bytes of slabs whose pages have not been given back, plus the heap used by
+//  slab descriptors
+unsigned long bufferPoolMemoryUsage(bufferpool_t *p);
+
+#endif
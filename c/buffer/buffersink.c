@@ -0,0 +1,304 @@
+//==============================================================================
+//                                buffersink.c
+//------------------------------------------------------------------------------
+// Brief
+//   Collects small records in a page buffer and writes them to a file in a
+//   few large writes, syncing them in groups
+//
+// Contents
+//   - newSink
+//   - freeSink
+//   - writeToSink
+//   - checkSink
+//   - flushSink
+//   - syncSink
+//   - sinkClock (private)
+//   - writeSinkBytes (private)
+//   - writeOutSink (private)
+//
+// Description
+//   The buffer's tail always sits at a page boundary of the file when it is
+//   O_DIRECT: only whole pages are ever dropped from it, and a partly filled
+//   page written early stays in it (partial bytes long) until it is rewritten
+//   whole. Without O_DIRECT every write drops what it wrote.
+//
+// Author
+//   Daniel Wilkinson-Thompson (daniel@wilkinson-thompson.com)
+//
+// Date
+//   2026-10-18
+//
+// Licence
+//   Copyright (c) 2026 Daniel Wilkinson-Thompson. All rights reserved.
+//------------------------------------------------------------------------------
+
+#ifndef BUFFERSINK_C
+#define BUFFERSINK_C
+
+//------------------------------------------------------------------------------
+// Headers
+//------------------------------------------------------------------------------
+#define _GNU_SOURCE
+#include "buffersink.h"
+#include "bufferio.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <stdlib.h>
+#include <sys/uio.h>
+#include <time.h>
+#include <unistd.h>
+
+//------------------------------------------------------------------------------
+// Private function prototypes
+//------------------------------------------------------------------------------
+unsigned long long sinkClock(void);
+long writeSinkBytes(sink_t *s, unsigned long length, unsigned char keep);
+long writeOutSink(sink_t *s, unsigned char all);
+
+//------------------------------------------------------------------------------
+// Functions
+//------------------------------------------------------------------------------
+// Generate sink
+// -Needs two pages at least, so that a full buffer always holds a whole page
+//  to write with O_DIRECT
+sink_t* newSink(int fd, unsigned int pages, unsigned long flushBytes, unsigned long flushAge, unsigned long syncBytes) {
+    unsigned long page = sysconf(_SC_PAGESIZE);
+    sink_t *s;
+    long long offset;
+    int flags;
+
+    // O_DIRECT writes whole pages from the file's offset on, so that offset
+    // must be at a page boundary
+    flags = fcntl(fd, F_GETFL);
+    if ( (pages < 2) || (flags < 0) || (flags & O_APPEND) ) {
+        return NULL;
+    }
+    offset = lseek(fd, 0, SEEK_CUR);
+    if ( (flags & O_DIRECT) && ((offset < 0) || (offset % page)) ) {
+        errno = EINVAL;
+        return NULL;
+    }
+    s = malloc(sizeof(sink_t));
+    if ( !(s) ) {
+        return NULL;
+    }
+    s->b = newPageBuffer(pages);
+    if ( !(s->b) ) {
+        free(s);
+        return NULL;
+    }
+    s->fd = fd;
+    s->direct = (flags & O_DIRECT) != 0;
+    s->flushBytes = ( flushBytes && (flushBytes < s->b->depth - 1) ) ? flushBytes : s->b->depth - 1;
+
+    // O_DIRECT only writes whole pages, so a size flush waits for one, and
+    // the most a full buffer holds is a page short of its size
+    if (s->direct) {
+        s->flushBytes = (s->flushBytes + page - 1) / page * page;
+        if (s->flushBytes > s->b->depth - 1) {
+            s->flushBytes -= page;
+        }
+    }
+    s->flushAge = flushAge * 1000000ULL;
+    s->syncBytes = syncBytes;
+    s->offset = (offset > 0) ? offset : 0;
+    s->oldest = 0;
+    s->partial = 0;
+    s->unsynced = 0;
+    s->writes = 0;
+    s->syncs = 0;
+    return s;
+}
+
+// Free sink
+void freeSink(sink_t *s) {
+    if (s->syncBytes) {
+        syncSink(s);
+    }
+    else {
+        flushSink(s);
+    }
+    freePageBuffer(s->b);
+    s->b = NULL;
+    free(s);
+}
+
+// Monotonic time in nanoseconds
+unsigned long long sinkClock(void) {
+    struct timespec t;
+
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return t.tv_sec * 1000000000ULL + t.tv_nsec;
+}
+
+// Write length bytes from the tail at the tail's file offset, in one
+// pwritev() unless it comes up short, dropping them unless keep is set
+// -The return value is length, or -1 with errno set
+long writeSinkBytes(sink_t *s, unsigned long length, unsigned char keep) {
+    buffersegment_t seg[2];
+    struct iovec io[2];
+    unsigned long left = length;
+    long n;
+
+    while (left) {
+        peekBuffer(s->b, seg);
+        io[0].iov_base = seg[0].data;
+        io[0].iov_len = (seg[0].count < left) ? seg[0].count : left;
+        io[1].iov_base = seg[1].data;
+        io[1].iov_len = left - io[0].iov_len;
+        n = pwritev(s->fd, io, io[1].iov_len ? 2 : 1, s->offset);
+        s->writes++;
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return -1;
+        }
+
+        // Kept bytes are written again from the start if the write was short
+        if (keep) {
+            left = ((unsigned long)n < left) ? left : 0;
+        }
+        else {
+            discardFromBuffer(s->b, n);
+            s->offset += n;
+            left -= n;
+        }
+    }
+    return length;
+}
+
+// Write out the buffer: everything with all set, otherwise (with O_DIRECT)
+// only its whole pages. Syncs if syncBytes are due
+// -The return value is the number of bytes the file gained, or -1 with errno
+//  set
+long writeOutSink(sink_t *s, unsigned char all) {
+    unsigned long page = sysconf(_SC_PAGESIZE), count, whole, rest;
+    unsigned long long end = s->offset + s->partial;
+    buffersegment_t seg[2];
+    int flags;
+
+    count = peekBuffer(s->b, seg);
+    whole = s->direct ? count - count % page : count;
+    if (whole) {
+        if (writeSinkBytes(s, whole, 0) < 0) {
+            return -1;
+        }
+        s->partial = 0;
+    }
+    rest = count - whole;
+
+    // A partly filled page can't be written with O_DIRECT: write it through
+    // the page cache, keeping it to write whole later
+    if ( all && (rest > s->partial) ) {
+        flags = fcntl(s->fd, F_GETFL);
+        if ( (flags < 0) || fcntl(s->fd, F_SETFL, flags & ~O_DIRECT) ) {
+            return -1;
+        }
+        if (writeSinkBytes(s, rest, 1) < 0) {
+            fcntl(s->fd, F_SETFL, flags);
+            return -1;
+        }
+        fcntl(s->fd, F_SETFL, flags);
+        s->partial = rest;
+    }
+    if ( all || (rest == 0) ) {
+        s->oldest = 0;
+    }
+
+    // A failed fdatasync() leaves unsynced as it was, so those bytes are
+    // synced again next time
+    count = s->offset + s->partial - end;
+    s->unsynced += count;
+    if ( s->syncBytes && (s->unsynced >= s->syncBytes) ) {
+        if (fdatasync(s->fd)) {
+            return -1;
+        }
+        s->syncs++;
+        s->unsynced = 0;
+    }
+    return count;
+}
+
+// Add a record
+int writeToSink(sink_t *s, const void *data, unsigned int length) {
+    const unsigned char *in = data;
+    unsigned int left;
+
+    if ( s->flushAge && !(s->oldest) ) {
+        s->oldest = sinkClock();
+    }
+    for (;;) {
+        left = pushToBuffer(s->b, (void*)in, length);
+        in += length - left;
+        length = left;
+        if ( !(length) ) {
+            break;
+        }
+
+        // Full: make room by writing what is there
+        if (writeOutSink(s, 0) < 0) {
+            return -1;
+        }
+    }
+    return (checkSink(s) < 0) ? -1 : 0;
+}
+
+// Flush if a trigger is due
+// -With O_DIRECT a size flush leaves a partly filled page behind, which the
+//  age trigger still has to write out
+long checkSink(sink_t *s) {
+    buffersegment_t seg[2];
+    unsigned long count;
+    long written = 0, n;
+
+    count = peekBuffer(s->b, seg);
+    if (count == s->partial) {
+        return 0;
+    }
+    if (count >= s->flushBytes) {
+        written = writeOutSink(s, 0);
+        if ( (written < 0) || (peekBuffer(s->b, seg) == s->partial) ) {
+            return written;
+        }
+    }
+    if (s->flushAge) {
+
+        // Filled in place since the last flush: its age starts now
+        if ( !(s->oldest) ) {
+            s->oldest = sinkClock();
+        }
+        else if (sinkClock() - s->oldest >= s->flushAge) {
+            n = writeOutSink(s, 1);
+            return (n < 0) ? n : written + n;
+        }
+    }
+    return written;
+}
+
+// Write everything out
+long flushSink(sink_t *s) {
+    buffersegment_t seg[2];
+
+    if (peekBuffer(s->b, seg) == s->partial) {
+        return 0;
+    }
+    return writeOutSink(s, 1);
+}
+
+// Write everything and make it durable
+int syncSink(sink_t *s) {
+    if (flushSink(s) < 0) {
+        return -1;
+    }
+    if (s->unsynced) {
+        if (fdatasync(s->fd)) {
+            return -1;
+        }
+        s->syncs++;
+        s->unsynced = 0;
+    }
+    return 0;
+}
+
+#endif
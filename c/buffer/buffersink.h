@@ -0,0 +1,151 @@
+//==============================================================================
+//                                buffersink.h
+//------------------------------------------------------------------------------
+// Brief
+//   Collects small records in a page buffer and writes them to a file in a
+//   few large writes, syncing them in groups
+//
+// Contents
+//   - newSink
+//   - freeSink
+//   - writeToSink
+//   - checkSink
+//   - flushSink
+//   - syncSink
+//
+// Description
+//   A write() per record makes a persistence thread syscall-bound long before
+//   the disk is busy. A sink copies records into its page buffer instead, and
+//   writes the buffer's contents with one pwritev() straight from its (at
+//   most two) segments once flushBytes have collected, or once the oldest of
+//   them is flushAge milliseconds old. fdatasync() follows whenever syncBytes
+//   more have been written, so the cost of making them durable is shared by
+//   every record in between.
+//   If the file was opened with O_DIRECT, writes bypass the page cache. The
+//   buffer's storage is page-aligned and every write is a whole number of
+//   pages at a page-aligned offset, which meets any block size up to the page
+//   size. flushSink() and syncSink() write a last, partly filled page with
+//   O_DIRECT turned off for the one write, and keep it in the buffer to be
+//   written again, whole, once it has filled.
+//   Declaration
+//      sink_t *s;
+//      fd = open("journal", O_WRONLY | O_CREAT | O_TRUNC | O_DIRECT, 0600);
+//      s = newSink(fd, 512, 1 << 20, 10, 1 << 20);
+//   Persistence thread
+//      while (...) {
+//          if (...a record arrived...) {
+//              writeToSink(s, record, length);
+//          }
+//          checkSink(s);
+//      }
+//      syncSink(s);
+//      freeSink(s);
+//   Records can also be built in place with reserveInBuffer() and
+//   commitToBuffer() on s->b (e.g. by encodeFrame()), followed by
+//   checkSink().
+//
+// Warnings
+//  -Sinks are not thread-safe: one thread writes records and checks the sink
+//  -The sink writes at the file's offset when it was created and onwards with
+//   pwritev(), so nothing else may write to fd, and fd must not be O_APPEND
+//  -The age trigger is only looked at by writeToSink() and checkSink(), so
+//   call checkSink() at least every flushAge milliseconds while idle
+//  -Records are only durable once fdatasync() has followed their write, i.e.
+//   after syncSink() or once syncBytes more have been written
+//  -freeSink() flushes and, if syncBytes is not zero, syncs, but can't report
+//   failure; call syncSink() first when that matters
+//  -Linux-only when fd is O_DIRECT
+//
+// Author
+//   Daniel Wilkinson-Thompson (daniel@wilkinson-thompson.com)
+//
+// Date
+//   2026-10-18
+//
+// Licence
+//   Copyright (c) 2026 Daniel Wilkinson-Thompson. All rights reserved.
+//------------------------------------------------------------------------------
+
+#ifndef BUFFERSINK_H
+#define BUFFERSINK_H
+
+//------------------------------------------------------------------------------
+// Headers
+//------------------------------------------------------------------------------
+#include "buffer.h"
+
+//------------------------------------------------------------------------------
+// Type definitions
+//------------------------------------------------------------------------------
+// -b is a page buffer whose tail is at file offset offset. With O_DIRECT
+//  (direct set), partial bytes at the tail have been written already but are
+//  kept to be written again
+// -oldest is when (CLOCK_MONOTONIC, nanoseconds) the first byte not yet
+//  written arrived, and unsynced how many bytes were written since the last
+//  fdatasync() that succeeded
+// -writes and syncs count the calls made
+typedef struct B_SINK {
+    buffer_t *b;
+    int fd;
+    unsigned char direct;
+    unsigned long flushBytes;
+    unsigned long long flushAge;
+    unsigned long syncBytes;
+    unsigned long long offset;
+    unsigned long long oldest;
+    unsigned long partial;
+    unsigned long unsynced;
+    unsigned long writes;
+    unsigned long syncs;
+} sink_t;
+
+
+//------------------------------------------------------------------------------
+// Function prototypes
+//------------------------------------------------------------------------------
+
+// ---------------------------- Generate a new sink ---------------------------
+// -Writes to fd through a page buffer of pages pages, once flushBytes bytes
+//  (at most the buffer's size) have collected or the oldest of them is
+//  flushAge milliseconds old. 0 for either leaves that trigger off
+// -With O_DIRECT, flushBytes is rounded up to whole pages, since only whole
+//  pages are written before the age trigger is due
+// -fdatasync() follows once syncBytes more bytes have been written; 1 syncs
+//  after every write, 0 only in syncSink()
+// -With O_DIRECT, fd's offset must be at a page boundary (e.g. 0, or the end
+//  of a file only ever written whole pages at a time)
+// -A NULL return implies there was not enough memory, or that fd can't be
+//  used: O_APPEND, or O_DIRECT at an offset that isn't page-aligned (errno
+//  EINVAL)
+sink_t* newSink(int fd, unsigned int pages, unsigned long flushBytes, unsigned long flushAge, unsigned long syncBytes);
+
+// ------------------------------- Free the sink ------------------------------
+// -Flushes (and syncs, if syncBytes is not 0) what is left first. fd stays
+//  open
+void freeSink(sink_t *s);
+
+// ------------------------------ Add a record --------------------------------
+// -Copies length bytes into the buffer, writing out what is there first if
+//  there is no room, then flushes if a trigger is due
+// -Records bigger than the buffer are split across writes
+// -The return value is 0, or -1 with errno set if a write or sync failed; the
+//  record is in the buffer either way, up to what fitted
+int writeToSink(sink_t *s, const void *data, unsigned int length);
+
+// ------------------------ Flush if a trigger is due -------------------------
+// -The return value is the number of bytes the file gained, 0 if no trigger
+//  was due, or -1 with errno set
+long checkSink(sink_t *s);
+
+// -------------------------- Write everything out ----------------------------
+// -Writes all the buffer holds and syncs if syncBytes have been written since
+//  the last sync
+// -The return value is the number of bytes the file gained, or -1 with errno
+//  set
+long flushSink(sink_t *s);
+
+// ---------------------- Write everything and make it durable ----------------
+// -The return value is 0, or -1 with errno set
+int syncSink(sink_t *s);
+
+#endif
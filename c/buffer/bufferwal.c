@@ -0,0 +1,365 @@
+//==============================================================================
+//                                 bufferwal.c
+//------------------------------------------------------------------------------
+// Brief
+//   Implements a write-ahead log that many threads append records to and that
+//   one flusher thread makes durable in groups
+//
+// Contents
+//   - newWal
+//   - freeWal
+//   - appendToWal
+//   - waitForWal
+//   - commitToWal
+//   - readWalRecord
+//   - makeWalCrcTable (private, without SSE4.2)
+//   - walCrc (private)
+//   - putWalHeader (private)
+//   - runWalFlusher (private)
+//
+// Description
+//   Producers hold the lock only to claim an LSN and copy their record in;
+//   the CRC of the record's bytes is worked out before, and only the 12
+//   header bytes after the CRC are added to it under the lock. The flusher
+//   holds the lock only to note what the buffer holds and, after the sync, to
+//   drop it and wake the waiters. Producers only ever write to free space, so
+//   the bytes it writes can't change under it.
+//   The CRC is CRC-32C (Castagnoli), with the SSE4.2 crc32 instruction when
+//   compiled for it (-msse4.2 or -march=native) and a table otherwise.
+//   There is no file-backed ring here to build the log on, and a ring that
+//   wraps in place would overwrite records a crash may still need, so the
+//   buffer only stages records in memory and the file is append-only, in a
+//   format of its own: each record carries its length, LSN and CRC, which is
+//   all recovery needs to find where the log ends.
+//
+// Author
+//   Daniel Wilkinson-Thompson (daniel@wilkinson-thompson.com)
+//
+// Date
+//   2026-10-18
+//
+// Licence
+//   Copyright (c) 2026 Daniel Wilkinson-Thompson. All rights reserved.
+//------------------------------------------------------------------------------
+
+#ifndef BUFFERWAL_C
+#define BUFFERWAL_C
+
+//------------------------------------------------------------------------------
+// Headers
+//------------------------------------------------------------------------------
+#define _GNU_SOURCE
+#include "bufferwal.h"
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#ifdef __SSE4_2__
+#include <nmmintrin.h>
+#endif
+
+//------------------------------------------------------------------------------
+// Private function prototypes
+//------------------------------------------------------------------------------
+#ifndef __SSE4_2__
+void makeWalCrcTable(void);
+#endif
+unsigned int walCrc(unsigned int crc, const void *data, unsigned long length);
+void putWalHeader(unsigned char header[B_WAL_HEADER_BYTES], unsigned int crc, unsigned int length, unsigned long long lsn);
+void* runWalFlusher(void *arg);
+
+//------------------------------------------------------------------------------
+// Variables
+//------------------------------------------------------------------------------
+// CRC-32C of each byte value, for when there is no crc32 instruction
+#ifndef __SSE4_2__
+static unsigned int walCrcTable[256];
+static pthread_once_t walCrcTableMade = PTHREAD_ONCE_INIT;
+#endif
+
+//------------------------------------------------------------------------------
+// Functions
+//------------------------------------------------------------------------------
+#ifndef __SSE4_2__
+// Fill walCrcTable
+void makeWalCrcTable(void) {
+    unsigned int i, j, crc;
+
+    for (i = 0; i < 256; i++) {
+        crc = i;
+        for (j = 0; j < 8; j++) {
+            crc = (crc >> 1) ^ ((crc & 1) ? 0x82F63B78 : 0);
+        }
+        walCrcTable[i] = crc;
+    }
+}
+#endif
+
+// Carry a CRC-32C on over more bytes
+// -crc is the running value: start from 0xFFFFFFFF and invert at the end
+unsigned int walCrc(unsigned int crc, const void *data, unsigned long length) {
+    const unsigned char *in = data;
+#ifdef __SSE4_2__
+    unsigned long long word;
+    unsigned long long wide = crc;
+
+    for (; length >= 8; in += 8, length -= 8) {
+        memcpy(&word, in, 8);
+        wide = _mm_crc32_u64(wide, word);
+    }
+    crc = wide;
+    for (; length; in++, length--) {
+        crc = _mm_crc32_u8(crc, *in);
+    }
+#else
+    pthread_once(&walCrcTableMade, makeWalCrcTable);
+    for (; length; in++, length--) {
+        crc = walCrcTable[(crc ^ *in) & 0xFF] ^ (crc >> 8);
+    }
+#endif
+    return crc;
+}
+
+// Fill in a record header
+// -crc is the running CRC of the record's bytes, finished here over the rest
+//  of the header
+void putWalHeader(unsigned char header[B_WAL_HEADER_BYTES], unsigned int crc, unsigned int length, unsigned long long lsn) {
+    unsigned int i;
+
+    for (i = 0; i < 4; i++) {
+        header[4 + i] = length >> (8 * i);
+    }
+    for (i = 0; i < 8; i++) {
+        header[8 + i] = lsn >> (8 * i);
+    }
+    crc = ~walCrc(crc, header + 4, B_WAL_HEADER_BYTES - 4);
+    for (i = 0; i < 4; i++) {
+        header[i] = crc >> (8 * i);
+    }
+}
+
+// Write and sync whatever the buffer holds, over and over
+void* runWalFlusher(void *arg) {
+    wal_t *w = arg;
+    buffersegment_t s[2];
+    struct iovec io[2];
+    unsigned long long lsn;
+    unsigned long done, skip;
+    unsigned int count;
+    int error = 0;
+    long n;
+
+    pthread_mutex_lock(&(w->lock));
+    for (;;) {
+        while ( isBufferEmpty(w->b) && !(w->stop) ) {
+            pthread_cond_wait(&(w->queued), &(w->lock));
+        }
+        if (isBufferEmpty(w->b)) {
+            break;
+        }
+        count = peekBuffer(w->b, s);
+        lsn = w->appended;
+        pthread_mutex_unlock(&(w->lock));
+
+        // Write the group, then sync it, while the next one gathers
+        for (done = 0; (done < count) && !(error); ) {
+            skip = (done < s[0].count) ? done : s[0].count;
+            io[0].iov_base = (unsigned char*)s[0].data + skip;
+            io[0].iov_len = s[0].count - skip;
+            io[1].iov_base = (unsigned char*)s[1].data + (done - skip);
+            io[1].iov_len = s[1].count - (done - skip);
+            if ( !(io[0].iov_len) ) {
+                io[0] = io[1];
+                io[1].iov_len = 0;
+            }
+            n = pwritev(w->fd, io, io[1].iov_len ? 2 : 1, w->offset + done);
+            if (n >= 0) {
+                done += n;
+            }
+            else if (errno != EINTR) {
+                error = errno;
+            }
+        }
+        if ( !(error) && fdatasync(w->fd) ) {
+            error = errno;
+        }
+
+        pthread_mutex_lock(&(w->lock));
+        if (error) {
+            w->failed = error;
+            pthread_cond_broadcast(&(w->synced));
+            break;
+        }
+        discardFromBuffer(w->b, count);
+        w->offset += count;
+        w->durable = lsn;
+        w->flushes++;
+        pthread_cond_broadcast(&(w->synced));
+    }
+    pthread_mutex_unlock(&(w->lock));
+    return NULL;
+}
+
+// Generate log
+wal_t* newWal(int fd, unsigned int bytes, unsigned long long offset, unsigned long long lsn) {
+    wal_t *w;
+
+    if ( (bytes <= B_WAL_HEADER_BYTES) || ftruncate(fd, offset) ) {
+        return NULL;
+    }
+    w = malloc(sizeof(wal_t));
+    if ( !(w) ) {
+        return NULL;
+    }
+    w->b = newBuffer(bytes, 1, B_FIFO & B_DROP);
+    if ( !(w->b) ) {
+        free(w);
+        return NULL;
+    }
+    w->fd = fd;
+    w->offset = offset;
+    w->appended = lsn;
+    w->durable = lsn;
+    w->flushes = 0;
+    w->failed = 0;
+    w->stop = 0;
+    pthread_mutex_init(&(w->lock), NULL);
+    pthread_cond_init(&(w->queued), NULL);
+    pthread_cond_init(&(w->synced), NULL);
+    if (pthread_create(&(w->flusher), NULL, runWalFlusher, w)) {
+        pthread_cond_destroy(&(w->synced));
+        pthread_cond_destroy(&(w->queued));
+        pthread_mutex_destroy(&(w->lock));
+        freeBuffer(w->b);
+        free(w);
+        return NULL;
+    }
+    return w;
+}
+
+// Free log
+void freeWal(wal_t *w) {
+    pthread_mutex_lock(&(w->lock));
+    w->stop = 1;
+    pthread_cond_signal(&(w->queued));
+    pthread_mutex_unlock(&(w->lock));
+    pthread_join(w->flusher, NULL);
+
+    pthread_cond_destroy(&(w->synced));
+    pthread_cond_destroy(&(w->queued));
+    pthread_mutex_destroy(&(w->lock));
+    freeBuffer(w->b);
+    w->b = NULL;
+    free(w);
+}
+
+// Queue a record
+unsigned long long appendToWal(wal_t *w, const void *data, unsigned int length) {
+    unsigned char header[B_WAL_HEADER_BYTES];
+    buffersegment_t s[2];
+    unsigned long long lsn;
+    unsigned int crc;
+
+    if (length > w->b->depth - 1 - B_WAL_HEADER_BYTES) {
+        errno = EMSGSIZE;
+        return 0;
+    }
+    crc = walCrc(0xFFFFFFFF, data, length);
+
+    pthread_mutex_lock(&(w->lock));
+    while ( !(w->failed) && (reserveInBuffer(w->b, s) < B_WAL_HEADER_BYTES + length) ) {
+        pthread_cond_wait(&(w->synced), &(w->lock));
+    }
+    if (w->failed) {
+        errno = w->failed;
+        pthread_mutex_unlock(&(w->lock));
+        return 0;
+    }
+    lsn = ++(w->appended);
+    putWalHeader(header, crc, length, lsn);
+    pushToBuffer(w->b, header, B_WAL_HEADER_BYTES);
+    pushToBuffer(w->b, (void*)data, length);
+    pthread_cond_signal(&(w->queued));
+    pthread_mutex_unlock(&(w->lock));
+    return lsn;
+}
+
+// Wait for a record to be durable
+int waitForWal(wal_t *w, unsigned long long lsn) {
+    int failed;
+
+    pthread_mutex_lock(&(w->lock));
+    while ( (w->durable < lsn) && !(w->failed) ) {
+        pthread_cond_wait(&(w->synced), &(w->lock));
+    }
+    failed = (w->durable < lsn) ? w->failed : 0;
+    pthread_mutex_unlock(&(w->lock));
+    if (failed) {
+        errno = failed;
+        return -1;
+    }
+    return 0;
+}
+
+// Append a durable record
+unsigned long long commitToWal(wal_t *w, const void *data, unsigned int length) {
+    unsigned long long lsn;
+
+    lsn = appendToWal(w, data, length);
+    if ( lsn && waitForWal(w, lsn) ) {
+        return 0;
+    }
+    return lsn;
+}
+
+// Read a record back from a log
+long readWalRecord(int fd, unsigned long long *offset, unsigned long long *lsn, void *data, unsigned int max) {
+    unsigned char header[B_WAL_HEADER_BYTES], check[B_WAL_HEADER_BYTES];
+    unsigned long long number = 0;
+    struct stat st;
+    unsigned int length = 0, i;
+    long n;
+
+    n = pread(fd, header, B_WAL_HEADER_BYTES, *offset);
+    if (n == 0) {
+        return B_WAL_END;
+    }
+    if (n != B_WAL_HEADER_BYTES) {
+        return B_WAL_TORN;
+    }
+    for (i = 0; i < 4; i++) {
+        length |= (unsigned int)header[4 + i] << (8 * i);
+    }
+    for (i = 0; i < 8; i++) {
+        number |= (unsigned long long)header[8 + i] << (8 * i);
+    }
+    if (number != *lsn + 1) {
+        return B_WAL_TORN;
+    }
+
+    // A record running past the end of the file is torn; one that is there
+    // but too long for data stays put until the caller has room for it
+    if ( fstat(fd, &st) || (*offset + B_WAL_HEADER_BYTES + length > (unsigned long long)st.st_size) ) {
+        return B_WAL_TORN;
+    }
+    if (length > max) {
+        return B_WAL_TOO_LONG - (long)length;
+    }
+    if (pread(fd, data, length, *offset + B_WAL_HEADER_BYTES) != (long)length) {
+        return B_WAL_TORN;
+    }
+
+    // Rebuild the header from what was read; a torn or corrupted record
+    // doesn't match
+    putWalHeader(check, walCrc(0xFFFFFFFF, data, length), length, number);
+    if (memcmp(check, header, 4)) {
+        return B_WAL_TORN;
+    }
+    *offset += B_WAL_HEADER_BYTES + length;
+    *lsn = number;
+    return length;
+}
+
+#endif
@@ -0,0 +1,178 @@
+//==============================================================================
+//                                 bufferwal.h
+//------------------------------------------------------------------------------
+// Brief
+//   Implements a write-ahead log that many threads append records to and that
+//   one flusher thread makes durable in groups
+//
+// Contents
+//   - newWal
+//   - freeWal
+//   - appendToWal
+//   - waitForWal
+//   - commitToWal
+//   - readWalRecord
+//
+// Description
+//   Producers copy records into a shared byte buffer and wait. The log's
+//   flusher thread writes everything the buffer holds with one pwritev(),
+//   calls fdatasync() once, and then wakes every producer whose record that
+//   covered. While it is syncing, the next group gathers in the buffer, so
+//   the more producers commit at once, the more records share each sync.
+//   Each record in the file is a header followed by the record's bytes:
+//      offset 0   CRC-32C of the record's bytes followed by header bytes
+//                 4 to 15
+//      offset 4   record length in bytes
+//      offset 8   log sequence number (LSN): 1 for the first record of the
+//                 file, one more for each record after it
+//   all little-endian. readWalRecord() reads the file back a record at a
+//   time and stops at the first record that is incomplete, fails its CRC or
+//   has the wrong LSN, i.e. where a crash tore a write. It tells a record
+//   that is merely too long for the caller's memory apart from a torn one.
+//   Declaration
+//      wal_t *w;
+//      unsigned long long offset = 0, lsn = 0;
+//      unsigned int max = 256;
+//      unsigned char *record = malloc(max);
+//      long n;
+//      fd = open("journal", O_RDWR | O_CREAT, 0600);
+//      while ( (n = readWalRecord(fd, &offset, &lsn, record, max)) != B_WAL_END ) {
+//          if (n <= B_WAL_TOO_LONG) {
+//              max = B_WAL_NEEDED(n);
+//              record = realloc(record, max);
+//              continue;
+//          }
+//          if (n == B_WAL_TORN) {
+//              break;
+//          }
+//          ...replay record...
+//      }
+//      w = newWal(fd, 1 << 20, offset, lsn);
+//   Committing (from any number of threads)
+//      if (commitToWal(w, &update, sizeof(update)) == 0) {
+//          ...the log has failed...
+//      }
+//   or, to overlap other work with the sync
+//      lsn = appendToWal(w, &update, sizeof(update));
+//      ...
+//      waitForWal(w, lsn);
+//
+// Warnings
+//  -newWal() truncates the file at offset, dropping whatever a crash left
+//   after the last whole record
+//  -A record is durable only once waitForWal() (or commitToWal()) has
+//   returned for it. appendToWal() only queues it
+//  -Once a write or fdatasync() fails the log stops for good, since the
+//   kernel may have dropped the pages it failed to write: every waiting and
+//   later call reports failure
+//  -Appending waits while the buffer is full, and records bigger than the
+//   buffer less a header are refused
+//  -Nothing else may write to the file while it is a log
+//
+// Author
+//   Daniel Wilkinson-Thompson (daniel@wilkinson-thompson.com)
+//
+// Date
+//   2026-10-18
+//
+// Licence
+//   Copyright (c) 2026 Daniel Wilkinson-Thompson. All rights reserved.
+//------------------------------------------------------------------------------
+
+#ifndef BUFFERWAL_H
+#define BUFFERWAL_H
+
+//------------------------------------------------------------------------------
+// Headers
+//------------------------------------------------------------------------------
+#include "buffer.h"
+#include <pthread.h>
+
+//------------------------------------------------------------------------------
+// Constants
+//------------------------------------------------------------------------------
+// Bytes of header before each record
+#define B_WAL_HEADER_BYTES  16
+
+// readWalRecord() results other than a record length
+// -B_WAL_TOO_LONG and below mean the record needs B_WAL_NEEDED(result) bytes
+#define B_WAL_END           -1
+#define B_WAL_TORN          -2
+#define B_WAL_TOO_LONG      -3
+#define B_WAL_NEEDED(n)     ((unsigned int)(B_WAL_TOO_LONG - (n)))
+
+
+//------------------------------------------------------------------------------
+// Type definitions
+//------------------------------------------------------------------------------
+// -lock guards everything but the bytes between the buffer's tail and head,
+//  which only the flusher reads while it writes them
+// -appended is the LSN of the last record in the buffer or written, durable
+//  the last one synced. offset is the file offset of the buffer's tail
+// -failed is the errno of the write or sync that stopped the log, or 0
+// -flushes counts the groups synced
+typedef struct B_WAL {
+    buffer_t *b;
+    int fd;
+    pthread_mutex_t lock;
+    pthread_cond_t queued;
+    pthread_cond_t synced;
+    pthread_t flusher;
+    unsigned long long offset;
+    unsigned long long appended;
+    unsigned long long durable;
+    unsigned long flushes;
+    int failed;
+    unsigned char stop;
+} wal_t;
+
+
+//------------------------------------------------------------------------------
+// Function prototypes
+//------------------------------------------------------------------------------
+
+// ---------------------------- Generate a new log ----------------------------
+// -Appends to fd at offset through a buffer of bytes bytes, numbering records
+//  on from lsn, the LSN of the last record already at offset (0 if none).
+//  Both are where readWalRecord() left them
+// -Starts the flusher thread
+// -A NULL return implies there was not enough memory, or the file could not be
+//  truncated or the thread started
+wal_t* newWal(int fd, unsigned int bytes, unsigned long long offset, unsigned long long lsn);
+
+// ------------------------------- Free the log -------------------------------
+// -Makes every record appended durable, then stops the flusher. fd stays open
+// -No thread may be appending or waiting
+void freeWal(wal_t *w);
+
+// ---------------------------- Queue a record --------------------------------
+// -Copies length bytes into the log, waiting while there is no room
+// -The return value is the record's LSN, or 0 with errno set if the record
+//  is too big (EMSGSIZE) or the log has failed
+unsigned long long appendToWal(wal_t *w, const void *data, unsigned int length);
+
+// ------------------------ Wait for a record to be durable -------------------
+// -Returns once the record numbered lsn and every one before it are synced
+// -The return value is 0, or -1 with errno set if the log has failed first
+int waitForWal(wal_t *w, unsigned long long lsn);
+
+// -------------------------- Append a durable record -------------------------
+// -appendToWal() then waitForWal()
+// -The return value is the record's LSN, or 0 with errno set
+unsigned long long commitToWal(wal_t *w, const void *data, unsigned int length);
+
+// ----------------------- Read a record back from a log ----------------------
+// -Reads the record at *offset into data (max bytes at most) and checks that
+//  it is whole, matches its CRC and is numbered *lsn + 1. If so, moves
+//  *offset past it and *lsn on to it
+// -The return value is the record's length, B_WAL_END if the file ends at
+//  *offset, or B_WAL_TORN if the record there is incomplete, fails its CRC or
+//  has the wrong LSN. Either way *offset and *lsn are where to append after
+//  the last good record
+// -A record longer than max is left unread, with *offset and *lsn unmoved,
+//  and the return value is B_WAL_TOO_LONG or below: call again with
+//  B_WAL_NEEDED(result) bytes of room. Never pass *offset to newWal() then,
+//  since it would truncate the record away
+long readWalRecord(int fd, unsigned long long *offset, unsigned long long *lsn, void *data, unsigned int max);
+
+#endif
@@ -0,0 +1,211 @@
+//==============================================================================
+//                                chunkbuffer.c
+//------------------------------------------------------------------------------
+// Brief
+//   Implements an unbounded FIFO queue made of a list of fixed-size ring
+//   chunks, taken from and given back to a chunk pool
+//
+// Contents
+//   - newChunkPool
+//   - freeChunkPool
+//   - trimChunkPool
+//   - newChunkBuffer
+//   - freeChunkBuffer
+//   - isChunkBufferEmpty
+//   - pushToChunkBuffer
+//   - popFromChunkBuffer
+//   - takeChunk (private)
+//   - giveBackChunk (private)
+//
+// Description
+//   Each chunk is one allocation: the bufferchunk_t, then its storage of
+//   elements + 1 slots, so taking and giving back a chunk is a list
+//   operation and an initBuffer() over the same storage.
+//
+// Author
+//   Daniel Wilkinson-Thompson (daniel@wilkinson-thompson.com)
+//
+// Date
+//   2026-10-18
+//
+// Licence
+//   Copyright (c) 2026 Daniel Wilkinson-Thompson. All rights reserved.
+//------------------------------------------------------------------------------
+
+#ifndef CHUNKBUFFER_C
+#define CHUNKBUFFER_C
+
+//------------------------------------------------------------------------------
+// Headers
+//------------------------------------------------------------------------------
+#ifndef _POSIX_C_SOURCE
+#define _POSIX_C_SOURCE 200112L
+#endif
+#include "chunkbuffer.h"
+#include <limits.h>
+#include <stdlib.h>
+
+//------------------------------------------------------------------------------
+// Private function prototypes
+//------------------------------------------------------------------------------
+bufferchunk_t* takeChunk(chunkpool_t *p);
+void giveBackChunk(chunkpool_t *p, bufferchunk_t *c);
+
+//------------------------------------------------------------------------------
+// Functions
+//------------------------------------------------------------------------------
+// Generate chunk pool
+chunkpool_t* newChunkPool(unsigned int elementsPerChunk, unsigned char elementSizeInBytes) {
+    chunkpool_t *p;
+
+    // A chunk's depth is one more than its elements, so it must not wrap
+    if ( (elementsPerChunk == 0) || (elementsPerChunk == UINT_MAX) || (elementSizeInBytes == 0) ) {
+        return NULL;
+    }
+    p = malloc(sizeof(chunkpool_t));
+    if ( !(p) ) {
+        return NULL;
+    }
+    p->elements = elementsPerChunk;
+    p->width = elementSizeInBytes;
+    p->spare = NULL;
+    p->spares = 0;
+    p->chunks = 0;
+    return p;
+}
+
+// Free chunk pool
+void freeChunkPool(chunkpool_t *p) {
+    trimChunkPool(p, 0);
+    free(p);
+}
+
+// Free spare chunks
+void trimChunkPool(chunkpool_t *p, unsigned long keep) {
+    bufferchunk_t *c;
+
+    while (p->spares > keep) {
+        c = p->spare;
+        p->spare = c->next;
+        p->spares--;
+        p->chunks--;
+        free(c);
+    }
+}
+
+// Take a spare chunk, or allocate one
+// -Storage follows the chunk, which keeps the chunk's alignment, so it suits
+//  any element type no more aligned than buffer_t
+// -A NULL return implies there was not enough memory
+bufferchunk_t* takeChunk(chunkpool_t *p) {
+    bufferchunk_t *c = p->spare;
+
+    if (c) {
+        p->spare = c->next;
+        p->spares--;
+    }
+    else {
+        if ( posix_memalign((void**)&c, __alignof__(bufferchunk_t),
+                            sizeof(bufferchunk_t) + (p->elements + 1UL) * p->width) ) {
+            return NULL;
+        }
+        p->chunks++;
+    }
+    initBuffer(&(c->b), c + 1, p->elements, p->width, B_FIFO & B_DROP);
+    c->next = NULL;
+    return c;
+}
+
+// Put a chunk on the spare list
+void giveBackChunk(chunkpool_t *p, bufferchunk_t *c) {
+    c->next = p->spare;
+    p->spare = c;
+    p->spares++;
+}
+
+// Generate chunk buffer
+chunkbuffer_t* newChunkBuffer(chunkpool_t *p) {
+    chunkbuffer_t *q;
+
+    q = malloc(sizeof(chunkbuffer_t));
+    if ( !(q) ) {
+        return NULL;
+    }
+    q->pool = p;
+    q->first = NULL;
+    q->last = NULL;
+    q->count = 0;
+    return q;
+}
+
+// Free chunk buffer
+void freeChunkBuffer(chunkbuffer_t *q) {
+    bufferchunk_t *c, *next;
+
+    for (c = q->first; c; c = next) {
+        next = c->next;
+        giveBackChunk(q->pool, c);
+    }
+    q->first = NULL;
+    q->last = NULL;
+    free(q);
+}
+
+// Chunk buffer empty check
+unsigned char isChunkBufferEmpty(chunkbuffer_t *q) {
+    return (q->count == 0);
+}
+
+// Push to the last chunk, linking on another whenever it fills
+unsigned int pushToChunkBuffer(chunkbuffer_t *q, const void *d, unsigned int l) {
+    const unsigned char *in = d;
+    bufferchunk_t *c;
+    unsigned int left;
+
+    while (l) {
+        if ( !(q->last) || isBufferFull(&(q->last->b)) ) {
+            c = takeChunk(q->pool);
+            if ( !(c) ) {
+                return l;
+            }
+            if (q->last) {
+                q->last->next = c;
+            }
+            else {
+                q->first = c;
+            }
+            q->last = c;
+        }
+        left = pushToBuffer(&(q->last->b), (void*)in, l);
+        in += (l - left) * q->pool->width;
+        q->count += l - left;
+        l = left;
+    }
+    return 0;
+}
+
+// Pop from the first chunk, giving it back once it is empty and another
+// follows it
+unsigned int popFromChunkBuffer(chunkbuffer_t *q, void *d, unsigned int l) {
+    unsigned char *out = d;
+    bufferchunk_t *c;
+    unsigned int left;
+
+    while ( l && (c = q->first) ) {
+        left = popFromBuffer(&(c->b), out, l);
+        out += (l - left) * q->pool->width;
+        q->count -= l - left;
+        l = left;
+        if ( !(isBufferEmpty(&(c->b))) ) {
+            break;
+        }
+        if (c == q->last) {
+            break;
+        }
+        q->first = c->next;
+        giveBackChunk(q->pool, c);
+    }
+    return l;
+}
+
+#endif
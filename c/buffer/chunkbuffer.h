@@ -0,0 +1,138 @@
+//==============================================================================
+//                                chunkbuffer.h
+//------------------------------------------------------------------------------
+// Brief
+//   Implements an unbounded FIFO queue made of a list of fixed-size ring
+//   chunks, taken from and given back to a chunk pool
+//
+// Contents
+//   - newChunkPool
+//   - freeChunkPool
+//   - trimChunkPool
+//   - newChunkBuffer
+//   - freeChunkBuffer
+//   - isChunkBufferEmpty
+//   - pushToChunkBuffer
+//   - popFromChunkBuffer
+//
+// Description
+//   A buffer_t has a fixed depth, so a backlog that grows a thousandfold has
+//   to be dropped, or the buffer made that big up front, or reallocated and
+//   copied as a whole while it grows. A chunk buffer instead holds its
+//   elements in a list of chunks, each a buffer_t of the pool's size:
+//   pushes go to the last chunk, pops come from the first, and a new chunk is
+//   linked on when the last one fills. While the backlog fits in one chunk,
+//   that chunk is used as an ordinary ring and no chunk is ever taken or
+//   given back. A chunk emptied by pops goes back to the pool's spare list,
+//   from which the next one needed is taken, so memory follows the backlog
+//   without malloc() in the steady state, and no push or pop ever moves more
+//   than the elements it is given.
+//   Declaration
+//      chunkpool_t *pool;
+//      chunkbuffer_t *q;
+//      pool = newChunkPool(4096, sizeof(event_t));
+//      q = newChunkBuffer(pool);
+//   Use
+//      pushToChunkBuffer(q, &events[0], 16);
+//      failedElements = popFromChunkBuffer(q, &events[0], 16);
+//   Once a backlog has drained, e.g. from a housekeeping timer, hand all but
+//   a few spare chunks back to the heap:
+//      trimChunkPool(pool, 4);
+//
+// Warnings
+//  -Pools and chunk buffers are not thread-safe: one thread at a time uses a
+//   pool and all the chunk buffers made from it
+//  -A push only fails (reporting the elements not pushed) when a chunk can't
+//   be allocated
+//  -Free every chunk buffer of a pool before the pool
+//
+// Author
+//   Daniel Wilkinson-Thompson (daniel@wilkinson-thompson.com)
+//
+// Date
+//   2026-10-18
+//
+// Licence
+//   Copyright (c) 2026 Daniel Wilkinson-Thompson. All rights reserved.
+//------------------------------------------------------------------------------
+
+#ifndef CHUNKBUFFER_H
+#define CHUNKBUFFER_H
+
+//------------------------------------------------------------------------------
+// Headers
+//------------------------------------------------------------------------------
+#include "buffer.h"
+
+//------------------------------------------------------------------------------
+// Type definitions
+//------------------------------------------------------------------------------
+// -A chunk is a FIFO buffer_t with its storage right after the chunk, and the
+//  link to the next chunk of its chunk buffer, or of the pool's spare list
+typedef struct B_CHUNK {
+    buffer_t b;
+    struct B_CHUNK *next;
+} bufferchunk_t;
+
+// -Every chunk of a pool holds elements elements of width bytes
+// -spare lists the chunks no chunk buffer is using, spares long, and chunks
+//  counts every chunk allocated and not yet freed
+typedef struct B_CHUNK_POOL {
+    unsigned int elements;
+    unsigned char width;
+    bufferchunk_t *spare;
+    unsigned long spares;
+    unsigned long chunks;
+} chunkpool_t;
+
+// -Elements are pushed to last and popped from first. An empty chunk buffer
+//  keeps one chunk (first equals last), or none until the first push
+// -count is the number of elements in the chunk buffer
+typedef struct B_CHUNK_BUFFER {
+    chunkpool_t *pool;
+    bufferchunk_t *first;
+    bufferchunk_t *last;
+    unsigned long count;
+} chunkbuffer_t;
+
+
+//------------------------------------------------------------------------------
+// Function prototypes
+//------------------------------------------------------------------------------
+
+// ------------------------- Generate a new chunk pool ------------------------
+// -Chunks of the pool each hold elementsPerChunk elements of
+//  elementSizeInBytes bytes
+// -A NULL return implies there was not enough memory
+chunkpool_t* newChunkPool(unsigned int elementsPerChunk, unsigned char elementSizeInBytes);
+
+// ----------------------------- Free the chunk pool --------------------------
+void freeChunkPool(chunkpool_t *p);
+
+// --------------------------- Free spare chunks ------------------------------
+// -Frees spare chunks until no more than keep are left
+void trimChunkPool(chunkpool_t *p, unsigned long keep);
+
+// ------------------------ Generate a new chunk buffer -----------------------
+// -A NULL return implies there was not enough memory
+chunkbuffer_t* newChunkBuffer(chunkpool_t *p);
+
+// ---------------------------- Free the chunk buffer -------------------------
+// -Its chunks go back to the pool as spares
+void freeChunkBuffer(chunkbuffer_t *q);
+
+// ------------------------- Check chunk buffer is empty ----------------------
+unsigned char isChunkBufferEmpty(chunkbuffer_t *q);
+
+// ----------------------- Push data to the chunk buffer ----------------------
+// -As pushToBuffer(), linking on chunks as needed
+// -The return value is the number of elements that could not be pushed,
+//  which is only ever non-zero if a chunk could not be allocated
+unsigned int pushToChunkBuffer(chunkbuffer_t *q, const void *d, unsigned int l);
+
+// ---------------------- Pop data from the chunk buffer ----------------------
+// -As popFromBuffer() on a FIFO buffer, giving back chunks as they empty
+// -The return value is the number of elements that could not be popped
+unsigned int popFromChunkBuffer(chunkbuffer_t *q, void *d, unsigned int l);
+
+#endif
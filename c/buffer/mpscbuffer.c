@@ -0,0 +1,163 @@
+//==============================================================================
+//                                mpscbuffer.c
+//------------------------------------------------------------------------------
+// Brief
+//   Implements a circular queue for many producer threads and one consumer
+//   thread
+//
+// Contents
+//   - newMpscBuffer
+//   - freeMpscBuffer
+//   - isMpscBufferEmpty
+//   - pushToMpscBuffer
+//   - popFromMpscBuffer
+//
+// Description
+//   Producers reserve space by moving head on with a compare-and-swap that
+//   is only tried while the space is free, copy their elements in and mark
+//   each one ready. The consumer walks forward from tail
+//   while elements are ready, copies that run out in one go and then moves
+//   tail past it. Tail is only ever written by the consumer, so it is a plain
+//   release store.
+//
+// Author
+//   Daniel Wilkinson-Thompson (daniel@wilkinson-thompson.com)
+//
+// Date
+//   2026-10-18
+//
+// Licence
+//   Copyright (c) 2026 Daniel Wilkinson-Thompson. All rights reserved.
+//------------------------------------------------------------------------------
+
+#ifndef MPSCBUFFER_C
+#define MPSCBUFFER_C
+
+//------------------------------------------------------------------------------
+// Headers
+//------------------------------------------------------------------------------
+#ifndef _POSIX_C_SOURCE
+#define _POSIX_C_SOURCE 200112L
+#endif
+#include "mpscbuffer.h"
+#include <stdlib.h>
+#include <string.h>
+
+//------------------------------------------------------------------------------
+// Functions
+//------------------------------------------------------------------------------
+// Generate MPSC buffer
+mpscbuffer_t* newMpscBuffer(unsigned int numberOfElements, unsigned char elementSizeInBytes) {
+
+    mpscbuffer_t *b;
+
+    // Header is cache-line aligned, so plain malloc is not enough
+    if ( posix_memalign((void**)&b, B_CACHE_LINE, sizeof(mpscbuffer_t)) ) {
+        return NULL;
+    }
+
+    b->data = calloc(numberOfElements, elementSizeInBytes);
+    b->ready = calloc(numberOfElements, sizeof(unsigned long));
+    if ( !(b->data) || !(b->ready) ) {
+        free(b->data);
+        free(b->ready);
+        free(b);
+        return NULL;
+    }
+
+    // Initialize buffer
+    b->head = 0;
+    b->tail = 0;
+    b->depth = numberOfElements;
+    b->width = elementSizeInBytes;
+    return b;
+}
+
+// Free MPSC buffer
+void freeMpscBuffer(mpscbuffer_t *b) {
+    free(b->data);
+    free(b->ready);
+    b->data = NULL;
+    b->ready = NULL;
+    free(b);
+}
+
+// MPSC buffer empty check
+unsigned char isMpscBufferEmpty(mpscbuffer_t *b) {
+    return ( __atomic_load_n(&(b->head), __ATOMIC_ACQUIRE) == __atomic_load_n(&(b->tail), __ATOMIC_ACQUIRE) );
+}
+
+// Multi-producer push
+unsigned int pushToMpscBuffer(mpscbuffer_t *b, const void *d, unsigned int l) {
+    unsigned long head, tail, count;
+    unsigned int slot, first, elementIndex;
+
+    if ( (l == 0) || (l > b->depth) ) {
+        return l;
+    }
+
+    // Reserve space, dropping the push if it doesn't fit
+    // -The compare-and-swap only fails if another producer reserved space
+    //  between the load and the swap, in which case head is reloaded and the
+    //  space checked again, so a push never waits for the consumer
+    // -The acquire load of tail makes sure the consumer has finished copying
+    //  out of our slots before we overwrite them
+    // -head may be stale by the time tail is loaded, and even behind tail, in
+    //  which case the compare-and-swap fails rather than the push
+    head = __atomic_load_n(&(b->head), __ATOMIC_RELAXED);
+    do {
+        tail = __atomic_load_n(&(b->tail), __ATOMIC_ACQUIRE);
+        if ( ((long)(head - tail) >= 0) && (head + l - tail > b->depth) ) {
+            return l;
+        }
+    } while ( !__atomic_compare_exchange_n(&(b->head), &head, head + l, 1, __ATOMIC_RELAXED, __ATOMIC_RELAXED) );
+
+    // Copy elements in, wrapping at most once
+    slot = head % b->depth;
+    first = b->depth - slot;
+    if (first > l) {
+        first = l;
+    }
+    memcpy(b->data + slot * b->width, d, first * b->width);
+    memcpy(b->data, (const unsigned char*)d + first * b->width, (l - first) * b->width);
+
+    // Publish each element
+    for (elementIndex = 0, count = head; elementIndex < l; elementIndex++, count++) {
+        __atomic_store_n(&(b->ready[count % b->depth]), count + 1, __ATOMIC_RELEASE);
+    }
+    return 0;
+}
+
+// Single-consumer pop
+unsigned int popFromMpscBuffer(mpscbuffer_t *b, void *d, unsigned int l) {
+    unsigned long tail;
+    unsigned int slot, first, n;
+
+    // Find the run of ready elements at the tail
+    // -Only the consumer writes tail, so a relaxed load is enough
+    tail = __atomic_load_n(&(b->tail), __ATOMIC_RELAXED);
+    slot = tail % b->depth;
+    for (n = 0; n < l; n++) {
+        if (__atomic_load_n(&(b->ready[slot]), __ATOMIC_ACQUIRE) != tail + n + 1) {
+            break;
+        }
+        if (++slot == b->depth) {
+            slot = 0;
+        }
+    }
+
+    // Copy the run out in bulk, wrapping at most once
+    slot = tail % b->depth;
+    first = b->depth - slot;
+    if (first > n) {
+        first = n;
+    }
+    memcpy(d, b->data + slot * b->width, first * b->width);
+    memcpy((unsigned char*)d + first * b->width, b->data, (n - first) * b->width);
+
+    // Release the space
+    __atomic_store_n(&(b->tail), tail + n, __ATOMIC_RELEASE);
+    return l - n;
+}
+
+#endif
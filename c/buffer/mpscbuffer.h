@@ -0,0 +1,115 @@
+//==============================================================================
+//                                mpscbuffer.h
+//------------------------------------------------------------------------------
+// Brief
+//   Implements a circular queue for many producer threads and one consumer
+//   thread
+//
+// Contents
+//   - newMpscBuffer
+//   - freeMpscBuffer
+//   - isMpscBufferEmpty
+//   - pushToMpscBuffer
+//   - popFromMpscBuffer
+//
+// Description
+//   Declaration
+//      mpscbuffer_t *b;
+//      b = newMpscBuffer(1024, sizeof(event_t));
+//   Adding data (from any number of threads)
+//      event_t e;
+//      pushToMpscBuffer(b, &e, 1);
+//   Getting data (from one thread)
+//      event_t events[64];
+//      unsigned int failedElements;
+//      failedElements = popFromMpscBuffer(b, &events[0], 64);
+//
+// Warnings
+//  -Behaves like a B_FIFO & B_DROP buffer: a push that does not fit when it
+//   reserves space is dropped. A push never waits for the consumer
+//  -Only one thread may pop at a time
+//  -Elements of one push stay in order, but pushes from different threads
+//   may interleave element by element
+//  -Pushes reserve space with a compare-and-swap loop, so they are lock-free,
+//   not wait-free: a push retries while other producers keep reserving space
+//   first
+//
+// Author
+//   Daniel Wilkinson-Thompson (daniel@wilkinson-thompson.com)
+//
+// Date
+//   2026-10-18
+//
+// Licence
+//   Copyright (c) 2026 Daniel Wilkinson-Thompson. All rights reserved.
+//------------------------------------------------------------------------------
+
+#ifndef MPSCBUFFER_H
+#define MPSCBUFFER_H
+
+//------------------------------------------------------------------------------
+// Headers
+//------------------------------------------------------------------------------
+#include "buffer.h"
+
+//------------------------------------------------------------------------------
+// Type definitions
+//------------------------------------------------------------------------------
+// -head counts elements reserved by producers, tail counts elements popped by
+//  the consumer. Both only ever increase; the slot of an element is its count
+//  modulo depth
+// -ready[slot] holds (count + 1) once the element with that count is written
+// -The first line only holds fields nothing writes after newMpscBuffer().
+//  head (producers) and tail (consumer) sit on their own cache lines, so
+//  producers reserving space don't keep stealing the line the consumer
+//  writes, and neither disturbs the configuration every push reads
+typedef struct B_MPSC_BUFFER {
+    unsigned char *data;
+    unsigned long *ready;
+    unsigned int depth;
+    unsigned char width;
+    unsigned long head __attribute__((aligned(B_CACHE_LINE)));
+    unsigned long tail __attribute__((aligned(B_CACHE_LINE)));
+} mpscbuffer_t;
+
+B_ASSERT_OWN_LINE(mpscbuffer_t, head, __builtin_offsetof(mpscbuffer_t, tail));
+B_ASSERT_OWN_LINE(mpscbuffer_t, tail, sizeof(mpscbuffer_t));
+
+
+//------------------------------------------------------------------------------
+// Function prototypes
+//------------------------------------------------------------------------------
+
+// ----------------------- Generate a new MPSC buffer -------------------------
+// -The created buffer is stored in the heap; free it with freeMpscBuffer()
+// -A NULL return implies that there was not enough free memory in the heap
+// -Example usage:
+//      mpscbuffer_t *b;
+//      b = newMpscBuffer(1024, sizeof(int));
+mpscbuffer_t* newMpscBuffer(unsigned int numberOfElements, unsigned char elementSizeInBytes);
+
+// -------------------------- Free the MPSC buffer ----------------------------
+// -Make sure no thread is still pushing or popping before freeing b
+void freeMpscBuffer(mpscbuffer_t *b);
+
+// ----------------- Check whether the MPSC buffer is empty -------------------
+// -A return value of 1 implies no elements are reserved or waiting to be
+//  popped
+unsigned char isMpscBufferEmpty(mpscbuffer_t *b);
+
+// ---------------------- Push data to the MPSC buffer ------------------------
+// Push l elements from memory starting at d
+// -Space is reserved with a compare-and-swap on head, then each element is
+//  published with its own ready flag
+// -The return value is the number of elements that could not be pushed, which
+//  is either zero or l
+unsigned int pushToMpscBuffer(mpscbuffer_t *b, const void *d, unsigned int l);
+
+// --------------------- Pop data from the MPSC buffer ------------------------
+// Pop up to l elements into memory starting at d
+// -Copies the run of ready elements at the tail in bulk and releases their
+//  space with one store, without any atomic read-modify-write
+// -The return value is the number of elements that could not be popped
+unsigned int popFromMpscBuffer(mpscbuffer_t *b, void *d, unsigned int l);
+
+#endif
@@ -0,0 +1,145 @@
+//==============================================================================
+//                               replaybuffer.c
+//------------------------------------------------------------------------------
+// Brief
+//   Implements a FIFO buffer that keeps what has been popped until it is
+//   committed, so the reader can seek back and read it again
+//
+// Contents
+//   - newReplayBuffer
+//   - freeReplayBuffer
+//   - isReplayBufferEmpty
+//   - pushToReplayBuffer
+//   - popFromReplayBuffer
+//   - seekReplayBuffer
+//   - commitReplayBuffer
+//
+// Description
+//   Pushes and pops work out the slot of their first element with one
+//   division and copy each side of the wrap with one memcpy(), as
+//   pushToBuffer() and popFromBuffer() do.
+//
+// Author
+//   Daniel Wilkinson-Thompson (daniel@wilkinson-thompson.com)
+//
+// Date
+//   2026-10-18
+//
+// Licence
+//   Copyright (c) 2026 Daniel Wilkinson-Thompson. All rights reserved.
+//------------------------------------------------------------------------------
+
+#ifndef REPLAYBUFFER_C
+#define REPLAYBUFFER_C
+
+//------------------------------------------------------------------------------
+// Headers
+//------------------------------------------------------------------------------
+#include "replaybuffer.h"
+#include <stdlib.h>
+#include <string.h>
+
+//------------------------------------------------------------------------------
+// Functions
+//------------------------------------------------------------------------------
+// Generate replay buffer
+replaybuffer_t* newReplayBuffer(unsigned int numberOfElements, unsigned char elementSizeInBytes) {
+    replaybuffer_t *b;
+
+    if ( (numberOfElements == 0) || (elementSizeInBytes == 0) ) {
+        return NULL;
+    }
+    b = malloc(sizeof(replaybuffer_t));
+    if ( !(b) ) {
+        return NULL;
+    }
+    b->data = calloc(numberOfElements, elementSizeInBytes);
+    if ( !(b->data) ) {
+        free(b);
+        return NULL;
+    }
+    b->depth = numberOfElements;
+    b->width = elementSizeInBytes;
+    b->head = 0;
+    b->cursor = 0;
+    b->committed = 0;
+    return b;
+}
+
+// Free replay buffer
+void freeReplayBuffer(replaybuffer_t *b) {
+    free(b->data);
+    b->data = NULL;
+    free(b);
+}
+
+// Replay buffer empty check
+unsigned char isReplayBufferEmpty(replaybuffer_t *b) {
+    return (b->cursor == b->head);
+}
+
+// Push to head
+unsigned int pushToReplayBuffer(replaybuffer_t *b, const void *d, unsigned int l) {
+    unsigned char *data = b->data;
+    const unsigned char *in = d;
+    unsigned int room, failed = 0, slot, first;
+
+    room = b->depth - (unsigned int)(b->head - b->committed);
+    if (l > room) {
+        failed = l - room;
+        l = room;
+    }
+    slot = b->head % b->depth;
+    first = b->depth - slot;
+    if (first > l) {
+        first = l;
+    }
+    memcpy(data + (unsigned long)slot * b->width, in, (unsigned long)first * b->width);
+    memcpy(data, in + (unsigned long)first * b->width, (unsigned long)(l - first) * b->width);
+    b->head += l;
+    return failed;
+}
+
+// Read from the cursor, leaving the elements retained
+unsigned int popFromReplayBuffer(replaybuffer_t *b, void *d, unsigned int l, unsigned long long *sequence) {
+    unsigned char *data = b->data, *out = d;
+    unsigned int unread, failed = 0, slot, first;
+
+    if (sequence) {
+        *sequence = b->cursor;
+    }
+    unread = b->head - b->cursor;
+    if (l > unread) {
+        failed = l - unread;
+        l = unread;
+    }
+    slot = b->cursor % b->depth;
+    first = b->depth - slot;
+    if (first > l) {
+        first = l;
+    }
+    memcpy(out, data + (unsigned long)slot * b->width, (unsigned long)first * b->width);
+    memcpy(out + (unsigned long)first * b->width, data, (unsigned long)(l - first) * b->width);
+    b->cursor += l;
+    return failed;
+}
+
+// Move the cursor
+unsigned char seekReplayBuffer(replaybuffer_t *b, unsigned long long sequence) {
+    if ( (sequence < b->committed) || (sequence > b->head) ) {
+        return 1;
+    }
+    b->cursor = sequence;
+    return 0;
+}
+
+// Give up retained elements
+unsigned char commitReplayBuffer(replaybuffer_t *b, unsigned long long sequence) {
+    if ( (sequence < b->committed) || (sequence > b->cursor) ) {
+        return 1;
+    }
+    b->committed = sequence;
+    return 0;
+}
+
+#endif
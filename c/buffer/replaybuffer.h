@@ -0,0 +1,131 @@
+//==============================================================================
+//                               replaybuffer.h
+//------------------------------------------------------------------------------
+// Brief
+//   Implements a FIFO buffer that keeps what has been popped until it is
+//   committed, so the reader can seek back and read it again
+//
+// Contents
+//   - newReplayBuffer
+//   - freeReplayBuffer
+//   - isReplayBufferEmpty
+//   - pushToReplayBuffer
+//   - popFromReplayBuffer
+//   - seekReplayBuffer
+//   - commitReplayBuffer
+//
+// Description
+//   Every element pushed gets the next sequence number, counting from 0.
+//   Popping only moves the read cursor on; the elements stay where they are
+//   until the reader commits past them, as a Kafka consumer commits its
+//   offset once what it read has been dealt with downstream. Until then the
+//   reader can seek back to any retained sequence number and read from there
+//   again, e.g. after the downstream write failed, without fetching the
+//   elements from their source.
+//      sequence:  committed ........ cursor ........ head
+//                 |-- read, retained --|-- unread --|-- free --
+//   Declaration
+//      replaybuffer_t *b;
+//      b = newReplayBuffer(4096, sizeof(event_t));
+//   Adding data
+//      pushToReplayBuffer(b, &events[0], 16);
+//   Reading and replaying
+//      unsigned long long first;
+//      n = 64 - popFromReplayBuffer(b, &batch[0], 64, &first);
+//      if (sendDownstream(&batch[0], n) == 0) {
+//          commitReplayBuffer(b, first + n);
+//      }
+//      else {
+//          seekReplayBuffer(b, b->committed);
+//      }
+//
+// Warnings
+//  -Replay buffers are not thread-safe: push, pop, seek and commit from one
+//   thread at a time
+//  -Retained elements take up room just as unread ones do, so pushes fail
+//   (as with B_DROP) once head - committed reaches the capacity. A reader
+//   that never commits stops the buffer taking new elements
+//  -Sequence numbers are 64-bit, so they never wrap in practice
+//
+// Author
+//   Daniel Wilkinson-Thompson (daniel@wilkinson-thompson.com)
+//
+// Date
+//   2026-10-18
+//
+// Licence
+//   Copyright (c) 2026 Daniel Wilkinson-Thompson. All rights reserved.
+//------------------------------------------------------------------------------
+
+#ifndef REPLAYBUFFER_H
+#define REPLAYBUFFER_H
+
+//------------------------------------------------------------------------------
+// Headers
+//------------------------------------------------------------------------------
+#include "buffer.h"
+
+//------------------------------------------------------------------------------
+// Type definitions
+//------------------------------------------------------------------------------
+// -head is the sequence number the next push gets, cursor the one the next
+//  pop reads and committed the oldest one retained. They only ever increase
+//  (cursor also moves back on a seek), committed <= cursor <= head, and the
+//  slot of an element is its sequence number modulo depth
+// -depth is the capacity; no spare slot is needed, since the counters tell a
+//  full buffer from an empty one
+typedef struct B_REPLAY_BUFFER {
+    void *data;
+    unsigned int depth;
+    unsigned char width;
+    unsigned long long head;
+    unsigned long long cursor;
+    unsigned long long committed;
+} replaybuffer_t;
+
+
+//------------------------------------------------------------------------------
+// Function prototypes
+//------------------------------------------------------------------------------
+
+// ------------------------ Generate a new replay buffer ----------------------
+// -Holds numberOfElements elements of elementSizeInBytes, retained or unread
+// -A NULL return implies there was not enough memory
+replaybuffer_t* newReplayBuffer(unsigned int numberOfElements, unsigned char elementSizeInBytes);
+
+// --------------------------- Free the replay buffer -------------------------
+void freeReplayBuffer(replaybuffer_t *b);
+
+// ------------------------ Check nothing is left to read ---------------------
+// -True when the cursor has caught up with the head, even if elements are
+//  still retained
+unsigned char isReplayBufferEmpty(replaybuffer_t *b);
+
+// ------------------------ Push data to the replay buffer --------------------
+// -As pushToBuffer() on a B_DROP buffer
+// -The return value is the number of elements that could not be pushed
+unsigned int pushToReplayBuffer(replaybuffer_t *b, const void *d, unsigned int l);
+
+// -------------------------- Read from the cursor ----------------------------
+// -Copies up to l elements from the cursor on to d and moves the cursor past
+//  them. They stay retained
+// -Sets *sequence (unless it is NULL) to the sequence number of the first
+//  element read
+// -The return value is the number of elements that could not be popped
+unsigned int popFromReplayBuffer(replaybuffer_t *b, void *d, unsigned int l, unsigned long long *sequence);
+
+// ------------------------------ Move the cursor -----------------------------
+// -Makes sequence the next one popped. Anything from committed to head will
+//  do: back to replay, forward to skip
+// -The return value is 0, or 1 if sequence is not retained or pushed yet, in
+//  which case the cursor stays put
+unsigned char seekReplayBuffer(replaybuffer_t *b, unsigned long long sequence);
+
+// ------------------------- Give up retained elements ------------------------
+// -Frees the room of every element before sequence. They can't be replayed
+//  afterwards
+// -The return value is 0, or 1 if sequence is before committed or after the
+//  cursor, in which case nothing changes
+unsigned char commitReplayBuffer(replaybuffer_t *b, unsigned long long sequence);
+
+#endif
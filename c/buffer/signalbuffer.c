@@ -0,0 +1,221 @@
+//==============================================================================
+//                               signalbuffer.c
+//------------------------------------------------------------------------------
+// Brief
+//   Implements a record buffer that signal handlers can push to safely, and
+//   that a normal thread drains
+//
+// Contents
+//   - newSignalBuffer
+//   - freeSignalBuffer
+//   - isSignalBufferEmpty
+//   - pushToSignalBuffer
+//   - popRecordFromSignalBuffer
+//   - drainSignalBuffer
+//   - copyToSignalSlots (private)
+//   - copyFromSignalSlots (private)
+//
+// Description
+//   Producers reserve room for a whole record by adding its length to used
+//   with one fetch-and-add (taking it back with another if it doesn't fit),
+//   then take its place with one fetch-and-add on head, copy the record in,
+//   and commit it by storing its count in committed[] with release ordering.
+//   Nothing is ever retried, so a push takes a bounded number of steps. The
+//   consumer only advances tail past records whose commit it has seen, and
+//   only then gives their room back to used, so records are published
+//   atomically even when a signal handler interrupts a push part-way through
+//   and pushes its own record in the meantime.
+//   Room is reserved on used rather than head because a place taken from
+//   head can't be handed back: a record that didn't fit would leave a hole
+//   the consumer can only step over if the hole's first slot is free to mark,
+//   and it need not be.
+//
+// Author
+//   Daniel Wilkinson-Thompson (daniel@wilkinson-thompson.com)
+//
+// Date
+//   2026-10-18
+//
+// Licence
+//   Copyright (c) 2026 Daniel Wilkinson-Thompson. All rights reserved.
+//------------------------------------------------------------------------------
+
+#ifndef SIGNALBUFFER_C
+#define SIGNALBUFFER_C
+
+//------------------------------------------------------------------------------
+// Headers
+//------------------------------------------------------------------------------
+#ifndef _POSIX_C_SOURCE
+#define _POSIX_C_SOURCE 200112L
+#endif
+#include "signalbuffer.h"
+#include <stdlib.h>
+#include <string.h>
+
+// Atomics used from a signal handler must never fall back to a lock
+_Static_assert( __atomic_always_lock_free(sizeof(unsigned long), 0),
+                "signalbuffer_t needs lock-free unsigned long atomics" );
+
+//------------------------------------------------------------------------------
+// Private function prototypes
+//------------------------------------------------------------------------------
+void copyToSignalSlots(signalbuffer_t *b, unsigned long count, const unsigned char *d, unsigned int l);
+void copyFromSignalSlots(signalbuffer_t *b, unsigned long count, unsigned char *d, unsigned int l);
+
+//------------------------------------------------------------------------------
+// Functions
+//------------------------------------------------------------------------------
+// Generate signal buffer
+signalbuffer_t* newSignalBuffer(unsigned int numberOfElements, unsigned char elementSizeInBytes) {
+
+    signalbuffer_t *b;
+
+    // Header is cache-line aligned, so plain malloc is not enough
+    if ( posix_memalign((void**)&b, B_CACHE_LINE, sizeof(signalbuffer_t)) ) {
+        return NULL;
+    }
+
+    // Allocate data and per-slot record markers
+    // -If any allocation fails, free everything allocated so far
+    b->data = calloc(numberOfElements, elementSizeInBytes);
+    b->committed = calloc(numberOfElements, sizeof(unsigned long));
+    b->length = calloc(numberOfElements, sizeof(unsigned int));
+    if ( !(b->data) || !(b->committed) || !(b->length) ) {
+        free(b->data);
+        free(b->committed);
+        free(b->length);
+        free(b);
+        return NULL;
+    }
+
+    // Initialize buffer
+    b->head = 0;
+    b->used = 0;
+    b->tail = 0;
+    b->depth = numberOfElements;
+    b->width = elementSizeInBytes;
+    return b;
+}
+
+// Free signal buffer
+void freeSignalBuffer(signalbuffer_t *b) {
+    free(b->data);
+    free(b->committed);
+    free(b->length);
+    b->data = NULL;
+    b->committed = NULL;
+    b->length = NULL;
+    free(b);
+}
+
+// Signal buffer empty check
+unsigned char isSignalBufferEmpty(signalbuffer_t *b) {
+    return ( __atomic_load_n(&(b->head), __ATOMIC_ACQUIRE) == __atomic_load_n(&(b->tail), __ATOMIC_ACQUIRE) );
+}
+
+// Copy l elements into the slots starting at count
+// -memcpy was only added to the async-signal-safe list in POSIX.1-2008 TC2,
+//  so copy byte by byte to stay safe on older systems
+void copyToSignalSlots(signalbuffer_t *b, unsigned long count, const unsigned char *d, unsigned int l) {
+    unsigned int slot, byteIndex, elementIndex;
+
+    slot = count % b->depth;
+    for (elementIndex = 0; elementIndex < l; elementIndex++) {
+        unsigned char *s = b->data + slot * b->width;
+        for (byteIndex = 0; byteIndex < b->width; byteIndex++) {
+            s[byteIndex] = *d++;
+        }
+        if (++slot == b->depth) {
+            slot = 0;
+        }
+    }
+}
+
+// Copy l elements out of the slots starting at count
+// -Only ever called by the consumer, so memcpy is fine here
+void copyFromSignalSlots(signalbuffer_t *b, unsigned long count, unsigned char *d, unsigned int l) {
+    unsigned int slot, first;
+
+    slot = count % b->depth;
+    first = b->depth - slot;
+    if (first > l) {
+        first = l;
+    }
+    memcpy(d, b->data + slot * b->width, first * b->width);
+    memcpy(d + first * b->width, b->data, (l - first) * b->width);
+}
+
+// Async-signal-safe push
+unsigned int pushToSignalBuffer(signalbuffer_t *b, const void *d, unsigned int l) {
+    unsigned long head;
+
+    if ( (l == 0) || (l > b->depth) ) {
+        return l;
+    }
+
+    // Reserve room for the whole record, or give it straight back
+    // -The acquire half makes sure the consumer has finished copying out of
+    //  the slots whose room it gave back before they are reused
+    // -A push that gives its room back may make another push see too little
+    //  room for a moment, so pushes can fail a little before the buffer is
+    //  full, never after
+    if (__atomic_fetch_add(&(b->used), l, __ATOMIC_ACQ_REL) + l > b->depth) {
+        __atomic_fetch_sub(&(b->used), l, __ATOMIC_RELAXED);
+        return l;
+    }
+
+    // Take the record's place
+    // -Every place taken has room reserved for it, so head never gets more
+    //  than depth ahead of tail. The acquire half orders this push after
+    //  the reservations of those that took places before it, and so after
+    //  the consumer's copies they waited for
+    head = __atomic_fetch_add(&(b->head), l, __ATOMIC_ACQ_REL);
+
+    // Fill the record, then commit it
+    // -The release store publishes the data and length to the consumer
+    copyToSignalSlots(b, head, d, l);
+    b->length[head % b->depth] = l;
+    __atomic_store_n(&(b->committed[head % b->depth]), head + 1, __ATOMIC_RELEASE);
+    return 0;
+}
+
+// Pop one committed record
+unsigned int popRecordFromSignalBuffer(signalbuffer_t *b, void *d, unsigned int l) {
+    unsigned long tail;
+    unsigned int slot, n;
+
+    // Only the consumer writes tail, so a relaxed load is enough
+    tail = __atomic_load_n(&(b->tail), __ATOMIC_RELAXED);
+    slot = tail % b->depth;
+
+    // Committed holds (count + 1) of the record that last started in this
+    // slot, so a stale record from an earlier lap can never match
+    if (__atomic_load_n(&(b->committed[slot]), __ATOMIC_ACQUIRE) != tail + 1) {
+        return 0;
+    }
+
+    // Room goes back to producers only once the copy is done
+    n = b->length[slot];
+    if (n <= l) {
+        copyFromSignalSlots(b, tail, d, n);
+        __atomic_store_n(&(b->tail), tail + n, __ATOMIC_RELEASE);
+        __atomic_fetch_sub(&(b->used), n, __ATOMIC_RELEASE);
+    }
+    return n;
+}
+
+// Drain committed records
+unsigned int drainSignalBuffer(signalbuffer_t *b, void *d, unsigned int l) {
+    unsigned int n, total = 0;
+
+    while ( (n = popRecordFromSignalBuffer(b, (unsigned char*)d + total * b->width, l - total)) ) {
+        if (n > l - total) {
+            break;
+        }
+        total += n;
+    }
+    return total;
+}
+
+#endif
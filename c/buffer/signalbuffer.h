@@ -0,0 +1,147 @@
+//==============================================================================
+//                               signalbuffer.h
+//------------------------------------------------------------------------------
+// Brief
+//   Implements a record buffer that signal handlers can push to safely, and
+//   that a normal thread drains
+//
+// Contents
+//   - newSignalBuffer
+//   - freeSignalBuffer
+//   - isSignalBufferEmpty
+//   - pushToSignalBuffer
+//   - popRecordFromSignalBuffer
+//   - drainSignalBuffer
+//
+// Description
+//   Declaration (from normal code, never from a signal handler)
+//      signalbuffer_t *b;
+//      b = newSignalBuffer(4096, sizeof(void*));
+//   Adding data (from a signal handler)
+//      void *stack[64];
+//      int frames = captureStack(&stack[0], 64);
+//      pushToSignalBuffer(b, &stack[0], frames);
+//   Getting data (from a single consumer thread)
+//      void *frames[64];
+//      unsigned int n;
+//      while ( (n = popRecordFromSignalBuffer(b, &frames[0], 64)) ) {
+//          ...
+//      }
+//
+// Warnings
+//  -Only pushToSignalBuffer is async-signal-safe. Create, drain and free the
+//   buffer from normal code
+//  -Each push is one record, which is committed as a whole. A consumer never
+//   sees part of a record, and never sees a record that was interrupted by a
+//   signal before it was committed
+//  -Pushing never waits for the consumer. If the record does not fit, it is
+//   dropped and the push reports every element as failed
+//  -Only one thread may pop/drain at a time
+//  -Pushes are wait-free: each is at most three fetch-and-adds, the copy of
+//   the record and one store, from any number of threads and signal
+//   handlers at once, with nothing retried
+//  -While a push that doesn't fit is giving its room back, another push can
+//   fail too, even if it would just have fitted. Pushes only ever fail when
+//   the buffer is full or nearly so
+//  -bench/signal.c checks pushes from a SIGALRM handler that interrupts
+//   another push
+//
+// Author
+//   Daniel Wilkinson-Thompson (daniel@wilkinson-thompson.com)
+//
+// Date
+//   2026-10-18
+//
+// Licence
+//   Copyright (c) 2026 Daniel Wilkinson-Thompson. All rights reserved.
+//------------------------------------------------------------------------------
+
+#ifndef SIGNALBUFFER_H
+#define SIGNALBUFFER_H
+
+//------------------------------------------------------------------------------
+// Headers
+//------------------------------------------------------------------------------
+#include "buffer.h"
+
+//------------------------------------------------------------------------------
+// Type definitions
+//------------------------------------------------------------------------------
+// -head counts elements placed by producers and tail counts elements
+//  released by the consumer. Both only ever increase; the slot of an element
+//  is its count modulo depth
+// -used counts the elements producers have reserved room for and the consumer
+//  has not yet released, plus, for a moment, those of pushes that didn't fit
+//  and are giving their room back. It shares head's line, since producers
+//  write both
+// -committed[slot] holds (count + 1) of the record that starts in that slot
+//  once the record is complete, and length[slot] holds its element count
+// -The first line only holds fields nothing writes after newSignalBuffer();
+//  head and used (producers) share the next, and tail (consumer) has the
+//  last to itself
+typedef struct B_SIGNAL_BUFFER {
+    unsigned char *data;
+    unsigned long *committed;
+    unsigned int *length;
+    unsigned int depth;
+    unsigned char width;
+    unsigned long head __attribute__((aligned(B_CACHE_LINE)));
+    unsigned long used;
+    unsigned long tail __attribute__((aligned(B_CACHE_LINE)));
+} signalbuffer_t;
+
+B_ASSERT_OWN_LINE(signalbuffer_t, head, __builtin_offsetof(signalbuffer_t, tail));
+B_ASSERT_OWN_LINE(signalbuffer_t, tail, sizeof(signalbuffer_t));
+
+
+//------------------------------------------------------------------------------
+// Function prototypes
+//------------------------------------------------------------------------------
+
+// ---------------------- Generate a new signal buffer ------------------------
+// -The created buffer is stored in the heap, so never call this from a signal
+//  handler. Free it with freeSignalBuffer()
+// -A NULL return implies that there was not enough free memory in the heap
+// -Example usage:
+//      signalbuffer_t *b;
+//      b = newSignalBuffer(4096, sizeof(void*));
+signalbuffer_t* newSignalBuffer(unsigned int numberOfElements, unsigned char elementSizeInBytes);
+
+// ------------------------- Free the signal buffer ---------------------------
+// -Make sure no signal handler can still push to b before freeing it
+void freeSignalBuffer(signalbuffer_t *b);
+
+// --------------- Check whether the signal buffer is empty -------------------
+// -A return value of 1 implies no records are reserved or committed
+unsigned char isSignalBufferEmpty(signalbuffer_t *b);
+
+// ------------------ Push a record to the signal buffer ----------------------
+// Push l elements from memory starting at d as one record
+// -Async-signal-safe and wait-free: no locks, no allocation, no system calls
+//  and no retries
+// -The return value is the number of elements that could not be pushed, which
+//  is either zero or l, since records are never split
+// -Example usage:
+//      unsigned int failedElements;
+//      failedElements = pushToSignalBuffer(b, &stack[0], frames);
+unsigned int pushToSignalBuffer(signalbuffer_t *b, const void *d, unsigned int l);
+
+// ---------------- Pop one record from the signal buffer ---------------------
+// Pop the oldest committed record into memory starting at d, which has room
+// for l elements
+// -The return value is the number of elements in the record
+// -A return value of zero implies no committed record is ready. A record that
+//  is still being pushed blocks the records behind it until it is committed
+// -If the return value is larger than l, nothing is copied and the record
+//  stays in the buffer
+unsigned int popRecordFromSignalBuffer(signalbuffer_t *b, void *d, unsigned int l);
+
+// ------------------- Drain records from the signal buffer -------------------
+// Pop as many whole committed records as fit into l elements of memory
+// starting at d
+// -The return value is the number of elements copied
+// -Record boundaries are lost, so use popRecordFromSignalBuffer() when they
+//  matter
+unsigned int drainSignalBuffer(signalbuffer_t *b, void *d, unsigned int l);
+
+#endif
@@ -0,0 +1,343 @@
+//==============================================================================
+//                               stackbuffer.c
+//------------------------------------------------------------------------------
+// Brief
+//   Implements a bounded stack that many threads can push to and pop from at
+//   once, using an elimination array to relieve contention on the top
+//
+// Contents
+//   - newStackBuffer
+//   - freeStackBuffer
+//   - isStackBufferEmpty
+//   - pushToStackBuffer
+//   - popFromStackBuffer
+//   - takeStackNode (private)
+//   - putStackNode (private)
+//   - offerStackElement (private)
+//   - takeOfferedStackElement (private)
+//   - pickEliminationSlot (private)
+//
+// Description
+//   A push takes a node from the spare list, copies the element into it and
+//   links it onto top; a pop unlinks a node from top, copies the element out
+//   and returns the node to the spare list. Both lists are lock-free stacks
+//   updated with a single compare-and-swap.
+//   Once a thread has seen a compare-and-swap on a list fail, its pushes
+//   first offer their element itself, copied into a random elimination
+//   slot, and wait briefly, and its pops first look in a random slot for an
+//   offered element. A pop that finds one copies it out, so the pair
+//   completes without touching top or spare at all. A push whose offer
+//   nobody takes goes back to taking a node, and its thread stops offering
+//   until it sees contention again.
+//
+// Author
+//   Daniel Wilkinson-Thompson (daniel@wilkinson-thompson.com)
+//
+// Date
+//   2026-10-18
+//
+// Licence
+//   Copyright (c) 2026 Daniel Wilkinson-Thompson. All rights reserved.
+//------------------------------------------------------------------------------
+
+#ifndef STACKBUFFER_C
+#define STACKBUFFER_C
+
+//------------------------------------------------------------------------------
+// Headers
+//------------------------------------------------------------------------------
+#ifndef _POSIX_C_SOURCE
+#define _POSIX_C_SOURCE 200112L
+#endif
+#include "stackbuffer.h"
+#include <stdlib.h>
+#include <string.h>
+
+//------------------------------------------------------------------------------
+// Constants
+//------------------------------------------------------------------------------
+// Node index meaning 'no node'
+#define B_NO_NODE      0xFFFFFFFFU
+
+// Build and split tagged list and slot words
+#define B_NODE(w)      ((unsigned int)(w))
+#define B_TAG(w)       ((w) & 0xFFFFFFFF00000000ULL)
+#define B_NEXT_TAG(w)  (B_TAG(w) + 0x100000000ULL)
+
+// Elimination slot states, in the low half of a slot word
+// -A push claims an empty slot (filling), copies its element in and offers
+//  it; a pop claims the offer (taking), copies the element out and empties
+//  the slot. Every change moves the tag on
+#define B_SLOT_EMPTY    0
+#define B_SLOT_FILLING  1
+#define B_SLOT_OFFERED  2
+#define B_SLOT_TAKING   3
+
+//------------------------------------------------------------------------------
+// Global variables
+//------------------------------------------------------------------------------
+// Set once this thread has seen a compare-and-swap on a list fail, and cleared
+// when one of its offers finds no taker
+static __thread unsigned char stackContended;
+
+//------------------------------------------------------------------------------
+// Private function prototypes
+//------------------------------------------------------------------------------
+unsigned char takeStackNode(stackbuffer_t *b, unsigned long long *list, unsigned int *node);
+unsigned char putStackNode(stackbuffer_t *b, unsigned long long *list, unsigned int node);
+unsigned char offerStackElement(stackbuffer_t *b, const unsigned char *element);
+unsigned char takeOfferedStackElement(stackbuffer_t *b, unsigned char *element);
+stackslot_t* pickEliminationSlot(stackbuffer_t *b);
+
+//------------------------------------------------------------------------------
+// Functions
+//------------------------------------------------------------------------------
+// Generate stack buffer
+stackbuffer_t* newStackBuffer(unsigned int numberOfElements, unsigned char elementSizeInBytes, unsigned int eliminationSlots) {
+
+    stackbuffer_t *b;
+    unsigned int i;
+
+    // Header is cache-line aligned, so plain malloc is not enough
+    if ( (numberOfElements == 0) || (numberOfElements >= B_NO_NODE) || posix_memalign((void**)&b, B_CACHE_LINE, sizeof(stackbuffer_t)) ) {
+        return NULL;
+    }
+
+    // Each elimination slot holds its word and room for one element, rounded
+    // up to whole cache lines
+    b->slotBytes = (sizeof(stackslot_t) + elementSizeInBytes + B_CACHE_LINE - 1) & ~(B_CACHE_LINE - 1);
+    b->data = calloc(numberOfElements, elementSizeInBytes);
+    b->next = calloc(numberOfElements, sizeof(unsigned int));
+    if ( posix_memalign((void**)&(b->elimination), B_CACHE_LINE, (eliminationSlots + 1UL) * b->slotBytes) ) {
+        b->elimination = NULL;
+    }
+    if ( !(b->data) || !(b->next) || !(b->elimination) ) {
+        free(b->data);
+        free(b->next);
+        free(b->elimination);
+        free(b);
+        return NULL;
+    }
+
+    // Every node starts on the spare list, and every elimination slot empty
+    for (i = 0; i < numberOfElements; i++) {
+        b->next[i] = (i + 1 < numberOfElements) ? i + 1 : B_NO_NODE;
+    }
+    for (i = 0; i < eliminationSlots; i++) {
+        ((stackslot_t*)((unsigned char*)b->elimination + (unsigned long)i * b->slotBytes))->state = B_SLOT_EMPTY;
+    }
+    b->top = B_NO_NODE;
+    b->spare = 0;
+    b->depth = numberOfElements;
+    b->slots = eliminationSlots;
+    b->width = elementSizeInBytes;
+    return b;
+}
+
+// Free stack buffer
+void freeStackBuffer(stackbuffer_t *b) {
+    free(b->data);
+    free(b->next);
+    free(b->elimination);
+    b->data = NULL;
+    b->next = NULL;
+    b->elimination = NULL;
+    free(b);
+}
+
+// Stack buffer empty check
+unsigned char isStackBufferEmpty(stackbuffer_t *b) {
+    return ( B_NODE(__atomic_load_n(&(b->top), __ATOMIC_ACQUIRE)) == B_NO_NODE );
+}
+
+// One attempt to unlink the first node of a list
+// -Returns 1 with the node (or B_NO_NODE if the list was empty), or 0 if
+//  another thread changed the list first
+// -next[] of a node can be rewritten by its new owner while we read it, so it
+//  is read atomically; the tag makes the compare-and-swap fail in that case
+unsigned char takeStackNode(stackbuffer_t *b, unsigned long long *list, unsigned int *node) {
+    unsigned long long old, new;
+
+    old = __atomic_load_n(list, __ATOMIC_ACQUIRE);
+    if (B_NODE(old) == B_NO_NODE) {
+        *node = B_NO_NODE;
+        return 1;
+    }
+    new = B_NEXT_TAG(old) | __atomic_load_n(&(b->next[B_NODE(old)]), __ATOMIC_RELAXED);
+    if ( __atomic_compare_exchange_n(list, &old, new, 0, __ATOMIC_ACQ_REL, __ATOMIC_RELAXED) ) {
+        *node = B_NODE(old);
+        return 1;
+    }
+    return 0;
+}
+
+// One attempt to link a node onto the front of a list
+// -Returns 1 on success, or 0 if another thread changed the list first
+// -The release ordering publishes the node's element along with it
+unsigned char putStackNode(stackbuffer_t *b, unsigned long long *list, unsigned int node) {
+    unsigned long long old;
+
+    old = __atomic_load_n(list, __ATOMIC_RELAXED);
+    __atomic_store_n(&(b->next[node]), B_NODE(old), __ATOMIC_RELAXED);
+    return __atomic_compare_exchange_n(list, &old, B_NEXT_TAG(old) | node, 0, __ATOMIC_RELEASE, __ATOMIC_RELAXED);
+}
+
+// Per-thread random slot choice
+// -A fixed slot per thread would pair the same threads up every time
+stackslot_t* pickEliminationSlot(stackbuffer_t *b) {
+    static __thread unsigned int seed;
+
+    if (seed == 0) {
+        seed = (unsigned int)(unsigned long)&seed | 1;
+    }
+    seed ^= seed << 13;
+    seed ^= seed >> 17;
+    seed ^= seed << 5;
+    return (stackslot_t*)((unsigned char*)b->elimination + (unsigned long)(seed % b->slots) * b->slotBytes);
+}
+
+// Offer an element in the elimination array
+// -Returns 1 if a pop took the element, or 0 if there was no empty slot or
+//  the offer was withdrawn
+unsigned char offerStackElement(stackbuffer_t *b, const unsigned char *element) {
+    stackslot_t *slot = pickEliminationSlot(b);
+    unsigned long long old, offer;
+    unsigned int spins;
+
+    // Claim an empty slot, then fill it and offer the element
+    // -The release store publishes the element to the pop that claims it
+    old = __atomic_load_n(&(slot->state), __ATOMIC_RELAXED);
+    if (B_NODE(old) != B_SLOT_EMPTY) {
+        return 0;
+    }
+    if ( !__atomic_compare_exchange_n(&(slot->state), &old, B_NEXT_TAG(old) | B_SLOT_FILLING, 0, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED) ) {
+        return 0;
+    }
+    memcpy(slot + 1, element, b->width);
+    offer = B_NEXT_TAG(B_NEXT_TAG(old)) | B_SLOT_OFFERED;
+    __atomic_store_n(&(slot->state), offer, __ATOMIC_RELEASE);
+
+    // A pop takes the offer by moving the slot on to taking; from then on the
+    // slot is the pop's to empty, and the push is done
+    for (spins = 0; spins < B_ELIMINATION_SPINS; spins++) {
+        if (__atomic_load_n(&(slot->state), __ATOMIC_RELAXED) != offer) {
+            return 1;
+        }
+#if defined(__x86_64__) || defined(__i386__)
+        __builtin_ia32_pause();
+#endif
+    }
+
+    // Withdraw; failing means a pop took it at the last moment
+    return !__atomic_compare_exchange_n(&(slot->state), &offer, B_NEXT_TAG(offer) | B_SLOT_EMPTY, 0, __ATOMIC_RELAXED, __ATOMIC_RELAXED);
+}
+
+// Take an element offered by a push, if there is one in a random slot
+// -Returns 1 with the element copied to element, or 0
+unsigned char takeOfferedStackElement(stackbuffer_t *b, unsigned char *element) {
+    stackslot_t *slot = pickEliminationSlot(b);
+    unsigned long long old;
+
+    old = __atomic_load_n(&(slot->state), __ATOMIC_RELAXED);
+    if (B_NODE(old) != B_SLOT_OFFERED) {
+        return 0;
+    }
+    if ( !__atomic_compare_exchange_n(&(slot->state), &old, B_NEXT_TAG(old) | B_SLOT_TAKING, 0, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED) ) {
+        return 0;
+    }
+    memcpy(element, slot + 1, b->width);
+
+    // The release store makes sure the copy is done before a push refills
+    // the slot
+    __atomic_store_n(&(slot->state), B_NEXT_TAG(B_NEXT_TAG(old)) | B_SLOT_EMPTY, __ATOMIC_RELEASE);
+    return 1;
+}
+
+// Concurrent push
+unsigned int pushToStackBuffer(stackbuffer_t *b, const void *d, unsigned int l) {
+    const unsigned char *element;
+    unsigned int elementIndex, node;
+    unsigned char eliminated;
+
+    for (elementIndex = 0; elementIndex < l; elementIndex++) {
+        element = (const unsigned char*)d + elementIndex * b->width;
+
+        // Under contention, hand the element straight to a pop if one comes
+        // along, without touching either list
+        if ( (b->slots) && (stackContended) ) {
+            if ( offerStackElement(b, element) ) {
+                continue;
+            }
+            stackContended = 0;
+        }
+
+        // Get a spare node, or give up if the stack is full, offering the
+        // element between failed attempts
+        eliminated = 0;
+        while ( !takeStackNode(b, &(b->spare), &node) ) {
+            stackContended = 1;
+            if ( (b->slots) && offerStackElement(b, element) ) {
+                eliminated = 1;
+                break;
+            }
+        }
+        if (eliminated) {
+            continue;
+        }
+        if (node == B_NO_NODE) {
+            return l - elementIndex;
+        }
+        memcpy(b->data + (unsigned long)node * b->width, element, b->width);
+
+        // Link it onto top
+        while ( !putStackNode(b, &(b->top), node) ) {
+            stackContended = 1;
+        }
+    }
+    return 0;
+}
+
+// Concurrent pop
+unsigned int popFromStackBuffer(stackbuffer_t *b, void *d, unsigned int l) {
+    unsigned char *element, eliminated;
+    unsigned int elementIndex, node;
+
+    for (elementIndex = 0; elementIndex < l; elementIndex++) {
+        element = (unsigned char*)d + elementIndex * b->width;
+
+        // Under contention, take an element a push is offering first; that
+        // pair touches neither list
+        if ( (b->slots) && (stackContended) && takeOfferedStackElement(b, element) ) {
+            continue;
+        }
+
+        // Unlink the top node, looking for offers between failed attempts
+        // and when the stack is empty
+        eliminated = 0;
+        while ( !takeStackNode(b, &(b->top), &node) ) {
+            stackContended = 1;
+            if ( (b->slots) && takeOfferedStackElement(b, element) ) {
+                eliminated = 1;
+                break;
+            }
+        }
+        if (eliminated) {
+            continue;
+        }
+        if (node == B_NO_NODE) {
+            if ( (b->slots) && takeOfferedStackElement(b, element) ) {
+                continue;
+            }
+            return l - elementIndex;
+        }
+
+        // Copy the element out, then recycle the node
+        memcpy(element, b->data + (unsigned long)node * b->width, b->width);
+        while ( !putStackNode(b, &(b->spare), node) ) {
+            stackContended = 1;
+        }
+    }
+    return 0;
+}
+
+#endif
@@ -0,0 +1,135 @@
+//==============================================================================
+//                               stackbuffer.h
+//------------------------------------------------------------------------------
+// Brief
+//   Implements a bounded stack that many threads can push to and pop from at
+//   once, using an elimination array to relieve contention on the top
+//
+// Contents
+//   - newStackBuffer
+//   - freeStackBuffer
+//   - isStackBufferEmpty
+//   - pushToStackBuffer
+//   - popFromStackBuffer
+//
+// Description
+//   Declaration
+//      stackbuffer_t *b;
+//      b = newStackBuffer(4096, sizeof(work_t), 16);
+//   Adding data (from any thread)
+//      work_t w;
+//      pushToStackBuffer(b, &w, 1);
+//   Getting data (from any thread)
+//      work_t next;
+//      if ( popFromStackBuffer(b, &next, 1) == 0 ) {
+//          ...
+//      }
+//
+// Warnings
+//  -Behaves like a B_STACK & B_DROP buffer: pushing to a full stack fails
+//  -A push of several elements pushes them one at a time, so other threads'
+//   elements may end up between them
+//  -Once a thread has seen contention on the lists, its pushes and pops try
+//   to meet in the elimination array first, where the pop copies the pushed
+//   element straight out of the slot without either touching top or spare.
+//   A thread stops trying as soon as an offer finds no taker, so an
+//   uncontended stack behaves exactly like a plain lock-free stack
+//
+// Author
+//   Daniel Wilkinson-Thompson (daniel@wilkinson-thompson.com)
+//
+// Date
+//   2026-10-18
+//
+// Licence
+//   Copyright (c) 2026 Daniel Wilkinson-Thompson. All rights reserved.
+//------------------------------------------------------------------------------
+
+#ifndef STACKBUFFER_H
+#define STACKBUFFER_H
+
+//------------------------------------------------------------------------------
+// Headers
+//------------------------------------------------------------------------------
+#include "buffer.h"
+
+//------------------------------------------------------------------------------
+// Constants
+//------------------------------------------------------------------------------
+// Number of times a push waits in the elimination array for a pop to take its
+// element before going back to the top of the stack
+#ifndef B_ELIMINATION_SPINS
+#define B_ELIMINATION_SPINS     128
+#endif
+
+
+//------------------------------------------------------------------------------
+// Type definitions
+//------------------------------------------------------------------------------
+// -Elements live in fixed nodes: data holds depth elements and next[] links
+//  each node to the one below it
+// -top and spare are lists of node indices. Each is a 64-bit word holding a
+//  32-bit index and a 32-bit tag that changes on every update, which stops a
+//  node being freed and reused between a load and a compare-and-swap from
+//  going unnoticed
+// -Each elimination slot is a state word followed by room for one element: a
+//  push copies its element in and offers it, and a pop copies it out, so an
+//  eliminated pair never touches top or spare. The word is tagged so that an
+//  offer can't be confused with a later one. Every slot is slotBytes long,
+//  rounded up to whole cache lines, so threads meeting in one slot don't slow
+//  down those meeting in another
+// -top and spare are written by every thread, so each has its own line too,
+//  away from the configuration in the first line
+typedef struct B_STACK_SLOT {
+    unsigned long long state;
+} stackslot_t;
+
+typedef struct B_STACK_BUFFER {
+    unsigned char *data;
+    unsigned int *next;
+    stackslot_t *elimination;
+    unsigned int depth;
+    unsigned int slots;
+    unsigned int slotBytes;
+    unsigned char width;
+    unsigned long long top __attribute__((aligned(B_CACHE_LINE)));
+    unsigned long long spare __attribute__((aligned(B_CACHE_LINE)));
+} stackbuffer_t;
+
+B_ASSERT_OWN_LINE(stackbuffer_t, top, __builtin_offsetof(stackbuffer_t, spare));
+B_ASSERT_OWN_LINE(stackbuffer_t, spare, sizeof(stackbuffer_t));
+
+
+//------------------------------------------------------------------------------
+// Function prototypes
+//------------------------------------------------------------------------------
+
+// ----------------------- Generate a new stack buffer ------------------------
+// -eliminationSlots sets the size of the elimination array. Around half the
+//  number of threads expected to collide works well; zero disables it
+// -The created buffer is stored in the heap; free it with freeStackBuffer()
+// -A NULL return implies that there was not enough free memory in the heap
+// -Example usage:
+//      stackbuffer_t *b;
+//      b = newStackBuffer(4096, sizeof(int), 16);
+stackbuffer_t* newStackBuffer(unsigned int numberOfElements, unsigned char elementSizeInBytes, unsigned int eliminationSlots);
+
+// -------------------------- Free the stack buffer ---------------------------
+// -Make sure no thread is still pushing or popping before freeing b
+void freeStackBuffer(stackbuffer_t *b);
+
+// ---------------- Check whether the stack buffer is empty -------------------
+// -A return value of 1 implies the stack was empty when it was checked
+unsigned char isStackBufferEmpty(stackbuffer_t *b);
+
+// ---------------------- Push data to the stack buffer -----------------------
+// Push l elements from memory starting at d, one at a time
+// -The return value is the number of elements that could not be pushed
+unsigned int pushToStackBuffer(stackbuffer_t *b, const void *d, unsigned int l);
+
+// --------------------- Pop data from the stack buffer -----------------------
+// Pop up to l elements into memory starting at d, most recent first
+// -The return value is the number of elements that could not be popped
+unsigned int popFromStackBuffer(stackbuffer_t *b, void *d, unsigned int l);
+
+#endif
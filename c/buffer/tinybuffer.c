@@ -0,0 +1,174 @@
+//==============================================================================
+//                                tinybuffer.c
+//------------------------------------------------------------------------------
+// Brief
+//   Implements a circular buffer of a few small elements in a single cache line
+//
+// Contents
+//   - initTinyBuffer
+//   - newTinyBuffer
+//   - freeTinyBuffer
+//   - isTinyBufferEmpty
+//   - isTinyBufferFull
+//   - popFromTinyBuffer
+//   - pushToTinyBuffer
+//
+// Description
+//   Elements are kept whole: a push or pop works out how many elements it can
+//   move, then copies them with at most two memcpy() calls (one each side of
+//   the wrap). Stacks pop newest first, so they copy element by element.
+//
+// Author
+//   Daniel Wilkinson-Thompson (daniel@wilkinson-thompson.com)
+//
+// Date
+//   2026-10-18
+//
+// Licence
+//   Copyright (c) 2026 Daniel Wilkinson-Thompson. All rights reserved.
+//------------------------------------------------------------------------------
+
+#ifndef TINYBUFFER_C
+#define TINYBUFFER_C
+
+//------------------------------------------------------------------------------
+// Headers
+//------------------------------------------------------------------------------
+#ifndef _POSIX_C_SOURCE
+#define _POSIX_C_SOURCE 200112L
+#endif
+#include "tinybuffer.h"
+#include <stdlib.h>
+#include <string.h>
+
+//------------------------------------------------------------------------------
+// Constants
+//------------------------------------------------------------------------------
+// Behaviour bits, i.e. those the B_FIFO and B_DROP constants clear
+#define B_TINY_STACK        ((unsigned char)~B_FIFO)
+#define B_TINY_OVERWRITE    ((unsigned char)~B_DROP)
+
+//------------------------------------------------------------------------------
+// Functions
+//------------------------------------------------------------------------------
+// Initialize tiny buffer
+unsigned char initTinyBuffer(tinybuffer_t *b, unsigned int numberOfElements, unsigned char elementSizeInBytes, unsigned char config) {
+    if ( (numberOfElements == 0) || (elementSizeInBytes == 0) ||
+         (numberOfElements > B_TINY_STORAGE / elementSizeInBytes) ) {
+        return 1;
+    }
+    b->tail = 0;
+    b->count = 0;
+    b->depth = numberOfElements;
+    b->width = elementSizeInBytes;
+    b->behavior = config;
+    return 0;
+}
+
+// Generate tiny buffer
+tinybuffer_t* newTinyBuffer(unsigned int numberOfElements, unsigned char elementSizeInBytes, unsigned char config) {
+
+    tinybuffer_t *b;
+
+    // Buffer is cache-line aligned, so plain malloc is not enough
+    if ( posix_memalign((void**)&b, B_TINY_BYTES, sizeof(tinybuffer_t)) ) {
+        return NULL;
+    }
+    if ( initTinyBuffer(b, numberOfElements, elementSizeInBytes, config) ) {
+        free(b);
+        return NULL;
+    }
+    return b;
+}
+
+// Free tiny buffer
+void freeTinyBuffer(tinybuffer_t *b) {
+    free(b);
+}
+
+// Tiny buffer empty check
+unsigned char isTinyBufferEmpty(tinybuffer_t *b) {
+    return (b->count == 0);
+}
+
+// Tiny buffer full check
+unsigned char isTinyBufferFull(tinybuffer_t *b) {
+    return (b->count == b->depth);
+}
+
+// Pop from tiny buffer
+unsigned int popFromTinyBuffer(tinybuffer_t *b, void *d, unsigned int l) {
+    unsigned char *out = d;
+    unsigned int failed = 0, elementIndex, slot, first;
+
+    if (l > b->count) {
+        failed = l - b->count;
+        l = b->count;
+    }
+
+    // FILO: walk down from the newest element
+    if (b->behavior & B_TINY_STACK) {
+        slot = (b->tail + b->count) % b->depth;
+        for (elementIndex = 0; elementIndex < l; elementIndex++) {
+            if (slot == 0) {
+                slot = b->depth;
+            }
+            slot--;
+            memcpy(out + elementIndex * b->width, b->data + slot * b->width, b->width);
+        }
+    }
+
+    // FIFO: copy up from the oldest element, wrapping at most once
+    else {
+        first = b->depth - b->tail;
+        if (first > l) {
+            first = l;
+        }
+        memcpy(out, b->data + b->tail * b->width, first * b->width);
+        memcpy(out + first * b->width, b->data, (l - first) * b->width);
+        b->tail = (b->tail + l) % b->depth;
+    }
+
+    b->count -= l;
+    return failed;
+}
+
+// Push to tiny buffer
+unsigned int pushToTinyBuffer(tinybuffer_t *b, const void *d, unsigned int l) {
+    const unsigned char *in = d;
+    unsigned int failed = 0, room = b->depth - b->count, head, first;
+
+    if (l > room) {
+
+        // Drop what doesn't fit
+        if ( !(b->behavior & B_TINY_OVERWRITE) ) {
+            failed = l - room;
+            l = room;
+        }
+
+        // Drop the oldest elements, in the buffer and then in d, until the
+        // newest ones fit
+        else {
+            if (l > b->depth) {
+                in += (l - b->depth) * b->width;
+                l = b->depth;
+            }
+            b->tail = (b->tail + l - room) % b->depth;
+            b->count -= l - room;
+        }
+    }
+
+    // Copy in after the newest element, wrapping at most once
+    head = (b->tail + b->count) % b->depth;
+    first = b->depth - head;
+    if (first > l) {
+        first = l;
+    }
+    memcpy(b->data + head * b->width, in, first * b->width);
+    memcpy(b->data, in + first * b->width, (l - first) * b->width);
+
+    b->count += l;
+    return failed;
+}
+
+#endif
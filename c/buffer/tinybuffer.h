@@ -0,0 +1,141 @@
+//==============================================================================
+//                                tinybuffer.h
+//------------------------------------------------------------------------------
+// Brief
+//   Implements a circular buffer of a few small elements in a single cache line
+//
+// Contents
+//   - initTinyBuffer
+//   - newTinyBuffer
+//   - freeTinyBuffer
+//   - isTinyBufferEmpty
+//   - isTinyBufferFull
+//   - popFromTinyBuffer
+//   - pushToTinyBuffer
+//
+// Description
+//   A tinybuffer_t is 64 bytes: 8-bit indices, the width and the behaviour,
+//   followed by the elements themselves, so there is no pointer to follow and
+//   no second allocation. It takes the same configuration constants and
+//   behaves like buffer_t, so code can switch between the two by renaming
+//   calls. Tiny buffers are meant to sit directly in arrays or larger structs,
+//   e.g. one per connection:
+//      typedef struct {
+//          int socket;
+//          tinybuffer_t pending;
+//      } connection_t;
+//      connection_t connections[4096];
+//      initTinyBuffer(&connections[i].pending, 8, sizeof(short), B_FIFO & B_DROP);
+//   Adding data
+//      short request = 7;
+//      pushToTinyBuffer(&connections[i].pending, &request, 1);
+//   Getting data
+//      short requests[8];
+//      unsigned int failedElements;
+//      failedElements = popFromTinyBuffer(&connections[i].pending, &requests[0], 8);
+//
+// Warnings
+//  -numberOfElements * elementSizeInBytes must be at most B_TINY_STORAGE
+//   bytes; initTinyBuffer() and newTinyBuffer() refuse anything bigger
+//  -Structs containing a tinybuffer_t are 64-byte aligned, so allocate them
+//   with aligned_alloc()/posix_memalign() if they go on the heap
+//  -A tinybuffer_t holds its elements inline, so copying the struct copies
+//   the buffer; it has no pointers and can be moved with memcpy
+//
+// Author
+//   Daniel Wilkinson-Thompson (daniel@wilkinson-thompson.com)
+//
+// Date
+//   2026-10-18
+//
+// Licence
+//   Copyright (c) 2026 Daniel Wilkinson-Thompson. All rights reserved.
+//------------------------------------------------------------------------------
+
+#ifndef TINYBUFFER_H
+#define TINYBUFFER_H
+
+//------------------------------------------------------------------------------
+// Headers
+//------------------------------------------------------------------------------
+#include "buffer.h"
+
+//------------------------------------------------------------------------------
+// Constants
+//------------------------------------------------------------------------------
+// Size of a tiny buffer, one cache line
+#define B_TINY_BYTES        64
+
+// Bytes left for elements after the indices, width and behaviour
+#define B_TINY_STORAGE      (B_TINY_BYTES - 5)
+
+// Most elements of a given size a tiny buffer can hold, e.g. 14 ints
+#define TINY_BUFFER_CAPACITY(elementSizeInBytes)    (B_TINY_STORAGE / (elementSizeInBytes))
+
+
+//------------------------------------------------------------------------------
+// Type definitions
+//------------------------------------------------------------------------------
+// -tail is the slot of the oldest element and count the number of elements
+//  held, so all depth slots can be used without a spare one
+// -behavior holds the config byte given to initTinyBuffer()
+typedef struct B_TINY_BUFFER {
+    unsigned char tail;
+    unsigned char count;
+    unsigned char depth;
+    unsigned char width;
+    unsigned char behavior;
+    unsigned char data[B_TINY_STORAGE];
+} __attribute__((aligned(B_TINY_BYTES))) tinybuffer_t;
+
+_Static_assert(sizeof(tinybuffer_t) == B_TINY_BYTES, "tinybuffer_t must be exactly one cache line");
+
+
+//------------------------------------------------------------------------------
+// Function prototypes
+//------------------------------------------------------------------------------
+
+// ----------------------- Initialize a tiny buffer ---------------------------
+// -Sets up b, which may live anywhere (array, struct, stack), as an empty
+//  buffer. Nothing needs to be freed afterwards
+// -A zero return implies success; 1 implies the elements don't fit
+// -config is set via a bitwise AND of the constants in buffer.h
+// -Example usage:
+//      tinybuffer_t b;
+//      if ( initTinyBuffer(&b, 8, sizeof(int), B_FIFO & B_DROP) ) return -1;
+unsigned char initTinyBuffer(tinybuffer_t *b, unsigned int numberOfElements, unsigned char elementSizeInBytes, unsigned char config);
+
+// ------------------------ Generate a new tiny buffer ------------------------
+// -Same as initTinyBuffer() on a cache-aligned heap block; free it with
+//  freeTinyBuffer()
+// -A NULL return implies the elements don't fit, or that there was not enough
+//  free memory in the heap
+tinybuffer_t* newTinyBuffer(unsigned int numberOfElements, unsigned char elementSizeInBytes, unsigned char config);
+
+// -------------------------- Free the tiny buffer ----------------------------
+// -Only for buffers from newTinyBuffer()
+void freeTinyBuffer(tinybuffer_t *b);
+
+// ----------------- Check whether the tiny buffer is empty -------------------
+// -A return value of 1 implies the buffer is empty, zero implies not empty
+unsigned char isTinyBufferEmpty(tinybuffer_t *b);
+
+// ------------------ Check whether the tiny buffer is full -------------------
+// -A return value of 1 implies the buffer is full, zero implies not full
+unsigned char isTinyBufferFull(tinybuffer_t *b);
+
+// ----------------------- Pop data from the tiny buffer ----------------------
+// Pop l elements into memory starting at d, oldest first (B_FIFO) or newest
+// first (B_STACK)
+// -The return value is the number of elements that could not be popped
+unsigned int popFromTinyBuffer(tinybuffer_t *b, void *d, unsigned int l);
+
+// ----------------------- Push data to the tiny buffer -----------------------
+// Push l elements from memory starting at d
+// -With B_DROP, elements that don't fit are not pushed; with B_OVERWRITE the
+//  oldest elements make way for them
+// -The return value is the number of elements that could not be pushed
+// -The return value is always zero using B_OVERWRITE
+unsigned int pushToTinyBuffer(tinybuffer_t *b, const void *d, unsigned int l);
+
+#endif
@@ -0,0 +1,231 @@
+//==============================================================================
+//                              waitfreebuffer.c
+//------------------------------------------------------------------------------
+// Brief
+//   Implements a circular queue whose producers finish every push in a
+//   bounded number of steps, for hard real-time threads
+//
+// Contents
+//   - newWaitFreeBuffer
+//   - freeWaitFreeBuffer
+//   - isWaitFreeBufferEmpty
+//   - pushToWaitFreeBuffer
+//   - popFromWaitFreeBuffer
+//   - popFromWaitFreeLane (private)
+//
+// Description
+//   Each producer writes to its own single-producer lane, so pushes never
+//   compete with each other and never retry. With B_DROP a lane behaves like
+//   an ordinary single-producer, single-consumer ring: the producer reads the
+//   consumer's tail once to find the free space. With B_OVERWRITE the producer
+//   doesn't read anything the consumer writes. It brackets each element with
+//   sequence stores like a seqlock, and the consumer re-reads the sequence
+//   after copying to detect elements that were overwritten under it.
+//
+// Author
+//   Daniel Wilkinson-Thompson (daniel@wilkinson-thompson.com)
+//
+// Date
+//   2026-10-18
+//
+// Licence
+//   Copyright (c) 2026 Daniel Wilkinson-Thompson. All rights reserved.
+//------------------------------------------------------------------------------
+
+#ifndef WAITFREEBUFFER_C
+#define WAITFREEBUFFER_C
+
+//------------------------------------------------------------------------------
+// Headers
+//------------------------------------------------------------------------------
+#ifndef _POSIX_C_SOURCE
+#define _POSIX_C_SOURCE 200112L
+#endif
+#include "waitfreebuffer.h"
+#include "buffer.h"
+#include <stdlib.h>
+#include <string.h>
+
+//------------------------------------------------------------------------------
+// Constants
+//------------------------------------------------------------------------------
+// Behaviour bit, i.e. the one the B_DROP constant clears
+#define B_WAITFREE_OVERWRITE    ((unsigned char)~B_DROP)
+
+//------------------------------------------------------------------------------
+// Private function prototypes
+//------------------------------------------------------------------------------
+unsigned int popFromWaitFreeLane(waitfreebuffer_t *b, unsigned int producer, unsigned char *d, unsigned int l);
+
+//------------------------------------------------------------------------------
+// Functions
+//------------------------------------------------------------------------------
+// Generate wait-free buffer
+waitfreebuffer_t* newWaitFreeBuffer(unsigned int numberOfProducers, unsigned int numberOfElements, unsigned char elementSizeInBytes, unsigned char config) {
+
+    waitfreebuffer_t *b;
+    unsigned int slots = numberOfProducers * numberOfElements;
+
+    // Header and lanes are cache-line aligned, so plain malloc is not enough
+    if ( posix_memalign((void**)&b, B_CACHE_LINE, sizeof(waitfreebuffer_t)) ) {
+        return NULL;
+    }
+
+    b->data = calloc(slots, elementSizeInBytes);
+    b->sequence = calloc(slots, sizeof(unsigned long));
+    if ( posix_memalign((void**)&(b->lanes), B_CACHE_LINE, numberOfProducers * sizeof(waitfreelane_t)) ) {
+        b->lanes = NULL;
+    }
+    if ( !(b->data) || !(b->sequence) || !(b->lanes) ) {
+        free(b->data);
+        free(b->sequence);
+        free(b->lanes);
+        free(b);
+        return NULL;
+    }
+    memset(b->lanes, 0, numberOfProducers * sizeof(waitfreelane_t));
+
+    // Initialize buffer
+    // -Only the overwrite bit of config is used, see B_OVERWRITE in buffer.h
+    b->lost = 0;
+    b->producers = numberOfProducers;
+    b->depth = numberOfElements;
+    b->nextLane = 0;
+    b->width = elementSizeInBytes;
+    b->overwrite = ( (config & B_WAITFREE_OVERWRITE) != 0 );
+    return b;
+}
+
+// Free wait-free buffer
+void freeWaitFreeBuffer(waitfreebuffer_t *b) {
+    free(b->data);
+    free(b->sequence);
+    free(b->lanes);
+    b->data = NULL;
+    b->sequence = NULL;
+    b->lanes = NULL;
+    free(b);
+}
+
+// Wait-free buffer empty check
+unsigned char isWaitFreeBufferEmpty(waitfreebuffer_t *b) {
+    unsigned int producer;
+
+    for (producer = 0; producer < b->producers; producer++) {
+        if ( __atomic_load_n(&(b->lanes[producer].head), __ATOMIC_ACQUIRE) != __atomic_load_n(&(b->lanes[producer].tail), __ATOMIC_ACQUIRE) ) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+// Wait-free push
+unsigned int pushToWaitFreeBuffer(waitfreebuffer_t *b, unsigned int producer, const void *d, unsigned int l) {
+    waitfreelane_t *lane = &(b->lanes[producer]);
+    unsigned char *lanedata = b->data + (unsigned long)producer * b->depth * b->width;
+    const unsigned char *s = d;
+    unsigned long head, count;
+    unsigned int slot, first, n;
+
+    // Only this producer writes head, so a relaxed load is enough
+    head = __atomic_load_n(&(lane->head), __ATOMIC_RELAXED);
+
+    // Drop: copy what fits in one or two pieces, then publish it
+    // -The acquire load of tail makes sure the consumer has finished copying
+    //  out of the slots before they are reused
+    if ( !(b->overwrite) ) {
+        n = b->depth - (head - __atomic_load_n(&(lane->tail), __ATOMIC_ACQUIRE));
+        if (n > l) {
+            n = l;
+        }
+        slot = head % b->depth;
+        first = b->depth - slot;
+        if (first > n) {
+            first = n;
+        }
+        memcpy(lanedata + slot * b->width, s, first * b->width);
+        memcpy(lanedata, s + first * b->width, (n - first) * b->width);
+        __atomic_store_n(&(lane->head), head + n, __ATOMIC_RELEASE);
+        return l - n;
+    }
+
+    // Overwrite: mark each slot odd while it is being written and even once
+    // it is complete, so the consumer can tell when a copy was torn
+    for (count = head; count < head + l; count++, s += b->width) {
+        unsigned long *sequence = &(b->sequence[(unsigned long)producer * b->depth + count % b->depth]);
+        __atomic_store_n(sequence, 2 * count + 1, __ATOMIC_RELAXED);
+        __atomic_thread_fence(__ATOMIC_RELEASE);
+        memcpy(lanedata + (count % b->depth) * b->width, s, b->width);
+        __atomic_store_n(sequence, 2 * count + 2, __ATOMIC_RELEASE);
+    }
+    __atomic_store_n(&(lane->head), head + l, __ATOMIC_RELEASE);
+    return 0;
+}
+
+// Pop from a single lane
+// -The return value is the number of elements popped
+unsigned int popFromWaitFreeLane(waitfreebuffer_t *b, unsigned int producer, unsigned char *d, unsigned int l) {
+    waitfreelane_t *lane = &(b->lanes[producer]);
+    unsigned char *lanedata = b->data + (unsigned long)producer * b->depth * b->width;
+    unsigned long head, tail;
+    unsigned int slot, first, n;
+
+    // Only the consumer writes tail, so a relaxed load is enough
+    tail = __atomic_load_n(&(lane->tail), __ATOMIC_RELAXED);
+    head = __atomic_load_n(&(lane->head), __ATOMIC_ACQUIRE);
+
+    // Drop: the producer never touches used slots, so copy them out directly
+    if ( !(b->overwrite) ) {
+        n = head - tail;
+        if (n > l) {
+            n = l;
+        }
+        slot = tail % b->depth;
+        first = b->depth - slot;
+        if (first > n) {
+            first = n;
+        }
+        memcpy(d, lanedata + slot * b->width, first * b->width);
+        memcpy(d + first * b->width, lanedata, (n - first) * b->width);
+        __atomic_store_n(&(lane->tail), tail + n, __ATOMIC_RELEASE);
+        return n;
+    }
+
+    // Overwrite: skip anything the producer has already lapped
+    if (head - tail > b->depth) {
+        b->lost += head - b->depth - tail;
+        tail = head - b->depth;
+    }
+
+    // Copy each element, keeping it only if its sequence didn't change
+    for (n = 0; (tail != head) && (n < l); tail++) {
+        unsigned long *sequence = &(b->sequence[(unsigned long)producer * b->depth + tail % b->depth]);
+        unsigned long before = __atomic_load_n(sequence, __ATOMIC_ACQUIRE);
+        if (before == 2 * tail + 2) {
+            memcpy(d + n * b->width, lanedata + (tail % b->depth) * b->width, b->width);
+            __atomic_thread_fence(__ATOMIC_ACQUIRE);
+            if (__atomic_load_n(sequence, __ATOMIC_RELAXED) == before) {
+                n++;
+                continue;
+            }
+        }
+        b->lost++;
+    }
+    __atomic_store_n(&(lane->tail), tail, __ATOMIC_RELEASE);
+    return n;
+}
+
+// Pop from all lanes in turn
+unsigned int popFromWaitFreeBuffer(waitfreebuffer_t *b, void *d, unsigned int l) {
+    unsigned int visited, popped = 0;
+
+    for (visited = 0; (visited < b->producers) && (popped < l); visited++) {
+        popped += popFromWaitFreeLane(b, b->nextLane, (unsigned char*)d + popped * b->width, l - popped);
+        if (++(b->nextLane) == b->producers) {
+            b->nextLane = 0;
+        }
+    }
+    return l - popped;
+}
+
+#endif
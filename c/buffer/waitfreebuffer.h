@@ -0,0 +1,128 @@
+//==============================================================================
+//                              waitfreebuffer.h
+//------------------------------------------------------------------------------
+// Brief
+//   Implements a circular queue whose producers finish every push in a
+//   bounded number of steps, for hard real-time threads
+//
+// Contents
+//   - newWaitFreeBuffer
+//   - freeWaitFreeBuffer
+//   - isWaitFreeBufferEmpty
+//   - pushToWaitFreeBuffer
+//   - popFromWaitFreeBuffer
+//
+// Description
+//   Declaration
+//      waitfreebuffer_t *b;
+//      b = newWaitFreeBuffer(4, 256, sizeof(sample_t), B_OVERWRITE);
+//   Adding data (producer number p, from one thread only)
+//      sample_t s;
+//      pushToWaitFreeBuffer(b, p, &s, 1);
+//   Getting data (from one thread)
+//      sample_t samples[32];
+//      unsigned int failedElements;
+//      failedElements = popFromWaitFreeBuffer(b, &samples[0], 32);
+//
+// Warnings
+//  -Each producer owns one lane of numberOfElements slots. Producer numbers
+//   run from 0 to numberOfProducers - 1, and each one may only be used by one
+//   thread at a time
+//  -Only one thread may pop at a time. Elements from one producer are popped
+//   in order, but elements from different producers are not
+//  -With B_DROP, elements that don't fit in the producer's lane are dropped
+//  -With B_OVERWRITE, the producer never looks at the consumer at all and the
+//   oldest elements in its lane are overwritten. The consumer validates each
+//   slot's sequence number and counts overwritten elements in 'lost' instead
+//   of returning torn data
+//  -Configure with B_DROP or B_OVERWRITE only; the buffer is always a queue
+//
+// Author
+//   Daniel Wilkinson-Thompson (daniel@wilkinson-thompson.com)
+//
+// Date
+//   2026-10-18
+//
+// Licence
+//   Copyright (c) 2026 Daniel Wilkinson-Thompson. All rights reserved.
+//------------------------------------------------------------------------------
+
+#ifndef WAITFREEBUFFER_H
+#define WAITFREEBUFFER_H
+
+//------------------------------------------------------------------------------
+// Headers
+//------------------------------------------------------------------------------
+#include "buffer.h"
+
+//------------------------------------------------------------------------------
+// Type definitions
+//------------------------------------------------------------------------------
+// -head counts elements pushed to a lane and tail counts elements the
+//  consumer has finished with. Both only ever increase; the slot of an
+//  element is its count modulo depth
+// -Each lane's head and tail sit on their own cache lines
+typedef struct B_WAIT_FREE_LANE {
+    unsigned long head __attribute__((aligned(B_CACHE_LINE)));
+    unsigned long tail __attribute__((aligned(B_CACHE_LINE)));
+} waitfreelane_t;
+
+B_ASSERT_OWN_LINE(waitfreelane_t, head, __builtin_offsetof(waitfreelane_t, tail));
+B_ASSERT_OWN_LINE(waitfreelane_t, tail, sizeof(waitfreelane_t));
+
+// -sequence[slot] is (2 * count + 1) while an element is being overwritten and
+//  (2 * count + 2) once it is complete; it is only used with B_OVERWRITE
+// -lost counts elements that were overwritten before they could be popped
+// -The first line only holds fields nothing writes after newWaitFreeBuffer(),
+//  which every push reads. lost and nextLane are only written by the
+//  consumer, so they sit on a line of their own
+typedef struct B_WAIT_FREE_BUFFER {
+    unsigned char *data;
+    unsigned long *sequence;
+    waitfreelane_t *lanes;
+    unsigned int producers;
+    unsigned int depth;
+    unsigned char width;
+    unsigned char overwrite;
+    unsigned long lost __attribute__((aligned(B_CACHE_LINE)));
+    unsigned int nextLane;
+} waitfreebuffer_t;
+
+B_ASSERT_OWN_LINE(waitfreebuffer_t, lost, sizeof(waitfreebuffer_t));
+
+
+//------------------------------------------------------------------------------
+// Function prototypes
+//------------------------------------------------------------------------------
+
+// -------------------- Generate a new wait-free buffer -----------------------
+// -Allocates numberOfElements slots for each of numberOfProducers lanes
+// -The created buffer is stored in the heap; free it with freeWaitFreeBuffer()
+// -A NULL return implies that there was not enough free memory in the heap
+// -Example usage:
+//      waitfreebuffer_t *b;
+//      b = newWaitFreeBuffer(4, 256, sizeof(int), B_DROP);
+waitfreebuffer_t* newWaitFreeBuffer(unsigned int numberOfProducers, unsigned int numberOfElements, unsigned char elementSizeInBytes, unsigned char config);
+
+// ----------------------- Free the wait-free buffer --------------------------
+// -Make sure no thread is still pushing or popping before freeing b
+void freeWaitFreeBuffer(waitfreebuffer_t *b);
+
+// --------------- Check whether the wait-free buffer is empty ----------------
+// -A return value of 1 implies every lane is empty
+unsigned char isWaitFreeBufferEmpty(waitfreebuffer_t *b);
+
+// -------------------- Push data to the wait-free buffer ---------------------
+// Push l elements from memory starting at d into the lane of producer
+// -Never loops on shared state: the cost is one load, a copy of at most l
+//  elements and one store (plus two stores per element with B_OVERWRITE)
+// -The return value is the number of elements that could not be pushed, which
+//  is always zero with B_OVERWRITE
+unsigned int pushToWaitFreeBuffer(waitfreebuffer_t *b, unsigned int producer, const void *d, unsigned int l);
+
+// -------------------- Pop data from the wait-free buffer --------------------
+// Pop up to l elements into memory starting at d, visiting lanes in turn
+// -The return value is the number of elements that could not be popped
+unsigned int popFromWaitFreeBuffer(waitfreebuffer_t *b, void *d, unsigned int l);
+
+#endif